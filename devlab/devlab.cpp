@@ -7,6 +7,7 @@
 #include <variant>
 #include <vector>
 
+#include "zx/array_expr.hpp"
 #include "zx/format.hpp"
 #include "zx/functional.hpp"
 #include "zx/image.hpp"
@@ -134,18 +135,6 @@ struct perlin_fn
 
 static constexpr inline perlin_fn perlin = {};
 
-template <class In, class Out>
-struct interpolate_fn
-{
-    std::pair<In, In> m_in;
-    std::pair<Out, Out> m_out;
-
-    auto operator()(In value) const -> Out
-    {
-        return m_out.first + (m_out.second - m_out.first) * (value - m_in.first) / (m_in.second - m_in.first);
-    }
-};
-
 // cmake --build --preset ninja-release && ./build/ninja-release/devlab/zx_devlab && wslview ~/out.bmp
 void run(const std::vector<std::string_view>&)
 {
@@ -170,18 +159,8 @@ void run(const std::vector<std::string_view>&)
         mat::detail::for_each(
             result.shape(),
             [&](const mat::location_t<2>& loc) { result[loc] = perlin(loc.to<float>() / 20.F, get_permutation); });
-        float min_value = std::numeric_limits<float>::max();
-        float max_value = std::numeric_limits<float>::lowest();
-        for (auto v : result)
-        {
-            min_value = std::min(min_value, v);
-            max_value = std::max(max_value, v);
-        }
-        const auto f = interpolate_fn<float, float>{ { min_value, max_value }, { 0.F, 255.F } };
-        for (auto& v : result)
-        {
-            v = f(v);
-        }
+        const auto [min_value, max_value] = mat::reduce::minmax(result);
+        mat::assign(result, (result - min_value) * (255.F / (max_value - min_value)));
         mat::rgb_image_t res(extent);
         mat::detail::for_each(
             res.data().shape(),
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <zx/interop.hpp>
+
+#include "../tests/random_image.hpp"
+
+namespace zx::bench
+{
+
+static mat::rgb_image_t make_bitmap_image()
+{
+    return random_image(mat::rgb_image_t::extent_type{ 2160, 3841 }, 1);
+}
+
+static void BM_Bitmap_Save(benchmark::State& state)
+{
+    const mat::rgb_image_t image = make_bitmap_image();
+    for (auto _ : state)
+    {
+        std::stringstream ss;
+        mat::save_bitmap(image, ss);
+        benchmark::DoNotOptimize(ss);
+    }
+}
+
+static void BM_Bitmap_Load(benchmark::State& state)
+{
+    std::stringstream encoded;
+    mat::save_bitmap(make_bitmap_image(), encoded);
+    const std::string data = encoded.str();
+    for (auto _ : state)
+    {
+        std::stringstream ss{ data };
+        benchmark::DoNotOptimize(mat::load_bitmap(ss));
+    }
+}
+
+static void BM_Bitmap_LoadRows(benchmark::State& state)
+{
+    std::stringstream encoded;
+    mat::save_bitmap(make_bitmap_image(), encoded);
+    const std::string data = encoded.str();
+    for (auto _ : state)
+    {
+        std::stringstream ss{ data };
+        std::uint64_t sum = 0;
+        mat::load_bitmap_rows(
+            ss, [&](mat::location_base_t, const mat::rgb_image_t::view_type& row) { sum += row[{ 0, 0 }][0]; });
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+static const mat::filepath_t& bitmap_file()
+{
+    static const mat::filepath_t path = []()
+    {
+        mat::filepath_t result{ "/tmp/zx_bitmap_bench.bmp" };
+        mat::save_bitmap(make_bitmap_image(), result);
+        return result;
+    }();
+    return path;
+}
+
+static void BM_Bitmap_LoadFile(benchmark::State& state)
+{
+    const mat::filepath_t& path = bitmap_file();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::load_bitmap(path));
+    }
+}
+
+static void BM_Bitmap_MapFile(benchmark::State& state)
+{
+    const mat::filepath_t& path = bitmap_file();
+    for (auto _ : state)
+    {
+        const mat::mapped_bitmap_t mapped = mat::map_bitmap(path);
+        benchmark::DoNotOptimize(mapped.view()[{ 0, 0 }]);
+    }
+}
+
+BENCHMARK(BM_Bitmap_Save)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Bitmap_Load)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Bitmap_LoadRows)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Bitmap_LoadFile)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Bitmap_MapFile)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace zx::bench
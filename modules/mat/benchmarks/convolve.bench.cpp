@@ -0,0 +1,234 @@
+#include <benchmark/benchmark.h>
+
+#include <zx/image.hpp>
+
+#include "../tests/random_image.hpp"
+
+namespace zx::bench
+{
+
+static mat::rgb_image_t make_4k_image()
+{
+    return random_image(mat::rgb_image_t::extent_type{ 2160, 3840 }, 1);
+}
+
+static const mat::rgb_image_t& source_image()
+{
+    static const mat::rgb_image_t image = make_4k_image();
+    return image;
+}
+
+template <class Kernel>
+static void run_convolve(benchmark::State& state, const Kernel& kernel, const mat::execution_t& policy = {})
+{
+    const mat::rgb_image_t& src = source_image();
+    mat::rgb_image_t dst{ src.extent() };
+    for (auto _ : state)
+    {
+        mat::convolve(policy, dst.mut_view(), src, kernel);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Gaussian_Separable(benchmark::State& state)
+{
+    const auto size = static_cast<mat::location_base_t>(state.range(0));
+    run_convolve(state, mat::kernel::gaussian(static_cast<float>(size) / 6.F, size));
+}
+
+static void BM_Gaussian_Dense(benchmark::State& state)
+{
+    const auto size = static_cast<mat::location_base_t>(state.range(0));
+    auto kernel = mat::kernel::gaussian(static_cast<float>(size) / 6.F, size);
+    kernel.m_separable = {};
+    run_convolve(state, kernel);
+}
+
+static void BM_Gaussian_Parallel(benchmark::State& state)
+{
+    run_convolve(state, mat::kernel::gaussian(2.F, 11), mat::execution::parallel(static_cast<std::size_t>(state.range(0))));
+}
+
+static void BM_Sobel_Separable(benchmark::State& state) { run_convolve(state, mat::kernel::sobel()); }
+
+static void BM_Sobel_Dense(benchmark::State& state)
+{
+    auto kernel = mat::kernel::sobel();
+    kernel.m_separable = {};
+    run_convolve(state, kernel);
+}
+
+static void BM_Sharpen_FixedPoint(benchmark::State& state) { run_convolve(state, mat::kernel::sharpen()); }
+
+static void BM_Sharpen_Float(benchmark::State& state)
+{
+    auto kernel = mat::kernel::sharpen();
+    kernel.m_precision = mat::kernel_precision_t::exact;
+    run_convolve(state, kernel);
+}
+
+static void BM_Blur_FixedPoint(benchmark::State& state)
+{
+    auto kernel = mat::kernel::blur();
+    kernel.m_separable = {};
+    run_convolve(state, kernel);
+}
+
+static void BM_Blur_Separable(benchmark::State& state) { run_convolve(state, mat::kernel::blur()); }
+
+static void BM_Dilate_Circle(benchmark::State& state)
+{
+    run_convolve(state, mat::kernel::dilate(mat::mask::circle(5)));
+}
+
+static void BM_Erode_Circle(benchmark::State& state) { run_convolve(state, mat::kernel::erode(mat::mask::circle(5))); }
+
+static void BM_Dilate_Square(benchmark::State& state)
+{
+    run_convolve(state, mat::kernel::dilate(mat::mask::square(static_cast<mat::extent_base_t>(state.range(0)))));
+}
+
+static void BM_Opening_Square(benchmark::State& state)
+{
+    run_convolve(state, mat::kernel::opening(mat::mask::square(static_cast<mat::extent_base_t>(state.range(0)))));
+}
+
+static void BM_Median_Histogram(benchmark::State& state)
+{
+    run_convolve(state, mat::kernel::median(mat::mask::square(static_cast<mat::extent_base_t>(state.range(0)))));
+}
+
+static void BM_Median_Select(benchmark::State& state)
+{
+    auto kernel = mat::kernel::median(mat::mask::square(static_cast<mat::extent_base_t>(state.range(0))));
+    kernel.m_uniform_weight = {};
+    run_convolve(state, kernel);
+}
+
+static mat::detail::apply_kernel_t<1> disk_average(mat::extent_base_t size, mat::convolution_method_t method)
+{
+    mat::mask_t mask = mat::mask::circle(size);
+    const float sum = std::accumulate(mask.m_data.begin(), mask.m_data.end(), 0.F);
+    for (float& value : mask.m_data)
+    {
+        value /= sum;
+    }
+    mat::detail::apply_kernel_t<1> kernel{ std::move(mask) };
+    kernel.m_method = method;
+    return kernel;
+}
+
+static void BM_Disk_Direct(benchmark::State& state)
+{
+    run_convolve(
+        state, disk_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::direct));
+}
+
+static void BM_Disk_FFT(benchmark::State& state)
+{
+    run_convolve(state, disk_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::fft));
+}
+
+static void BM_Disk_Automatic(benchmark::State& state)
+{
+    run_convolve(
+        state, disk_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::automatic));
+}
+
+static void BM_Gaussian_FFT(benchmark::State& state)
+{
+    const auto size = static_cast<mat::location_base_t>(state.range(0));
+    auto kernel = mat::kernel::gaussian(static_cast<float>(size) / 6.F, size);
+    kernel.m_method = mat::convolution_method_t::fft;
+    run_convolve(state, kernel);
+}
+
+static mat::detail::apply_kernel_t<1> box_average(mat::extent_base_t size, mat::convolution_method_t method)
+{
+    auto kernel = mat::kernel::box({ size, size });
+    kernel.m_method = method;
+    return kernel;
+}
+
+static void BM_Box_Integral(benchmark::State& state)
+{
+    run_convolve(
+        state, box_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::integral));
+}
+
+static void BM_Box_Separable(benchmark::State& state)
+{
+    run_convolve(
+        state, box_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::separable));
+}
+
+static void BM_Box_Direct(benchmark::State& state)
+{
+    run_convolve(
+        state, box_average(static_cast<mat::extent_base_t>(state.range(0)), mat::convolution_method_t::direct));
+}
+
+static void BM_Integral(benchmark::State& state)
+{
+    const mat::rgb_image_t& src = source_image();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::integral(src));
+    }
+}
+
+// a 64 x 64 overlay moving over a 4K frame
+static void BM_Gaussian_Dirty(benchmark::State& state)
+{
+    const mat::rgb_image_t& src = source_image();
+    mat::rgb_image_t dst{ src.extent() };
+    const auto kernel = mat::kernel::gaussian(2.F, 11);
+    mat::dirty_region_t dirty{ src.extent() };
+    mat::location_base_t frame = 0;
+    for (auto _ : state)
+    {
+        dirty.clear();
+        const mat::location_base_t y = frame * 37 % 2000;
+        const mat::location_base_t x = frame * 91 % 3700;
+        dirty.add(mat::bounds_t<2>{ { y, y + 64 }, { x, x + 64 } });
+        mat::convolve(mat::execution::sequential(), dst.mut_view(), src, kernel, mat::border::reflect(), dirty);
+        benchmark::ClobberMemory();
+        ++frame;
+    }
+}
+
+BENCHMARK(BM_Gaussian_Separable)->DenseRange(3, 31, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Gaussian_Dense)->DenseRange(3, 31, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Gaussian_Dirty)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Gaussian_Parallel)->RangeMultiplier(2)->Range(1, 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Sobel_Separable)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Sobel_Dense)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Sharpen_FixedPoint)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Sharpen_Float)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Blur_FixedPoint)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Blur_Separable)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Disk_Direct)->Arg(7)->Arg(15)->Arg(31)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Disk_FFT)->Arg(7)->Arg(15)->Arg(31)->Arg(63)->Arg(127)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Disk_Automatic)->Arg(7)->Arg(31)->Arg(127)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Gaussian_FFT)->Arg(31)->Arg(63)->Arg(127)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Box_Integral)->Arg(3)->Arg(5)->Arg(15)->Arg(63)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Box_Separable)->Arg(3)->Arg(5)->Arg(15)->Arg(63)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Box_Direct)->Arg(3)->Arg(5)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Integral)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK(BM_Dilate_Circle)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Erode_Circle)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Dilate_Square)->Arg(3)->Arg(9)->Arg(31)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Opening_Square)->Arg(3)->Arg(31)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Median_Histogram)->Arg(3)->Arg(9)->Arg(31)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Median_Select)->Arg(3)->Arg(9)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace zx::bench
+
+BENCHMARK_MAIN();
@@ -0,0 +1,213 @@
+#include <benchmark/benchmark.h>
+
+#include <zx/image.hpp>
+
+#include "../tests/random_image.hpp"
+
+namespace zx::bench
+{
+
+static mat::rgb_image_t make_filter_image(std::uint32_t seed)
+{
+    return random_image(mat::rgb_image_t::extent_type{ 2160, 3840 }, seed);
+}
+
+template <class Filter>
+static void run_modify(benchmark::State& state, const Filter& filter)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    for (auto _ : state)
+    {
+        mat::modify(image.mut_view(), filter);
+        benchmark::ClobberMemory();
+    }
+}
+
+template <class Filter>
+static void run_paste(benchmark::State& state, const Filter& filter)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const mat::rgb_image_t overlay = make_filter_image(2);
+    for (auto _ : state)
+    {
+        mat::paste(image.mut_view(), overlay, { 0, 0 }, filter);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Sepia_Span(benchmark::State& state) { run_modify(state, mat::filters::sepia); }
+
+static void BM_Sepia_PerPixel(benchmark::State& state)
+{
+    run_modify(state, mat::detail::color_filter_t{ mat::filters::sepia });
+}
+
+static void BM_Gray_Span(benchmark::State& state) { run_modify(state, mat::filters::gray); }
+
+static void BM_Multiply_Span(benchmark::State& state) { run_paste(state, mat::filters::multiply); }
+
+static void BM_Multiply_PerPixel(benchmark::State& state)
+{
+    run_paste(state, mat::detail::binary_color_filter_t{ mat::filters::multiply });
+}
+
+static void BM_Overlay_Span(benchmark::State& state) { run_paste(state, mat::filters::overlay); }
+
+static void BM_Blend_Span(benchmark::State& state) { run_paste(state, mat::filters::blend(0.3F)); }
+
+static void BM_Blend_PerPixel(benchmark::State& state)
+{
+    run_paste(state, mat::detail::binary_color_filter_t{ mat::filters::blend(0.3F) });
+}
+
+static void BM_Chain_Sequential(benchmark::State& state)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const auto table = mat::lookup_table::contrast(0.25F) * mat::lookup_table::brightness(-64.F);
+    for (auto _ : state)
+    {
+        mat::modify(image.mut_view(), mat::filters::sepia);
+        mat::modify(image.mut_view(), mat::filters::gray);
+        mat::modify(image.mut_view(), table);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Chain_Pipeline(benchmark::State& state)
+{
+    run_modify(
+        state,
+        mat::color_pipeline(
+            mat::filters::sepia,
+            mat::filters::gray,
+            mat::lookup_table::contrast(0.25F),
+            mat::lookup_table::brightness(-64.F)));
+}
+
+static void BM_Chain_Cube(benchmark::State& state)
+{
+    run_modify(
+        state,
+        mat::color_cube_t::create(mat::color_pipeline(
+            mat::filters::sepia,
+            mat::filters::gray,
+            mat::lookup_table::contrast(0.25F),
+            mat::lookup_table::brightness(-64.F))));
+}
+
+static void BM_Curves_Float(benchmark::State& state)
+{
+    const mat::lookup_table_t table = mat::lookup_table::gamma(1.8F);
+    run_modify(state, mat::detail::color_filter_t{ table });
+}
+
+static void BM_Curves_Bytes(benchmark::State& state)
+{
+    run_modify(
+        state,
+        mat::byte_lookup_table_t{ mat::lookup_table::gamma(1.8F),
+                                  mat::lookup_table::contrast(1.2F),
+                                  mat::lookup_table::brightness(10.F) });
+}
+
+static void BM_Fill_Circle_Span(benchmark::State& state)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const auto fill = mat::filters::solid(mat::rgb_color_t{ 255.F, 128.F, 0.F }, 0.5F);
+    for (auto _ : state)
+    {
+        mat::fill(image.mut_view(), mat::circle_type{ { 1080, 1920 }, 1000 }, fill);
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Fill_Circle_PerPixel(benchmark::State& state)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const auto fill = mat::detail::color_filter_t{ mat::filters::solid(mat::rgb_color_t{ 255.F, 128.F, 0.F }, 0.5F) };
+    for (auto _ : state)
+    {
+        const auto do_draw = mat::detail::draw_pixel_t{ image.mut_view(), fill };
+        for (const auto& shape : mat::rasterize(mat::circle_type{ { 1080, 1920 }, 1000 }))
+        {
+            mat::draw_raster(shape, do_draw);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+// thousands of segments, many of them reaching far outside the image
+static std::vector<mat::segment_type> make_overlay_segments()
+{
+    std::vector<mat::segment_type> result;
+    std::uint32_t state = 3;
+    const auto random = [&](int lower, int upper)
+    {
+        state = state * 1664525U + 1013904223U;
+        return lower + static_cast<int>((state >> 8) % static_cast<std::uint32_t>(upper - lower + 1));
+    };
+    for (int i = 0; i < 5000; ++i)
+    {
+        result.push_back(mat::segment_type{ { random(-2000, 4000), random(-2000, 6000) },
+                                            { random(-2000, 4000), random(-2000, 6000) } });
+    }
+    return result;
+}
+
+static void run_overlay(benchmark::State& state, const mat::stroke_t& pen)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const auto segments = make_overlay_segments();
+    const auto color = mat::filters::solid(mat::rgb_color_t{ 0.F, 255.F, 0.F });
+    for (auto _ : state)
+    {
+        for (const auto& seg : segments)
+        {
+            mat::draw_line(image.mut_view(), seg, color, pen);
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Overlay_Lines_Runs(benchmark::State& state) { run_overlay(state, mat::stroke::solid()); }
+
+static void BM_Overlay_Lines_PerPixel(benchmark::State& state)
+{
+    mat::rgb_image_t image = make_filter_image(1);
+    const auto segments = make_overlay_segments();
+    const auto color = mat::detail::color_filter_t{ mat::filters::solid(mat::rgb_color_t{ 0.F, 255.F, 0.F }) };
+    for (auto _ : state)
+    {
+        for (const auto& seg : segments)
+        {
+            mat::draw_line(seg[0], seg[1], mat::detail::draw_pixel_t{ image.mut_view(), color });
+        }
+        benchmark::ClobberMemory();
+    }
+}
+
+static void BM_Overlay_Lines_Smooth(benchmark::State& state) { run_overlay(state, mat::stroke::smooth()); }
+
+static void BM_Overlay_Lines_Thick(benchmark::State& state) { run_overlay(state, mat::stroke::smooth(4.F)); }
+
+BENCHMARK(BM_Sepia_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Sepia_PerPixel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Gray_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Multiply_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Multiply_PerPixel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Overlay_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Blend_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Blend_PerPixel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Chain_Sequential)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Chain_Pipeline)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Chain_Cube)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Curves_Float)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Curves_Bytes)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Fill_Circle_Span)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Fill_Circle_PerPixel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Overlay_Lines_Runs)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Overlay_Lines_PerPixel)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Overlay_Lines_Smooth)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Overlay_Lines_Thick)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace zx::bench
@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+
+#include <zx/image.hpp>
+
+#include "../tests/random_image.hpp"
+
+namespace zx::bench
+{
+
+static mat::rgb_image_t make_warp_image()
+{
+    return random_image(mat::rgb_image_t::extent_type{ 1080, 1920 }, 1);
+}
+
+static void BM_Rotate(benchmark::State& state)
+{
+    const mat::rgb_image_t image = make_warp_image();
+    const auto interpolation = static_cast<mat::interpolation_t>(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::rotate(image.view(), 30.F, interpolation));
+    }
+    state.SetLabel(str(interpolation));
+}
+
+static void BM_Resize(benchmark::State& state)
+{
+    const mat::rgb_image_t image = make_warp_image();
+    const auto filter = static_cast<mat::resize_filter_t>(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::resize(image.view(), { 720, 1280 }, filter));
+    }
+    state.SetLabel(str(filter));
+}
+
+static void BM_Pyramid(benchmark::State& state)
+{
+    const mat::rgb_image_t image = make_warp_image();
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::pyramid(image.view(), 4));
+    }
+}
+
+static void BM_Materialize_Rotated(benchmark::State& state)
+{
+    const mat::rgb_image_t image = make_warp_image();
+    const mat::rgb_image_t planar{ image.view(), mat::image_layout_t::planar };
+    const mat::rgb_image_t& source = state.range(0) == 0 ? image : planar;
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(mat::materialize(mat::rotate(source.view(), 90)));
+    }
+    state.SetLabel(str(source.layout()));
+}
+
+BENCHMARK(BM_Rotate)->DenseRange(0, 2)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Resize)->DenseRange(0, 2)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Pyramid)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Materialize_Rotated)->DenseRange(0, 1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+}  // namespace zx::bench
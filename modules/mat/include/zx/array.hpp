@@ -215,6 +215,22 @@ struct shape_t : md_base_t<D, dim_t, shape_t>
         return result;
     }
 
+    // order lists the dimensions from the outermost to the innermost in memory
+    static shape_t from_extent(
+        const extent_type& extent, extent_base_t element_size, const std::array<std::size_t, D>& order)
+    {
+        shape_t result;
+        stride_base_t stride = element_size;
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            auto& dim = result[*it];
+            dim.extent = extent[*it];
+            dim.stride = stride;
+            stride *= dim.extent;
+        }
+        return result;
+    }
+
     std::pair<shape_t, location_type> slice(const slice_type& s) const
     {
         shape_t new_shape = *this;
@@ -622,6 +638,13 @@ struct array_t
     {
     }
 
+    template <std::size_t D_ = D, enable_if_t<(D_ > 1)> = 0>
+    array_t(const extent_type extent, const std::array<std::size_t, D>& order, const T& init = {})
+        : m_shape{ shape_type::from_extent(extent, sizeof(T), order) }
+        , m_data(static_cast<std::size_t>(m_shape.volume()), init)
+    {
+    }
+
     template <std::size_t D_ = D, enable_if_t<(D_ == 1)> = 0>
     explicit array_t(std::vector<T> init)
         : m_shape{ shape_type::from_extent(extent_type{ static_cast<extent_base_t>(init.extent()) }, sizeof(T)) }
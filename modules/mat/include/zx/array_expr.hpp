@@ -0,0 +1,955 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <zx/array.hpp>
+#include <zx/parallel.hpp>
+#include <zx/simd.hpp>
+
+namespace zx
+{
+namespace mat
+{
+
+template <class Op, class... Args>
+struct array_expr_t;
+
+namespace detail
+{
+
+template <std::size_t D>
+using row_location_t = std::array<location_base_t, D>;
+
+template <std::size_t D>
+using expr_extent_t = std::array<extent_base_t, D>;
+
+template <std::size_t D>
+auto to_extent_type(const expr_extent_t<D>& extent) -> typename shape_t<D>::extent_type
+{
+    if constexpr (D == 1)
+    {
+        return extent[0];
+    }
+    else
+    {
+        typename shape_t<D>::extent_type result = {};
+        std::copy(extent.begin(), extent.end(), result.begin());
+        return result;
+    }
+}
+
+template <std::size_t D>
+auto from_extent_type(const typename shape_t<D>::extent_type& extent) -> expr_extent_t<D>
+{
+    if constexpr (D == 1)
+    {
+        return { extent };
+    }
+    else
+    {
+        expr_extent_t<D> result = {};
+        std::copy(extent.begin(), extent.end(), result.begin());
+        return result;
+    }
+}
+
+template <class T, bool Contiguous>
+struct view_row_t
+{
+    const T* m_data;
+    stride_base_t m_stride;
+
+    T operator()(location_base_t x) const
+    {
+        if constexpr (Contiguous)
+        {
+            return m_data[x];
+        }
+        else
+        {
+            return *to_ptr<const T*>(to_byte_ptr(m_data), flat_offset_t{ x } * m_stride);
+        }
+    }
+};
+
+// rows read directly from memory with unit stride, eligible for the simd kernels
+template <class Row>
+struct is_contiguous_row : std::false_type
+{
+};
+
+template <class T>
+struct is_contiguous_row<view_row_t<T, true>> : std::true_type
+{
+};
+
+template <class Row>
+static constexpr bool is_contiguous_row_v = is_contiguous_row<std::decay_t<Row>>::value;
+
+template <class T, std::size_t D>
+struct view_operand_t
+{
+    using value_type = T;
+    static constexpr std::size_t rank = D;
+
+    const T* m_data;
+    std::array<dim_t, D> m_dims;
+
+    explicit view_operand_t(const array_view_base_t<const T, D>& view) : m_data{ view.data() }, m_dims{}
+    {
+        for (std::size_t d = 0; d < D; ++d)
+        {
+            const dim_t& dim = view.shape().dim(d);
+            // dimensions of extent 1 are broadcast, so they never move the pointer
+            m_dims[d] = dim_t{ dim.extent, dim.extent == 1 ? 0 : dim.stride };
+        }
+    }
+
+    extent_base_t extent(std::size_t d) const { return m_dims[d].extent; }
+
+    bool is_contiguous() const { return m_dims[D - 1].stride == static_cast<stride_base_t>(sizeof(T)); }
+
+    template <bool Contiguous>
+    using row_t = view_row_t<T, Contiguous>;
+
+    template <bool Contiguous, std::size_t R>
+    row_t<Contiguous> row(const row_location_t<R>& loc) const
+    {
+        static_assert(R == D, "array expression: rank mismatch");
+        flat_offset_t offset = 0;
+        for (std::size_t d = 0; d + 1 < D; ++d)
+        {
+            offset += flat_offset_t{ loc[d] } * m_dims[d].stride;
+        }
+        return row_t<Contiguous>{ to_ptr<const T*>(to_byte_ptr(m_data), offset), m_dims[D - 1].stride };
+    }
+};
+
+// keeps a temporary array alive for as long as the expression refers to it
+template <class T, std::size_t D>
+struct array_operand_t : view_operand_t<T, D>
+{
+    std::shared_ptr<const array_t<T, D>> m_array;
+
+    explicit array_operand_t(std::shared_ptr<const array_t<T, D>> array)
+        : view_operand_t<T, D>{ array->view() }
+        , m_array{ std::move(array) }
+    {
+    }
+};
+
+template <class T>
+struct scalar_operand_t
+{
+    using value_type = T;
+    static constexpr std::size_t rank = 0;
+
+    T m_value;
+
+    extent_base_t extent(std::size_t) const { return 1; }
+
+    bool is_contiguous() const { return true; }
+
+    struct row_t
+    {
+        T m_value;
+
+        T operator()(location_base_t) const { return m_value; }
+    };
+
+    template <bool Contiguous, std::size_t R>
+    row_t row(const row_location_t<R>&) const
+    {
+        return row_t{ m_value };
+    }
+};
+
+template <class Op, class... Rows>
+struct expr_row_t
+{
+    Op m_op;
+    std::tuple<Rows...> m_rows;
+
+    auto operator()(location_base_t x) const
+    {
+        return std::apply([&](const Rows&... rows) { return m_op(rows(x)...); }, m_rows);
+    }
+};
+
+template <class T>
+struct is_array_operand : std::false_type
+{
+};
+
+template <class T, std::size_t D>
+struct is_array_operand<array_view_base_t<T, D>> : std::true_type
+{
+};
+
+template <class T, std::size_t D>
+struct is_array_operand<array_t<T, D>> : std::true_type
+{
+};
+
+template <class Op, class... Args>
+struct is_array_operand<array_expr_t<Op, Args...>> : std::true_type
+{
+};
+
+template <class T>
+static constexpr bool is_array_operand_v = is_array_operand<std::decay_t<T>>::value;
+
+template <class T>
+static constexpr bool is_expr_argument_v = is_array_operand_v<T> || std::is_arithmetic_v<std::decay_t<T>>;
+
+template <class... Args>
+static constexpr bool is_array_operation_v = (is_expr_argument_v<Args> && ...) && (is_array_operand_v<Args> || ...);
+
+template <class T, std::size_t D>
+auto to_operand(const array_view_base_t<T, D>& view) -> view_operand_t<std::remove_const_t<T>, D>
+{
+    return view_operand_t<std::remove_const_t<T>, D>{ view.as_const() };
+}
+
+template <class T, std::size_t D>
+auto to_operand(const array_t<T, D>& array) -> view_operand_t<T, D>
+{
+    return view_operand_t<T, D>{ array.view() };
+}
+
+template <class T, std::size_t D>
+auto to_operand(array_t<T, D>&& array) -> array_operand_t<T, D>
+{
+    return array_operand_t<T, D>{ std::make_shared<const array_t<T, D>>(std::move(array)) };
+}
+
+template <class Op, class... Args>
+auto to_operand(const array_expr_t<Op, Args...>& expr) -> const array_expr_t<Op, Args...>&
+{
+    return expr;
+}
+
+template <class T, enable_if_t<std::is_arithmetic_v<T>> = 0>
+auto to_operand(T value) -> scalar_operand_t<T>
+{
+    return scalar_operand_t<T>{ value };
+}
+
+template <class T>
+using operand_t = std::decay_t<decltype(to_operand(std::declval<T>()))>;
+
+template <std::size_t D, class Func>
+void for_each_row(const expr_extent_t<D>& extent, location_base_t first, location_base_t last, Func&& func)
+{
+    if (std::any_of(extent.begin(), extent.end(), [](extent_base_t e) { return e <= 0; }))
+    {
+        return;
+    }
+
+    row_location_t<D> loc = {};
+
+    if constexpr (D == 1)
+    {
+        func(loc);
+    }
+    else
+    {
+        loc[0] = first;
+        while (loc[0] < last)
+        {
+            func(loc);
+            for (std::size_t k = D - 2;; --k)
+            {
+                ++loc[k];
+                if (k == 0 || loc[k] < extent[k])
+                {
+                    break;
+                }
+                loc[k] = 0;
+            }
+        }
+    }
+}
+
+template <std::size_t D, class Func>
+void for_each_row(const expr_extent_t<D>& extent, Func&& func)
+{
+    for_each_row(extent, 0, extent[0], std::forward<Func>(func));
+}
+
+}  // namespace detail
+
+template <class Op, class... Args>
+struct array_expr_t
+{
+    static constexpr std::size_t rank = std::max({ Args::rank... });
+
+    static_assert(rank > 0, "array expression requires at least one array operand");
+    static_assert(((Args::rank == 0 || Args::rank == rank) && ...), "array expression: rank mismatch");
+
+    using value_type = std::decay_t<std::invoke_result_t<const Op&, typename Args::value_type...>>;
+    using extent_type = typename shape_t<rank>::extent_type;
+
+    Op m_op;
+    std::tuple<Args...> m_args;
+    detail::expr_extent_t<rank> m_extent;
+
+    array_expr_t(Op op, Args... args) : m_op{ std::move(op) }, m_args{ std::move(args)... }, m_extent{ broadcast() } { }
+
+    extent_type extent() const { return detail::to_extent_type<rank>(m_extent); }
+
+    extent_base_t extent(std::size_t d) const { return m_extent[d]; }
+
+    volume_t volume() const
+    {
+        volume_t result = 1;
+        for (const extent_base_t e : m_extent)
+        {
+            result *= e;
+        }
+        return result;
+    }
+
+    bool is_contiguous() const
+    {
+        return std::apply([](const Args&... args) { return (args.is_contiguous() && ...); }, m_args);
+    }
+
+    template <bool Contiguous, std::size_t R>
+    auto row(const detail::row_location_t<R>& loc) const
+    {
+        return std::apply(
+            [&](const Args&... args)
+            {
+                return detail::expr_row_t<Op, decltype(args.template row<Contiguous>(loc))...>{
+                    m_op, { args.template row<Contiguous>(loc)... }
+                };
+            },
+            m_args);
+    }
+
+private:
+    detail::expr_extent_t<rank> broadcast() const
+    {
+        detail::expr_extent_t<rank> result = {};
+        std::fill(result.begin(), result.end(), extent_base_t{ 1 });
+
+        const auto combine = [&](const auto& arg)
+        {
+            if constexpr (std::decay_t<decltype(arg)>::rank > 0)
+            {
+                for (std::size_t d = 0; d < rank; ++d)
+                {
+                    const extent_base_t e = arg.extent(d);
+                    if (result[d] == 1)
+                    {
+                        result[d] = e;
+                    }
+                    else if (e != 1 && e != result[d])
+                    {
+                        throw std::invalid_argument{ format(
+                            "array expression: extents can not be broadcast (dim ", d, ": ", result[d], " vs ", e, ")") };
+                    }
+                }
+            }
+        };
+
+        std::apply([&](const Args&... args) { (combine(args), ...); }, m_args);
+        return result;
+    }
+};
+
+namespace detail
+{
+
+template <class Op, class... Args>
+auto make_array_expr(Op op, Args&&... args)
+{
+    return array_expr_t<Op, operand_t<Args>...>{ std::move(op), to_operand(std::forward<Args>(args))... };
+}
+
+template <bool Contiguous, class T, class Row>
+void write_row(T* out, stride_base_t stride, extent_base_t count, const Row& row)
+{
+    if constexpr (Contiguous)
+    {
+        for (location_base_t x = 0; x < count; ++x)
+        {
+            out[x] = static_cast<T>(row(x));
+        }
+    }
+    else
+    {
+        for (location_base_t x = 0; x < count; ++x)
+        {
+            *to_ptr<T*>(to_byte_ptr(out), flat_offset_t{ x } * stride) = static_cast<T>(row(x));
+        }
+    }
+}
+
+template <class Operand, class Func>
+void fold_rows(const Operand& operand, const expr_extent_t<Operand::rank>& extent, Func&& func)
+{
+    const auto inner = extent[Operand::rank - 1];
+    if (operand.is_contiguous())
+    {
+        for_each_row(extent, [&](const auto& loc) { func(operand.template row<true>(loc), inner, loc); });
+    }
+    else
+    {
+        for_each_row(extent, [&](const auto& loc) { func(operand.template row<false>(loc), inner, loc); });
+    }
+}
+
+struct clamp_op
+{
+    template <class T, class L, class U>
+    auto operator()(T value, L lo, U up) const
+    {
+        using result_type = std::common_type_t<T, L, U>;
+        return std::clamp(static_cast<result_type>(value), static_cast<result_type>(lo), static_cast<result_type>(up));
+    }
+};
+
+struct where_op
+{
+    template <class C, class T, class F>
+    auto operator()(C condition, T if_true, F if_false) const -> std::common_type_t<T, F>
+    {
+        using result_type = std::common_type_t<T, F>;
+        return condition ? static_cast<result_type>(if_true) : static_cast<result_type>(if_false);
+    }
+};
+
+struct minimum_op
+{
+    template <class L, class R>
+    auto operator()(L lhs, R rhs) const -> std::common_type_t<L, R>
+    {
+        using result_type = std::common_type_t<L, R>;
+        return std::min(static_cast<result_type>(lhs), static_cast<result_type>(rhs));
+    }
+};
+
+struct maximum_op
+{
+    template <class L, class R>
+    auto operator()(L lhs, R rhs) const -> std::common_type_t<L, R>
+    {
+        using result_type = std::common_type_t<L, R>;
+        return std::max(static_cast<result_type>(lhs), static_cast<result_type>(rhs));
+    }
+};
+
+template <class T>
+struct cast_op
+{
+    template <class U>
+    T operator()(U value) const
+    {
+        return static_cast<T>(value);
+    }
+};
+
+struct apply_fn
+{
+    template <class Func, class... Args, enable_if_t<is_array_operation_v<Args...>> = 0>
+    auto operator()(Func func, Args&&... args) const
+    {
+        return make_array_expr(std::move(func), std::forward<Args>(args)...);
+    }
+};
+
+struct clamp_fn
+{
+    template <class Arg, class L, class U, enable_if_t<is_array_operation_v<Arg, L, U>> = 0>
+    auto operator()(Arg&& arg, L&& lo, U&& up) const
+    {
+        return make_array_expr(clamp_op{}, std::forward<Arg>(arg), std::forward<L>(lo), std::forward<U>(up));
+    }
+};
+
+struct where_fn
+{
+    template <class C, class T, class F, enable_if_t<is_array_operation_v<C, T, F>> = 0>
+    auto operator()(C&& condition, T&& if_true, F&& if_false) const
+    {
+        return make_array_expr(where_op{}, std::forward<C>(condition), std::forward<T>(if_true), std::forward<F>(if_false));
+    }
+};
+
+struct minimum_fn
+{
+    template <class L, class R, enable_if_t<is_array_operation_v<L, R>> = 0>
+    auto operator()(L&& lhs, R&& rhs) const
+    {
+        return make_array_expr(minimum_op{}, std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+};
+
+struct maximum_fn
+{
+    template <class L, class R, enable_if_t<is_array_operation_v<L, R>> = 0>
+    auto operator()(L&& lhs, R&& rhs) const
+    {
+        return make_array_expr(maximum_op{}, std::forward<L>(lhs), std::forward<R>(rhs));
+    }
+};
+
+template <class T>
+struct cast_fn
+{
+    template <class Arg, enable_if_t<is_array_operation_v<Arg>> = 0>
+    auto operator()(Arg&& arg) const
+    {
+        return make_array_expr(cast_op<T>{}, std::forward<Arg>(arg));
+    }
+};
+
+struct assign_fn
+{
+    template <class T, std::size_t D, class Expr, enable_if_t<!std::is_const_v<T>, is_expr_argument_v<Expr>> = 0>
+    void operator()(const array_view_base_t<T, D>& dst, Expr&& expr) const
+    {
+        (*this)(execution::sequential(), dst, std::forward<Expr>(expr));
+    }
+
+    template <class T, std::size_t D, class Expr, enable_if_t<is_expr_argument_v<Expr>> = 0>
+    void operator()(array_t<T, D>& dst, Expr&& expr) const
+    {
+        (*this)(execution::sequential(), dst.mut_view(), std::forward<Expr>(expr));
+    }
+
+    template <class T, std::size_t D, class Expr, enable_if_t<is_expr_argument_v<Expr>> = 0>
+    void operator()(const execution_t& policy, array_t<T, D>& dst, Expr&& expr) const
+    {
+        (*this)(policy, dst.mut_view(), std::forward<Expr>(expr));
+    }
+
+    template <class T, std::size_t D, class Expr, enable_if_t<!std::is_const_v<T>, is_expr_argument_v<Expr>> = 0>
+    void operator()(const execution_t& policy, const array_view_base_t<T, D>& dst, Expr&& expr) const
+    {
+        const auto& operand = to_operand(std::forward<Expr>(expr));
+        using operand_type = std::decay_t<decltype(operand)>;
+        static_assert(operand_type::rank == 0 || operand_type::rank == D, "assign: rank mismatch");
+
+        const auto extent = from_extent_type<D>(dst.extent());
+        if constexpr (operand_type::rank > 0)
+        {
+            for (std::size_t d = 0; d < D; ++d)
+            {
+                const extent_base_t e = operand.extent(d);
+                if (e != extent[d] && e != 1)
+                {
+                    throw std::invalid_argument{ format(
+                        "assign: expression extent ",
+                        e,
+                        " does not match destination extent ",
+                        extent[d],
+                        " (dim ",
+                        d,
+                        ")") };
+                }
+            }
+        }
+
+        const stride_base_t inner_stride = dst.shape().dim(D - 1).stride;
+        const bool contiguous = operand.is_contiguous() && inner_stride == static_cast<stride_base_t>(sizeof(T));
+
+        const auto process_rows = [&](location_base_t first, location_base_t last)
+        {
+            for_each_row(
+                extent,
+                first,
+                last,
+                [&](const row_location_t<D>& loc)
+                {
+                    flat_offset_t offset = 0;
+                    for (std::size_t d = 0; d + 1 < D; ++d)
+                    {
+                        offset += dst.shape().dim(d).flat_offset(loc[d]);
+                    }
+                    T* out = dst.from_offset(offset);
+                    if (contiguous)
+                    {
+                        write_row<true>(out, inner_stride, extent[D - 1], operand.template row<true>(loc));
+                    }
+                    else
+                    {
+                        write_row<false>(out, inner_stride, extent[D - 1], operand.template row<false>(loc));
+                    }
+                });
+        };
+
+        if constexpr (D == 1)
+        {
+            process_rows(0, extent[0]);
+        }
+        else
+        {
+            for_each_band(policy, extent[0], process_rows);
+        }
+    }
+};
+
+struct evaluate_fn
+{
+    template <class Expr, enable_if_t<is_array_operand_v<Expr>> = 0>
+    auto operator()(Expr&& expr) const
+    {
+        return (*this)(execution::sequential(), std::forward<Expr>(expr));
+    }
+
+    template <class Expr, enable_if_t<is_array_operand_v<Expr>> = 0>
+    auto operator()(const execution_t& policy, Expr&& expr) const
+    {
+        const auto& operand = to_operand(std::forward<Expr>(expr));
+        using operand_type = std::decay_t<decltype(operand)>;
+        using value_type = typename operand_type::value_type;
+        // std::vector<bool> has no contiguous storage, so masks are materialized as bytes
+        using result_value_type = std::conditional_t<std::is_same_v<value_type, bool>, std::uint8_t, value_type>;
+        constexpr std::size_t rank = operand_type::rank;
+
+        expr_extent_t<rank> extent = {};
+        for (std::size_t d = 0; d < rank; ++d)
+        {
+            extent[d] = operand.extent(d);
+        }
+
+        array_t<result_value_type, rank> result{ to_extent_type<rank>(extent) };
+        assign_fn{}(policy, result.mut_view(), operand);
+        return result;
+    }
+};
+
+}  // namespace detail
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator+(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::plus<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator-(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::minus<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator*(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::multiplies<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator/(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::divides<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator<(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::less<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator<=(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::less_equal<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator>(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::greater<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class L, class R, enable_if_t<detail::is_array_operation_v<L, R>> = 0>
+auto operator>=(L&& lhs, R&& rhs)
+{
+    return detail::make_array_expr(std::greater_equal<>{}, std::forward<L>(lhs), std::forward<R>(rhs));
+}
+
+template <class Arg, enable_if_t<detail::is_array_operand_v<Arg>> = 0>
+auto operator-(Arg&& arg)
+{
+    return detail::make_array_expr(std::negate<>{}, std::forward<Arg>(arg));
+}
+
+using histogram_t = std::array<std::uint64_t, 256>;
+
+struct reduce
+{
+    template <class Expr, class T, class Op, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static T fold(const Expr& expr, T init, Op op)
+    {
+        const auto& operand = detail::to_operand(expr);
+        detail::fold_rows(
+            operand,
+            extent_of(operand),
+            [&](const auto& row, extent_base_t count, const auto&)
+            {
+                for (location_base_t x = 0; x < count; ++x)
+                {
+                    init = op(std::move(init), row(x));
+                }
+            });
+        return init;
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto sum(const Expr& expr)
+    {
+        using value_type = typename detail::operand_t<const Expr&>::value_type;
+        using sum_type = std::conditional_t<
+            std::is_floating_point_v<value_type>,
+            double,
+            std::conditional_t<std::is_signed_v<value_type>, std::int64_t, std::uint64_t>>;
+        return fold_runs(
+            expr,
+            sum_type{},
+            [](sum_type acc, const auto* data, std::size_t n)
+            { return acc + static_cast<sum_type>(detail::simd::sum(data, n)); },
+            [](sum_type acc, value_type v) { return acc + static_cast<sum_type>(v); });
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static double mean(const Expr& expr)
+    {
+        const auto& operand = detail::to_operand(expr);
+        const auto extent = non_empty_extent_of(operand);
+        const double volume
+            = std::accumulate(extent.begin(), extent.end(), 1.0, [](double acc, extent_base_t e) { return acc * e; });
+        return static_cast<double>(sum(expr)) / volume;
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto min(const Expr& expr)
+    {
+        return minmax(expr).first;
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto max(const Expr& expr)
+    {
+        return minmax(expr).second;
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto minmax(const Expr& expr)
+    {
+        using value_type = typename detail::operand_t<const Expr&>::value_type;
+        using result_type = std::pair<value_type, value_type>;
+        const auto& operand = detail::to_operand(expr);
+        non_empty_extent_of(operand);
+
+        using operand_type = std::decay_t<decltype(operand)>;
+        const value_type first = operand.template row<false>(detail::row_location_t<operand_type::rank>{})(0);
+
+        return fold_runs(
+            expr,
+            result_type{ first, first },
+            [](const result_type& acc, const auto* data, std::size_t n) -> result_type
+            {
+                const auto [lo, up] = detail::simd::minmax(data, n);
+                return { lo < acc.first ? lo : acc.first, acc.second < up ? up : acc.second };
+            },
+            [](const result_type& acc, value_type v) -> result_type
+            { return { v < acc.first ? v : acc.first, acc.second < v ? v : acc.second }; });
+    }
+
+    // location of the first minimal element
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto argmin(const Expr& expr)
+    {
+        return arg_extremum<false>(expr);
+    }
+
+    // location of the first maximal element
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static auto argmax(const Expr& expr)
+    {
+        return arg_extremum<true>(expr);
+    }
+
+    template <class Expr, enable_if_t<detail::is_array_operand_v<Expr>> = 0>
+    static histogram_t histogram(const Expr& expr)
+    {
+        using value_type = typename detail::operand_t<const Expr&>::value_type;
+        static_assert(std::is_same_v<value_type, std::uint8_t>, "reduce::histogram: byte values expected");
+
+        histogram_t result = {};
+        const auto& operand = detail::to_operand(expr);
+        detail::fold_rows(
+            operand,
+            extent_of(operand),
+            [&](const auto& row, extent_base_t count, const auto&)
+            {
+                if constexpr (detail::is_contiguous_row_v<decltype(row)>)
+                {
+                    detail::simd::histogram(row.m_data, static_cast<std::size_t>(count), result.data());
+                }
+                else
+                {
+                    for (location_base_t x = 0; x < count; ++x)
+                    {
+                        ++result[row(x)];
+                    }
+                }
+            });
+        return result;
+    }
+
+    template <
+        class L,
+        class R,
+        enable_if_t<detail::is_array_operand_v<L> && detail::is_array_operand_v<R>> = 0>
+    static auto dot(const L& lhs, const R& rhs)
+    {
+        using lhs_operand = detail::operand_t<const L&>;
+        using rhs_operand = detail::operand_t<const R&>;
+        constexpr std::size_t D = lhs_operand::rank;
+
+        if constexpr (
+            std::is_same_v<lhs_operand, detail::view_operand_t<float, D>>
+            && std::is_same_v<rhs_operand, detail::view_operand_t<float, D>>)
+        {
+            const lhs_operand a = detail::to_operand(lhs);
+            const rhs_operand b = detail::to_operand(rhs);
+            const auto extent = extent_of(a);
+            if (extent == extent_of(b) && a.is_contiguous() && b.is_contiguous())
+            {
+                double result = 0.0;
+                detail::for_each_row(
+                    extent,
+                    [&](const auto& loc)
+                    {
+                        result += detail::simd::dot(
+                            a.template row<true>(loc).m_data,
+                            b.template row<true>(loc).m_data,
+                            static_cast<std::size_t>(extent[D - 1]));
+                    });
+                return result;
+            }
+        }
+        return sum(lhs * rhs);
+    }
+
+private:
+    template <class Expr, class T, class Contiguous, class Op>
+    static T fold_runs(const Expr& expr, T init, Contiguous contiguous, Op op)
+    {
+        using value_type = typename detail::operand_t<const Expr&>::value_type;
+        const auto& operand = detail::to_operand(expr);
+        detail::fold_rows(
+            operand,
+            extent_of(operand),
+            [&](const auto& row, extent_base_t count, const auto&)
+            {
+                if constexpr (detail::is_contiguous_row_v<decltype(row)> && detail::simd::is_accelerated_v<value_type>)
+                {
+                    init = contiguous(std::move(init), row.m_data, static_cast<std::size_t>(count));
+                }
+                else
+                {
+                    for (location_base_t x = 0; x < count; ++x)
+                    {
+                        init = op(std::move(init), row(x));
+                    }
+                }
+            });
+        return init;
+    }
+
+    template <bool Max, class Expr>
+    static auto arg_extremum(const Expr& expr)
+    {
+        using value_type = typename detail::operand_t<const Expr&>::value_type;
+        const auto& operand = detail::to_operand(expr);
+        using operand_type = std::decay_t<decltype(operand)>;
+        constexpr std::size_t D = operand_type::rank;
+
+        const auto extent = non_empty_extent_of(operand);
+        detail::row_location_t<D> result = {};
+        value_type best = operand.template row<false>(result)(0);
+        const auto is_better = [&](const value_type& v) { return Max ? best < v : v < best; };
+
+        detail::fold_rows(
+            operand,
+            extent,
+            [&](const auto& row, extent_base_t count, const auto& loc)
+            {
+                if constexpr (detail::is_contiguous_row_v<decltype(row)> && detail::simd::is_accelerated_v<value_type>)
+                {
+                    const auto [lo, up] = detail::simd::minmax(row.m_data, static_cast<std::size_t>(count));
+                    if (!is_better(Max ? up : lo))
+                    {
+                        return;
+                    }
+                }
+                for (location_base_t x = 0; x < count; ++x)
+                {
+                    const value_type v = row(x);
+                    if (is_better(v))
+                    {
+                        best = v;
+                        result = loc;
+                        result[D - 1] = x;
+                    }
+                }
+            });
+
+        if constexpr (D == 1)
+        {
+            return result[0];
+        }
+        else
+        {
+            location_t<D> loc = {};
+            std::copy(result.begin(), result.end(), loc.begin());
+            return loc;
+        }
+    }
+
+    template <class Operand>
+    static auto extent_of(const Operand& operand) -> detail::expr_extent_t<Operand::rank>
+    {
+        detail::expr_extent_t<Operand::rank> result = {};
+        for (std::size_t d = 0; d < Operand::rank; ++d)
+        {
+            result[d] = operand.extent(d);
+        }
+        return result;
+    }
+
+    template <class Operand>
+    static auto non_empty_extent_of(const Operand& operand) -> detail::expr_extent_t<Operand::rank>
+    {
+        const auto result = extent_of(operand);
+        if (std::any_of(result.begin(), result.end(), [](extent_base_t e) { return e <= 0; }))
+        {
+            throw std::invalid_argument{ "reduce: empty array" };
+        }
+        return result;
+    }
+};
+
+static constexpr inline auto apply = detail::apply_fn{};
+static constexpr inline auto clamp = detail::clamp_fn{};
+static constexpr inline auto where = detail::where_fn{};
+static constexpr inline auto minimum = detail::minimum_fn{};
+static constexpr inline auto maximum = detail::maximum_fn{};
+static constexpr inline auto assign = detail::assign_fn{};
+static constexpr inline auto evaluate = detail::evaluate_fn{};
+
+template <class T>
+static constexpr inline auto cast = detail::cast_fn<T>{};
+
+}  // namespace mat
+}  // namespace zx
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <numeric>
+#include <optional>
 #include <ostream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <variant>
 #include <vector>
 #include <zx/function_ref.hpp>
+#include <zx/simd.hpp>
 
 namespace zx
 {
@@ -137,6 +145,13 @@ struct lookup_table_t
 
     float operator()(byte_t value) const { return m_table[value]; }
 
+    std::array<byte_t, 256> to_bytes() const
+    {
+        std::array<byte_t, 256> result = {};
+        std::transform(m_table.begin(), m_table.end(), result.begin(), &true_color_t::from_float);
+        return result;
+    }
+
     rgb_color_t operator()(const true_color_t& color) const
     {
         return rgb_color_t{ (*this)(color[0]), (*this)(color[1]), (*this)(color[2]) };
@@ -202,23 +217,95 @@ struct lookup_table
     }
 
     static lookup_table_t gamma(float value) { return levels_adjustment({ 0.F, 255.F }, { 0.F, 255.F }, value); }
+
+    // stretches the input range between the clip fraction of darkest and brightest values of the histogram
+    static lookup_table_t auto_levels(const std::array<std::uint64_t, 256>& histogram, float clip = 0.005F)
+    {
+        const std::uint64_t total = std::accumulate(histogram.begin(), histogram.end(), std::uint64_t{ 0 });
+        const auto threshold = static_cast<std::uint64_t>(static_cast<double>(clip) * static_cast<double>(total));
+
+        std::size_t lo = 0;
+        std::uint64_t below = histogram[lo];
+        while (lo < 255 && below <= threshold)
+        {
+            below += histogram[++lo];
+        }
+
+        std::size_t up = 255;
+        std::uint64_t above = histogram[up];
+        while (up > 0 && above <= threshold)
+        {
+            above += histogram[--up];
+        }
+
+        if (lo >= up)
+        {
+            return identity();
+        }
+
+        return levels_adjustment({ static_cast<float>(lo), static_cast<float>(up) }, { 0.F, 255.F });
+    }
+};
+
+// One byte table per channel, e.g. curves adjusted separately for red, green and blue. Applied to packed rgb
+// pixels without converting to float.
+struct byte_lookup_table_t
+{
+    std::array<std::array<byte_t, 256>, 3> m_tables;
+
+    explicit byte_lookup_table_t(const lookup_table_t& table) : byte_lookup_table_t(table, table, table) { }
+
+    byte_lookup_table_t(const lookup_table_t& red, const lookup_table_t& green, const lookup_table_t& blue)
+        : m_tables{ red.to_bytes(), green.to_bytes(), blue.to_bytes() }
+    {
+    }
+
+    rgb_color_t operator()(const true_color_t& color) const
+    {
+        return rgb_color_t{ true_color_t{ m_tables[0][color[0]], m_tables[1][color[1]], m_tables[2][color[2]] } };
+    }
+
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        const auto& [r, g, b] = m_tables;
+        for (byte_t* pixel = pixels; pixel != pixels + 3 * n; pixel += 3)
+        {
+            pixel[0] = r[pixel[0]];
+            pixel[1] = g[pixel[1]];
+            pixel[2] = b[pixel[2]];
+        }
+    }
 };
 
 namespace filters
 {
 
-inline auto blend(float alpha)
+// Besides the per-color call, blend modes and filters provide a span call over n packed rgb pixels
+// (dst = f(dst, src) or pixels = f(pixels)) that modify and paste use for whole rows.
+
+struct blend_fn
 {
-    return [=](const rgb_color_t& dst, const rgb_color_t& src)
+    float alpha;
+
+    rgb_color_t operator()(const rgb_color_t& dst, const rgb_color_t& src) const
     {
         const auto apply = [=](float d, float s) { return d * (1.F - alpha) + s * alpha; };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
-    };
+    }
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const { detail::simd::lerp(dst, src, 3 * n, alpha); }
+};
+
+inline auto blend(float alpha) -> blend_fn
+{
+    return blend_fn{ alpha };
 }
 
 static constexpr inline struct normal_fn
 {
     rgb_color_t operator()(const rgb_color_t&, const rgb_color_t& src) const { return src; };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const { std::copy(src, src + 3 * n, dst); }
 } normal = {};
 
 static constexpr inline struct lighter_fn
@@ -228,6 +315,11 @@ static constexpr inline struct lighter_fn
         const auto apply = [](float d, float s) { return std::max(d, s); };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const
+    {
+        std::transform(dst, dst + 3 * n, src, dst, [](byte_t d, byte_t s) { return std::max(d, s); });
+    }
 } lighter = {};
 
 static constexpr inline struct darker_fn
@@ -237,6 +329,11 @@ static constexpr inline struct darker_fn
         const auto apply = [](float d, float s) { return std::min(d, s); };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const
+    {
+        std::transform(dst, dst + 3 * n, src, dst, [](byte_t d, byte_t s) { return std::min(d, s); });
+    }
 } darker = {};
 
 static constexpr inline struct multiply_fn
@@ -246,6 +343,8 @@ static constexpr inline struct multiply_fn
         const auto apply = [](float d, float s) { return d * s / 255.F; };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const { detail::simd::multiply(dst, src, 3 * n); }
 } multiply = {};
 
 static constexpr inline struct screen_fn
@@ -255,6 +354,8 @@ static constexpr inline struct screen_fn
         const auto apply = [](float d, float s) { return 255.F - (255.F - d) * (255.F - s) / 255.F; };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const { detail::simd::screen(dst, src, 3 * n); }
 } screen = {};
 
 static constexpr inline struct difference_fn
@@ -264,6 +365,12 @@ static constexpr inline struct difference_fn
         const auto apply = [](float d, float s) { return std::abs(d - s); };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const
+    {
+        std::transform(
+            dst, dst + 3 * n, src, dst, [](byte_t d, byte_t s) { return static_cast<byte_t>(d < s ? s - d : d - s); });
+    }
 } difference = {};
 
 static constexpr inline struct overlay_fn
@@ -275,6 +382,8 @@ static constexpr inline struct overlay_fn
 
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const { detail::simd::overlay(dst, src, 3 * n); }
 } overlay = {};
 
 static constexpr inline struct add_fn
@@ -284,6 +393,12 @@ static constexpr inline struct add_fn
         const auto apply = [](float d, float s) { return s + d; };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const
+    {
+        std::transform(
+            dst, dst + 3 * n, src, dst, [](byte_t d, byte_t s) { return static_cast<byte_t>(std::min(d + s, 255)); });
+    }
 } add = {};
 
 static constexpr inline struct subtract_fn
@@ -293,6 +408,12 @@ static constexpr inline struct subtract_fn
         const auto apply = [](float d, float s) { return d + s - 255.F; };
         return rgb_color_t{ apply(dst[0], src[0]), apply(dst[1], src[1]), apply(dst[2], src[2]) };
     };
+
+    void operator()(byte_t* dst, const byte_t* src, std::size_t n) const
+    {
+        std::transform(
+            dst, dst + 3 * n, src, dst, [](byte_t d, byte_t s) { return static_cast<byte_t>(std::max(d + s - 255, 0)); });
+    }
 } subtract = {};
 
 static constexpr inline struct sepia_fn
@@ -309,6 +430,13 @@ static constexpr inline struct sepia_fn
         }
         return result;
     };
+
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        static constexpr std::array<float, 12> matrix
+            = { 0.393F, 0.769F, 0.189F, 0.F, 0.349F, 0.686F, 0.168F, 0.F, 0.272F, 0.534F, 0.131F, 0.F };
+        detail::simd::color_matrix(pixels, n, matrix.data());
+    }
 } sepia = {};
 
 static constexpr inline struct gray_fn
@@ -320,14 +448,410 @@ static constexpr inline struct gray_fn
         const float v = std::inner_product(coeffs.begin(), coeffs.end(), color.begin(), 0.F);
         return rgb_color_t{ v, v, v };
     };
+
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        static constexpr std::array<float, 12> matrix
+            = { 0.299F, 0.587F, 0.114F, 0.F, 0.299F, 0.587F, 0.114F, 0.F, 0.299F, 0.587F, 0.114F, 0.F };
+        detail::simd::color_matrix(pixels, n, matrix.data());
+    }
 } gray = {};
 
-inline auto solid(const rgb_color_t& new_color, float alpha = 1.F)
+struct solid_fn
 {
-    return [=](const rgb_color_t& color) { return blend(alpha)(color, new_color); };
+    rgb_color_t new_color;
+    float alpha;
+
+    rgb_color_t operator()(const rgb_color_t& color) const { return blend(alpha)(color, new_color); }
+
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        if (alpha == 1.F)
+        {
+            const true_color_t color{ new_color };
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                std::copy(color.begin(), color.end(), pixels + 3 * i);
+            }
+            return;
+        }
+        for (std::size_t i = 0; i < 3 * n; ++i)
+        {
+            const float value = static_cast<float>(pixels[i]) * (1.F - alpha) + new_color[i % 3] * alpha;
+            pixels[i] = true_color_t::from_float(value);
+        }
+    }
+};
+
+inline auto solid(const rgb_color_t& new_color, float alpha = 1.F) -> solid_fn
+{
+    return solid_fn{ new_color, alpha };
 }
 
 }  // namespace filters
 
+// result[i] = sum_j m[i][j] * color[j] + offset[i]
+struct color_matrix_t
+{
+    std::array<std::array<float, 3>, 3> m;
+    std::array<float, 3> offset = {};
+
+    rgb_color_t operator()(const rgb_color_t& color) const
+    {
+        rgb_color_t result;
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            result[i] = m[i][0] * color[0] + m[i][1] * color[1] + m[i][2] * color[2] + offset[i];
+        }
+        return result;
+    }
+
+    // rows of m, each followed by its offset, as the simd color matrix kernels take them
+    std::array<float, 12> coefficients() const
+    {
+        return { m[0][0], m[0][1], m[0][2], offset[0], m[1][0], m[1][1],
+                 m[1][2], offset[1], m[2][0], m[2][1], m[2][2], offset[2] };
+    }
+
+    // rhs applied first
+    friend color_matrix_t operator*(const color_matrix_t& lhs, const color_matrix_t& rhs)
+    {
+        color_matrix_t result = {};
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                result.m[i][j] = lhs.m[i][0] * rhs.m[0][j] + lhs.m[i][1] * rhs.m[1][j] + lhs.m[i][2] * rhs.m[2][j];
+            }
+            result.offset[i] = lhs.m[i][0] * rhs.offset[0] + lhs.m[i][1] * rhs.offset[1] + lhs.m[i][2] * rhs.offset[2]
+                               + lhs.offset[i];
+        }
+        return result;
+    }
+};
+
+struct color_matrix
+{
+    static color_matrix_t identity() { return { { { { 1.F, 0.F, 0.F }, { 0.F, 1.F, 0.F }, { 0.F, 0.F, 1.F } } } }; }
+
+    static color_matrix_t sepia()
+    {
+        return { { { { 0.393F, 0.769F, 0.189F }, { 0.349F, 0.686F, 0.168F }, { 0.272F, 0.534F, 0.131F } } } };
+    }
+
+    static color_matrix_t gray()
+    {
+        return { { { { 0.299F, 0.587F, 0.114F }, { 0.299F, 0.587F, 0.114F }, { 0.299F, 0.587F, 0.114F } } } };
+    }
+
+    // 0 - gray, 1 - unchanged
+    static color_matrix_t saturation(float value)
+    {
+        color_matrix_t result = gray();
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            for (std::size_t j = 0; j < 3; ++j)
+            {
+                result.m[i][j] = result.m[i][j] * (1.F - value) + (i == j ? value : 0.F);
+            }
+        }
+        return result;
+    }
+};
+
+// Chain of color matrices, lookup tables and per-color filters applied in a single pass over the pixels.
+// Adjacent matrices and adjacent lookup tables are folded into one stage while building. Stages pass float colors
+// to each other without rounding or clamping, except that the input of a lookup table is converted to a byte.
+struct color_pipeline_t
+{
+    using stage_t = std::variant<color_matrix_t, lookup_table_t, std::function<rgb_color_t(const rgb_color_t&)>>;
+
+    std::vector<stage_t> m_stages;
+    // bytes of the last stage when it is a lookup table, so that it also does the final conversion
+    std::optional<std::array<byte_t, 256>> m_output_table;
+
+    color_pipeline_t& then(const color_matrix_t& matrix)
+    {
+        if (!m_stages.empty() && std::holds_alternative<color_matrix_t>(m_stages.back()))
+        {
+            m_stages.back() = matrix * std::get<color_matrix_t>(m_stages.back());
+        }
+        else
+        {
+            m_stages.push_back(matrix);
+        }
+        return update();
+    }
+
+    color_pipeline_t& then(const lookup_table_t& table)
+    {
+        if (!m_stages.empty() && std::holds_alternative<lookup_table_t>(m_stages.back()))
+        {
+            m_stages.back() = std::get<lookup_table_t>(m_stages.back()) * table;
+        }
+        else
+        {
+            m_stages.push_back(table);
+        }
+        return update();
+    }
+
+    color_pipeline_t& then(const filters::sepia_fn&) { return then(color_matrix::sepia()); }
+    color_pipeline_t& then(const filters::gray_fn&) { return then(color_matrix::gray()); }
+
+    template <class Filter, std::enable_if_t<std::is_invocable_r_v<rgb_color_t, const Filter&, const rgb_color_t&>, int> = 0>
+    color_pipeline_t& then(Filter filter)
+    {
+        m_stages.push_back(std::function<rgb_color_t(const rgb_color_t&)>{ std::move(filter) });
+        return update();
+    }
+
+    std::size_t size() const { return m_stages.size(); }
+
+    rgb_color_t operator()(const rgb_color_t& color) const
+    {
+        rgb_color_t result = color;
+        for (const stage_t& stage : m_stages)
+        {
+            result = std::visit(
+                [&](const auto& s) -> rgb_color_t
+                {
+                    if constexpr (std::is_same_v<std::decay_t<decltype(s)>, lookup_table_t>)
+                    {
+                        return s(true_color_t{ result });
+                    }
+                    else
+                    {
+                        return s(result);
+                    }
+                },
+                stage);
+        }
+        return result;
+    }
+
+    // n packed rgb pixels, every stage over a chunk of them before the next one; a leading lookup table reads the
+    // bytes directly and a trailing one writes them
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        if (m_stages.size() == 1 && m_output_table)
+        {
+            std::transform(pixels, pixels + 3 * n, pixels, [&](byte_t v) { return (*m_output_table)[v]; });
+            return;
+        }
+
+        const lookup_table_t* input = m_stages.empty() ? nullptr : std::get_if<lookup_table_t>(&m_stages[0]);
+        const std::size_t first = input ? 1 : 0;
+        const std::size_t last = m_output_table ? m_stages.size() - 1 : m_stages.size();
+
+        // small enough for the stack and the cache, large enough to amortize the dispatch per stage
+        constexpr std::size_t chunk = 256;
+        std::array<float, 3 * chunk> values;
+        for (std::size_t offset = 0; offset < n; offset += chunk)
+        {
+            const std::size_t count = std::min(n - offset, chunk);
+            byte_t* const begin = pixels + 3 * offset;
+            byte_t* const end = begin + 3 * count;
+            if (input)
+            {
+                std::transform(begin, end, values.begin(), [&](byte_t v) { return input->m_table[v]; });
+            }
+            else
+            {
+                detail::simd::widen(begin, values.data(), 3 * count);
+            }
+
+            for (std::size_t i = first; i < last; ++i)
+            {
+                std::visit([&](const auto& stage) { apply(stage, values.data(), count); }, m_stages[i]);
+            }
+
+            detail::simd::narrow(values.data(), begin, 3 * count);
+            if (m_output_table)
+            {
+                std::transform(begin, end, begin, [&](byte_t v) { return (*m_output_table)[v]; });
+            }
+        }
+    }
+
+private:
+    color_pipeline_t& update()
+    {
+        const lookup_table_t* table = m_stages.empty() ? nullptr : std::get_if<lookup_table_t>(&m_stages.back());
+        m_output_table = table ? std::optional<std::array<byte_t, 256>>{ table->to_bytes() } : std::nullopt;
+        return *this;
+    }
+
+    static void apply(const color_matrix_t& matrix, float* values, std::size_t n)
+    {
+        detail::simd::color_matrix(values, n, matrix.coefficients().data());
+    }
+
+    static void apply(const lookup_table_t& table, float* values, std::size_t n)
+    {
+        std::transform(
+            values, values + 3 * n, values, [&](float value) { return table(true_color_t::from_float(value)); });
+    }
+
+    static void apply(const std::function<rgb_color_t(const rgb_color_t&)>& filter, float* values, std::size_t n)
+    {
+        for (float* pixel = values; pixel != values + 3 * n; pixel += 3)
+        {
+            const rgb_color_t result = filter(rgb_color_t{ pixel[0], pixel[1], pixel[2] });
+            std::copy(result.begin(), result.end(), pixel);
+        }
+    }
+};
+
+// 3D lookup table sampling a color transform on a size^3 grid over [0, 255]^3, with tetrahedral interpolation
+// between the samples. Replaces a chain of filters with one interpolation per pixel. Byte results truncate through
+// true_color_t::from_float like the filters they replace, so interpolation error below a whole level can lower a
+// byte by one: even an identity cube is not exact.
+struct color_cube_t
+{
+    std::size_t m_size;
+    // rgb of the sample (r, g, b) at 3 * ((r * size + g) * size + b)
+    std::vector<float> m_samples;
+    // offset of the grid cell along each axis and position inside it for each byte value
+    std::array<std::array<std::size_t, 256>, 3> m_offset;
+    std::array<float, 256> m_fraction;
+
+    color_cube_t(std::size_t size, std::vector<float> samples) : m_size{ size }, m_samples(std::move(samples))
+    {
+        if (size < 2 || m_samples.size() != 3 * size * size * size)
+        {
+            throw std::invalid_argument("color cube must have size^3 rgb samples with size of at least 2");
+        }
+        for (std::size_t v = 0; v < 256; ++v)
+        {
+            std::size_t cell = 0;
+            std::tie(cell, m_fraction[v]) = locate(static_cast<float>(v));
+            for (std::size_t axis = 0; axis < 3; ++axis)
+            {
+                m_offset[axis][v] = cell * stride(axis);
+            }
+        }
+    }
+
+    static color_cube_t create(function_ref<rgb_color_t(const rgb_color_t&)> func, std::size_t size = 33)
+    {
+        std::vector<float> samples;
+        samples.reserve(3 * size * size * size);
+        const float step = 255.F / static_cast<float>(std::max(size, std::size_t{ 2 }) - 1);
+        for (std::size_t r = 0; r < size; ++r)
+        {
+            for (std::size_t g = 0; g < size; ++g)
+            {
+                for (std::size_t b = 0; b < size; ++b)
+                {
+                    const rgb_color_t color = func(rgb_color_t{
+                        static_cast<float>(r) * step, static_cast<float>(g) * step, static_cast<float>(b) * step });
+                    samples.insert(samples.end(), color.begin(), color.end());
+                }
+            }
+        }
+        return color_cube_t(size, std::move(samples));
+    }
+
+    std::size_t size() const { return m_size; }
+
+    rgb_color_t operator()(const rgb_color_t& color) const
+    {
+        const auto [r, fr] = locate(color[0]);
+        const auto [g, fg] = locate(color[1]);
+        const auto [b, fb] = locate(color[2]);
+        const float* cell = m_samples.data() + r * stride(0) + g * stride(1) + b * stride(2);
+        return interpolate(cell, stride(0), stride(1), fr, fg, fb);
+    }
+
+    // truncates as the per-color call does when painted; members are read into locals first since byte stores may
+    // alias them
+    void operator()(byte_t* pixels, std::size_t n) const
+    {
+        const float* samples = m_samples.data();
+        const std::size_t dr = stride(0);
+        const std::size_t dg = stride(1);
+        const auto& [r, g, b] = m_offset;
+        const auto& fraction = m_fraction;
+        for (byte_t* pixel = pixels; pixel != pixels + 3 * n; pixel += 3)
+        {
+            const rgb_color_t color = interpolate(
+                samples + r[pixel[0]] + g[pixel[1]] + b[pixel[2]],
+                dr,
+                dg,
+                fraction[pixel[0]],
+                fraction[pixel[1]],
+                fraction[pixel[2]]);
+            for (std::size_t c = 0; c < 3; ++c)
+            {
+                pixel[c] = true_color_t::from_float(color[c]);
+            }
+        }
+    }
+
+private:
+    std::size_t stride(std::size_t axis) const { return axis == 0 ? 3 * m_size * m_size : axis == 1 ? 3 * m_size : 3; }
+
+    std::pair<std::size_t, float> locate(float value) const
+    {
+        const float position = std::min(std::max(value, 0.F), 255.F) * static_cast<float>(m_size - 1) / 255.F;
+        const std::size_t cell = std::min(static_cast<std::size_t>(position), m_size - 2);
+        return { cell, position - static_cast<float>(cell) };
+    }
+
+    // the cell is split into six tetrahedra along its main diagonal; the order of the fractions picks the one that
+    // contains the point and the path of corners from (0, 0, 0) to (1, 1, 1) through it
+    static rgb_color_t interpolate(const float* c000, std::size_t dr, std::size_t dg, float fr, float fg, float fb)
+    {
+        const std::size_t db = 3;
+        const float* c111 = c000 + dr + dg + db;
+
+        // f1 >= f2 >= f3 are the fractions along the first axis of the path, the second one and the remaining one
+        const auto blend = [&](std::size_t first, std::size_t second, float f1, float f2, float f3)
+        {
+            const float* c1 = c000 + first;
+            const float* c2 = c1 + second;
+            rgb_color_t result;
+            for (std::size_t c = 0; c < 3; ++c)
+            {
+                result[c] = (1.F - f1) * c000[c] + (f1 - f2) * c1[c] + (f2 - f3) * c2[c] + f3 * c111[c];
+            }
+            return result;
+        };
+
+        if (fr >= fg)
+        {
+            if (fg >= fb)
+            {
+                return blend(dr, dg, fr, fg, fb);
+            }
+            return fr >= fb ? blend(dr, db, fr, fb, fg) : blend(db, dr, fb, fr, fg);
+        }
+        if (fb >= fg)
+        {
+            return blend(db, dg, fb, fg, fr);
+        }
+        return fb >= fr ? blend(dg, db, fg, fb, fr) : blend(dg, dr, fg, fr, fb);
+    }
+};
+
+namespace detail
+{
+
+struct color_pipeline_fn
+{
+    template <class... Stages>
+    auto operator()(const Stages&... stages) const -> color_pipeline_t
+    {
+        color_pipeline_t result;
+        (result.then(stages), ...);
+        return result;
+    }
+};
+
+}  // namespace detail
+
+static constexpr inline auto color_pipeline = detail::color_pipeline_fn{};
+
 }  // namespace mat
 }  // namespace zx
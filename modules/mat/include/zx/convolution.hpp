@@ -0,0 +1,1127 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <vector>
+#include <zx/array.hpp>
+#include <zx/fft.hpp>
+#include <zx/format.hpp>
+#include <zx/parallel.hpp>
+#include <zx/simd.hpp>
+
+namespace zx
+{
+namespace mat
+{
+
+// mask[y][x] == column[y] * row[x]
+struct separable_mask_t
+{
+    std::vector<float> column;
+    std::vector<float> row;
+
+    extent_t<2, extent_base_t> extent() const
+    {
+        return { static_cast<extent_base_t>(column.size()), static_cast<extent_base_t>(row.size()) };
+    }
+
+    array_t<float, 2> outer() const
+    {
+        array_t<float, 2> result{ extent() };
+        for (std::size_t y = 0; y < column.size(); ++y)
+        {
+            for (std::size_t x = 0; x < row.size(); ++x)
+            {
+                result[{ static_cast<location_base_t>(y), static_cast<location_base_t>(x) }] = column[y] * row[x];
+            }
+        }
+        return result;
+    }
+
+    friend bool operator==(const separable_mask_t& lhs, const separable_mask_t& rhs)
+    {
+        return std::tie(lhs.column, lhs.row) == std::tie(rhs.column, rhs.row);
+    }
+
+    friend bool operator!=(const separable_mask_t& lhs, const separable_mask_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const separable_mask_t& item)
+    {
+        return os << "{"
+                  << ":column " << delimit(item.column, " ") << " "
+                  << ":row " << delimit(item.row, " ") << "}";
+    }
+};
+
+// mask[y][x] == coefficients[y * width + x] / 2^shift
+struct fixed_point_mask_t
+{
+    extent_t<2, extent_base_t> size;
+    std::vector<std::int16_t> coefficients;
+    int shift = 0;
+
+    extent_t<2, extent_base_t> extent() const { return size; }
+
+    friend bool operator==(const fixed_point_mask_t& lhs, const fixed_point_mask_t& rhs)
+    {
+        return std::tie(lhs.size, lhs.coefficients, lhs.shift) == std::tie(rhs.size, rhs.coefficients, rhs.shift);
+    }
+
+    friend bool operator!=(const fixed_point_mask_t& lhs, const fixed_point_mask_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const fixed_point_mask_t& item)
+    {
+        return os << "{"
+                  << ":size " << item.size << " "
+                  << ":coefficients " << delimit(item.coefficients, " ") << " "
+                  << ":shift " << item.shift << "}";
+    }
+};
+
+// automatic - byte images may use a fixed-point kernel when its error bound allows; exact - always accumulate in float
+enum class kernel_precision_t
+{
+    automatic,
+    exact,
+};
+
+inline std::ostream& operator<<(std::ostream& os, kernel_precision_t item)
+{
+    switch (item)
+    {
+        case kernel_precision_t::automatic: return os << "automatic";
+        case kernel_precision_t::exact: return os << "exact";
+    }
+    return os;
+}
+
+// automatic - convolve estimates the cost of every applicable method and picks the cheapest
+// integral - window sums from summed-area tables; only for masks whose coefficients share one weight
+enum class convolution_method_t
+{
+    automatic,
+    direct,
+    separable,
+    fft,
+    integral,
+};
+
+inline std::ostream& operator<<(std::ostream& os, convolution_method_t item)
+{
+    switch (item)
+    {
+        case convolution_method_t::automatic: return os << "automatic";
+        case convolution_method_t::direct: return os << "direct";
+        case convolution_method_t::separable: return os << "separable";
+        case convolution_method_t::fft: return os << "fft";
+        case convolution_method_t::integral: return os << "integral";
+    }
+    return os;
+}
+
+// valid - output only where the whole window lies inside the image (extent - window + 1);
+// other modes extend the image so that the output has the extent of the input
+enum class border_mode_t
+{
+    valid,
+    constant,
+    replicate,
+    reflect,
+    wrap,
+};
+
+inline std::ostream& operator<<(std::ostream& os, border_mode_t item)
+{
+    switch (item)
+    {
+        case border_mode_t::valid: return os << "valid";
+        case border_mode_t::constant: return os << "constant";
+        case border_mode_t::replicate: return os << "replicate";
+        case border_mode_t::reflect: return os << "reflect";
+        case border_mode_t::wrap: return os << "wrap";
+    }
+    return os;
+}
+
+struct border_t
+{
+    border_mode_t mode = border_mode_t::valid;
+    // used by border_mode_t::constant
+    std::uint8_t value = 0;
+
+    friend bool operator==(const border_t& lhs, const border_t& rhs)
+    {
+        return std::tie(lhs.mode, lhs.value) == std::tie(rhs.mode, rhs.value);
+    }
+
+    friend bool operator!=(const border_t& lhs, const border_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const border_t& item)
+    {
+        return os << "{"
+                  << ":mode " << item.mode << " "
+                  << ":value " << static_cast<int>(item.value) << "}";
+    }
+};
+
+struct border
+{
+    static border_t valid() { return border_t{ border_mode_t::valid, 0 }; }
+    static border_t constant(std::uint8_t value = 0) { return border_t{ border_mode_t::constant, value }; }
+    // aaa|abcd|ddd
+    static border_t replicate() { return border_t{ border_mode_t::replicate, 0 }; }
+    // cba|abcd|dcb
+    static border_t reflect() { return border_t{ border_mode_t::reflect, 0 }; }
+    // bcd|abcd|abc
+    static border_t wrap() { return border_t{ border_mode_t::wrap, 0 }; }
+};
+
+// Summed-area tables of byte channels: sums[c][{ y, x }] is the total of channel c over the rows above y and the
+// columns left of x, so the sum over any rectangle takes four lookups. Sums wrap around modulo 2^32, which keeps
+// them exact for every rectangle of up to 2^24 pixels; sums of squares have 64 bits.
+struct integral_image_t
+{
+    using sum_type = std::uint32_t;
+    using square_sum_type = std::uint64_t;
+
+    std::vector<array_t<sum_type, 2>> sums;
+    std::vector<array_t<square_sum_type, 2>> square_sums;
+
+    std::size_t channels() const { return sums.size(); }
+
+    // extent of the source image
+    extent_t<2, extent_base_t> extent() const
+    {
+        return sums.empty() ? extent_t<2, extent_base_t>{} : sums[0].extent() - extent_t<2, extent_base_t>{ 1, 1 };
+    }
+
+    // Regions are clipped to the image.
+    sum_type sum(std::size_t channel, const rectangle_t<location_base_t>& region) const
+    {
+        return corners(sums.at(channel), region);
+    }
+
+    square_sum_type square_sum(std::size_t channel, const rectangle_t<location_base_t>& region) const
+    {
+        return corners(square_sums.at(channel), region);
+    }
+
+    // 0 for an empty region
+    float mean(std::size_t channel, const rectangle_t<location_base_t>& region) const
+    {
+        const auto n = static_cast<double>(area(region));
+        return n > 0.0 ? static_cast<float>(static_cast<double>(sum(channel, region)) / n) : 0.F;
+    }
+
+    float variance(std::size_t channel, const rectangle_t<location_base_t>& region) const
+    {
+        const auto n = static_cast<double>(area(region));
+        if (n <= 0.0)
+        {
+            return 0.F;
+        }
+        const double s = static_cast<double>(sum(channel, region));
+        const double sq = static_cast<double>(square_sum(channel, region));
+        return static_cast<float>(std::max((n * sq - s * s) / (n * n), 0.0));
+    }
+
+private:
+    rectangle_t<location_base_t> clip(const rectangle_t<location_base_t>& region) const
+    {
+        const auto size = extent();
+        rectangle_t<location_base_t> result;
+        for (std::size_t d = 0; d < 2; ++d)
+        {
+            const location_base_t lower = std::clamp(region[d][0], location_base_t{ 0 }, size[d]);
+            result[d] = interval_t<location_base_t>{ lower, std::clamp(region[d][1], lower, size[d]) };
+        }
+        return result;
+    }
+
+    flat_offset_t area(const rectangle_t<location_base_t>& region) const
+    {
+        const auto r = clip(region);
+        return flat_offset_t{ r[0][1] - r[0][0] } * flat_offset_t{ r[1][1] - r[1][0] };
+    }
+
+    template <class T>
+    T corners(const array_t<T, 2>& table, const rectangle_t<location_base_t>& region) const
+    {
+        const auto r = clip(region);
+        return static_cast<T>(
+            table[{ r[0][1], r[1][1] }] - table[{ r[0][0], r[1][1] }] - table[{ r[0][1], r[1][0] }]
+            + table[{ r[0][0], r[1][0] }]);
+    }
+};
+
+namespace detail
+{
+
+// Index into [0, n) for a position outside of it; -1 when the border has no source sample.
+inline location_base_t border_index(location_base_t i, extent_base_t n, border_mode_t mode)
+{
+    if (0 <= i && i < n)
+    {
+        return i;
+    }
+    switch (mode)
+    {
+        case border_mode_t::replicate: return std::clamp(i, location_base_t{ 0 }, n - 1);
+        case border_mode_t::reflect:
+        {
+            const location_base_t period = 2 * n;
+            const location_base_t j = (i % period + period) % period;
+            return j < n ? j : period - 1 - j;
+        }
+        case border_mode_t::wrap: return (i % n + n) % n;
+        default: return -1;
+    }
+}
+
+// A byte channel extended by its border so that every output pixel has a full window, read row by row into
+// caller buffers. rows() exposes a horizontal strip of the extended image, which lets callers process it piecewise.
+struct padded_source_t
+{
+    array_view_t<std::uint8_t, 2> m_src;
+    border_t m_border;
+    // padding above and to the left of the source
+    extent_t<2, extent_base_t> m_before;
+    extent_t<2, extent_base_t> m_extent;
+    location_base_t m_first_row = 0;
+
+    padded_source_t(array_view_t<std::uint8_t, 2> src, const extent_t<2, extent_base_t>& window, const border_t& border)
+        : m_src{ std::move(src) }
+        , m_border{ border }
+        , m_before{}
+        , m_extent{ m_src.extent() }
+    {
+        if (m_border.mode != border_mode_t::valid)
+        {
+            for (std::size_t d = 0; d < 2; ++d)
+            {
+                m_before[d] = (window[d] - 1) / 2;
+                m_extent[d] += window[d] - 1;
+            }
+        }
+    }
+
+    extent_t<2, extent_base_t> extent() const { return m_extent; }
+
+    padded_source_t rows(location_base_t first, extent_base_t count) const
+    {
+        padded_source_t result = *this;
+        result.m_first_row += first;
+        result.m_extent[0] = count;
+        return result;
+    }
+
+    location_base_t source_row(location_base_t y) const
+    {
+        return border_index(m_first_row + y - m_before[0], m_src.extent()[0], m_border.mode);
+    }
+
+    location_base_t source_column(location_base_t x) const
+    {
+        return border_index(x - m_before[1], m_src.extent()[1], m_border.mode);
+    }
+
+    // Copies row y of the extended image (extent()[1] samples).
+    void load(location_base_t y, std::uint8_t* line) const
+    {
+        const location_base_t sy = source_row(y);
+        if (sy < 0)
+        {
+            std::fill_n(line, m_extent[1], m_border.value);
+            return;
+        }
+
+        const std::uint8_t* row = m_src.from_offset(flat_offset_t{ sy } * m_src.shape().dim(0).stride);
+        const stride_base_t step = m_src.shape().dim(1).stride;
+        const extent_base_t width = m_src.extent()[1];
+        const extent_base_t left = m_before[1];
+
+        for (location_base_t x = 0; x < width; ++x)
+        {
+            line[left + x] = row[flat_offset_t{ x } * step];
+        }
+
+        const auto load_border = [&](location_base_t first, location_base_t last)
+        {
+            for (location_base_t x = first; x < last; ++x)
+            {
+                const location_base_t sx = source_column(x);
+                line[x] = sx < 0 ? m_border.value : row[flat_offset_t{ sx } * step];
+            }
+        };
+        load_border(0, left);
+        load_border(left + width, m_extent[1]);
+    }
+
+    // The window at (y, x) as a view into the source when it does not touch the border.
+    std::optional<array_view_t<std::uint8_t, 2>> window(const location_t<2>& loc, const extent_t<2, extent_base_t>& size)
+        const
+    {
+        const location_base_t y = m_first_row + loc[0] - m_before[0];
+        const location_base_t x = loc[1] - m_before[1];
+        if (y < 0 || x < 0 || y + size[0] > m_src.extent()[0] || x + size[1] > m_src.extent()[1])
+        {
+            return std::nullopt;
+        }
+        return m_src.slice({ { y, y + size[0] }, { x, x + size[1] } });
+    }
+
+    // Copies the window at (y, x) including its border samples into patch.
+    void gather(const location_t<2>& loc, const array_mut_view_t<std::uint8_t, 2>& patch) const
+    {
+        for (location_base_t dy = 0; dy < patch.extent()[0]; ++dy)
+        {
+            const location_base_t sy = source_row(loc[0] + dy);
+            for (location_base_t dx = 0; dx < patch.extent()[1]; ++dx)
+            {
+                const location_base_t sx = source_column(loc[1] + dx);
+                patch[{ dy, dx }] = sy < 0 || sx < 0 ? m_border.value : m_src[{ sy, sx }];
+            }
+        }
+    }
+};
+
+// Picks the largest shift that keeps coefficients in int16 and the accumulator of 8-bit samples in int32.
+// Returns nothing if the worst-case deviation from the float result exceeds max_error.
+inline std::optional<fixed_point_mask_t> quantize(const array_view_t<float, 2>& mask, float max_error = 0.25F)
+{
+    static constexpr int max_shift = 14;
+    static constexpr double max_sample = 255.0;
+
+    double max_coeff = 0.0;
+    double abs_sum = 0.0;
+    for (const float value : mask)
+    {
+        max_coeff = std::max(max_coeff, std::abs(static_cast<double>(value)));
+        abs_sum += std::abs(static_cast<double>(value));
+    }
+
+    for (int shift = max_shift; shift >= 0; --shift)
+    {
+        const double scale = static_cast<double>(1 << shift);
+        if (std::round(max_coeff * scale) > std::numeric_limits<std::int16_t>::max()
+            || (abs_sum * scale + 0.5 * static_cast<double>(mask.shape().volume())) * max_sample
+                   > std::numeric_limits<std::int32_t>::max())
+        {
+            continue;
+        }
+
+        fixed_point_mask_t result{ mask.extent(), {}, shift };
+        result.coefficients.reserve(static_cast<std::size_t>(mask.shape().volume()));
+        double error = 0.0;
+        for (const float value : mask)
+        {
+            const double q = std::round(static_cast<double>(value) * scale);
+            error += std::abs(q / scale - static_cast<double>(value)) * max_sample;
+            result.coefficients.push_back(static_cast<std::int16_t>(q));
+        }
+
+        if (error > static_cast<double>(max_error))
+        {
+            return std::nullopt;
+        }
+        return result;
+    }
+    return std::nullopt;
+}
+
+// Factors a rank-1 mask into a column and a row vector.
+inline std::optional<separable_mask_t> separate(const array_view_t<float, 2>& mask, float tolerance = 1e-5F)
+{
+    const extent_base_t h = mask.extent()[0];
+    const extent_base_t w = mask.extent()[1];
+
+    location_t<2> pivot = {};
+    float pivot_value = 0.F;
+    for (location_base_t y = 0; y < h; ++y)
+    {
+        for (location_base_t x = 0; x < w; ++x)
+        {
+            const float value = mask[{ y, x }];
+            if (std::abs(value) > std::abs(pivot_value))
+            {
+                pivot = { y, x };
+                pivot_value = value;
+            }
+        }
+    }
+
+    if (pivot_value == 0.F)
+    {
+        return std::nullopt;
+    }
+
+    separable_mask_t result;
+    result.column.resize(static_cast<std::size_t>(h));
+    result.row.resize(static_cast<std::size_t>(w));
+    for (location_base_t y = 0; y < h; ++y)
+    {
+        result.column[static_cast<std::size_t>(y)] = mask[{ y, pivot[1] }];
+    }
+    for (location_base_t x = 0; x < w; ++x)
+    {
+        result.row[static_cast<std::size_t>(x)] = mask[{ pivot[0], x }] / pivot_value;
+    }
+
+    const float max_error = tolerance * std::abs(pivot_value);
+    for (location_base_t y = 0; y < h; ++y)
+    {
+        for (location_base_t x = 0; x < w; ++x)
+        {
+            const float expected = result.column[static_cast<std::size_t>(y)] * result.row[static_cast<std::size_t>(x)];
+            if (std::abs(mask[{ y, x }] - expected) > max_error)
+            {
+                return std::nullopt;
+            }
+        }
+    }
+
+    return result;
+}
+
+// Convolves src with N separable masks of equal extent in two 1D passes (rows, then columns) and calls
+// func(y, values) for every row of the valid region, where values[i] points to its floats for masks[i].
+template <std::size_t N, class Func>
+void separable_rows(
+    const execution_t& policy,
+    const padded_source_t& src,
+    const std::array<const separable_mask_t*, N>& masks,
+    Func&& func)
+{
+    static constexpr location_base_t strip_height = 64;
+
+    const extent_base_t kh = masks[0]->extent()[0];
+    const extent_base_t kw = masks[0]->extent()[1];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src.extent()[0] - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+
+    const auto width = static_cast<std::size_t>(w);
+
+    for_each_band(
+        policy,
+        h,
+        [&](location_base_t first, location_base_t last)
+        {
+            const auto strip_rows = static_cast<std::size_t>(strip_height + kh - 1);
+            std::vector<std::uint8_t> bytes(static_cast<std::size_t>(src_w));
+            std::vector<float> line(static_cast<std::size_t>(src_w));
+            std::vector<float> horizontal(N * strip_rows * width);
+            std::vector<float> vertical(N * width);
+            std::array<const float*, N> values = {};
+
+            const auto horizontal_row = [&](std::size_t i, location_base_t r)
+            { return horizontal.data() + (i * strip_rows + static_cast<std::size_t>(r)) * width; };
+
+            for (location_base_t strip = first; strip < last; strip += strip_height)
+            {
+                const location_base_t strip_last = std::min(strip + strip_height, last);
+                const location_base_t rows = strip_last - strip + kh - 1;
+
+                for (location_base_t r = 0; r < rows; ++r)
+                {
+                    src.load(strip + r, bytes.data());
+                    std::copy(bytes.begin(), bytes.end(), line.begin());
+
+                    for (std::size_t i = 0; i < N; ++i)
+                    {
+                        float* out = horizontal_row(i, r);
+                        std::fill(out, out + width, 0.F);
+                        for (location_base_t k = 0; k < kw; ++k)
+                        {
+                            const float c = masks[i]->row[static_cast<std::size_t>(k)];
+                            const float* in = line.data() + k;
+                            for (std::size_t x = 0; x < width; ++x)
+                            {
+                                out[x] += c * in[x];
+                            }
+                        }
+                    }
+                }
+
+                for (location_base_t y = strip; y < strip_last; ++y)
+                {
+                    for (std::size_t i = 0; i < N; ++i)
+                    {
+                        float* out = vertical.data() + i * width;
+                        std::fill(out, out + width, 0.F);
+                        for (location_base_t k = 0; k < kh; ++k)
+                        {
+                            const float c = masks[i]->column[static_cast<std::size_t>(k)];
+                            const float* in = horizontal_row(i, y - strip + k);
+                            for (std::size_t x = 0; x < width; ++x)
+                            {
+                                out[x] += c * in[x];
+                            }
+                        }
+                        values[i] = out;
+                    }
+                    func(y, values);
+                }
+            }
+        });
+}
+
+// Convolves src with a fixed-point mask in integer arithmetic and calls func(y, row) for every row of the valid region,
+// where row points to the saturated 8-bit results.
+template <class Func>
+void fixed_point_rows(
+    const execution_t& policy, const padded_source_t& src, const fixed_point_mask_t& mask, Func&& func)
+{
+    static constexpr location_base_t strip_height = 64;
+
+    const extent_base_t kh = mask.extent()[0];
+    const extent_base_t kw = mask.extent()[1];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src.extent()[0] - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+
+    const auto width = static_cast<std::size_t>(w);
+    const auto line_width = static_cast<std::size_t>(src_w);
+
+    for_each_band(
+        policy,
+        h,
+        [&](location_base_t first, location_base_t last)
+        {
+            std::vector<std::uint8_t> lines(static_cast<std::size_t>(strip_height + kh - 1) * line_width);
+            std::vector<std::int32_t> acc(width);
+            std::vector<std::uint8_t> out(width);
+
+            for (location_base_t strip = first; strip < last; strip += strip_height)
+            {
+                const location_base_t strip_last = std::min(strip + strip_height, last);
+                const location_base_t rows = strip_last - strip + kh - 1;
+
+                for (location_base_t r = 0; r < rows; ++r)
+                {
+                    src.load(strip + r, lines.data() + static_cast<std::size_t>(r) * line_width);
+                }
+
+                for (location_base_t y = strip; y < strip_last; ++y)
+                {
+                    std::fill(acc.begin(), acc.end(), 0);
+                    const std::int16_t* coeff = mask.coefficients.data();
+                    for (location_base_t ky = 0; ky < kh; ++ky)
+                    {
+                        const std::uint8_t* line = lines.data() + static_cast<std::size_t>(y - strip + ky) * line_width;
+                        for (location_base_t kx = 0; kx < kw; ++kx, ++coeff)
+                        {
+                            if (*coeff != 0)
+                            {
+                                simd::accumulate(acc.data(), line + kx, width, *coeff);
+                            }
+                        }
+                    }
+
+                    for (std::size_t x = 0; x < width; ++x)
+                    {
+                        out[x] = static_cast<std::uint8_t>(std::clamp(acc[x] >> mask.shift, 0, 255));
+                    }
+                    func(y, out.data());
+                }
+            }
+        });
+}
+
+// Fills the (h + 1) x (w + 1) tables of one channel a row at a time: each row adds its running sums to the row above.
+inline void integral_plane(
+    const array_view_t<std::uint8_t, 2>& src,
+    const array_mut_view_t<std::uint32_t, 2>& sums,
+    const array_mut_view_t<std::uint64_t, 2>& square_sums)
+{
+    const extent_base_t h = src.extent()[0];
+    const extent_base_t w = src.extent()[1];
+    if (w == 0)
+    {
+        return;
+    }
+
+    const auto width = static_cast<std::size_t>(w);
+    const stride_base_t step = src.shape().dim(1).stride;
+    std::vector<std::uint8_t> line(width);
+
+    for (location_base_t y = 0; y < h; ++y)
+    {
+        const std::uint8_t* row = src.from_offset(flat_offset_t{ y } * src.shape().dim(0).stride);
+        for (location_base_t x = 0; x < w; ++x)
+        {
+            line[static_cast<std::size_t>(x)] = row[flat_offset_t{ x } * step];
+        }
+
+        simd::integral(line.data(), &sums[{ y, 1 }], &sums[{ y + 1, 1 }], width);
+
+        const std::uint64_t* square_above = &square_sums[{ y, 1 }];
+        std::uint64_t* square_out = &square_sums[{ y + 1, 1 }];
+        std::uint64_t square = 0;
+        for (std::size_t x = 0; x < width; ++x)
+        {
+            square += std::uint64_t{ line[x] } * line[x];
+            square_out[x] = square_above[x] + square;
+        }
+    }
+}
+
+// Largest window whose sum of 8-bit samples stays below 2^31, which box_rows needs for exact differences.
+static constexpr inline flat_offset_t max_box_volume = std::numeric_limits<std::int32_t>::max() / 255;
+
+// Box filter through summed-area tables: calls func(y, row) for every row of the valid region, where row holds
+// weight times the window sum, clamped to [0, 255] and truncated like the float engines. Each band keeps a ring of
+// kh + 1 table rows counted from its own first row, so the cost per pixel does not depend on the window.
+template <class Func>
+void box_rows(
+    const execution_t& policy,
+    const padded_source_t& src,
+    const extent_t<2, extent_base_t>& window,
+    float weight,
+    Func&& func)
+{
+    const extent_base_t kh = window[0];
+    const extent_base_t kw = window[1];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src.extent()[0] - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+
+    const auto width = static_cast<std::size_t>(w);
+    const auto line_width = static_cast<std::size_t>(src_w) + 1;
+    const auto ring = static_cast<std::size_t>(kh) + 1;
+    const auto offset = static_cast<std::size_t>(kw);
+
+    for_each_band(
+        policy,
+        h,
+        [&](location_base_t first, location_base_t last)
+        {
+            std::vector<std::uint8_t> bytes(static_cast<std::size_t>(src_w));
+            // column 0 of every row stays zero
+            std::vector<std::uint32_t> table(ring * line_width, 0);
+            std::vector<float> values(width);
+            std::vector<std::uint8_t> out(width);
+
+            // the sums over source rows [first, first + r)
+            const auto table_row = [&](location_base_t r)
+            { return table.data() + static_cast<std::size_t>(r) % ring * line_width; };
+            const auto add_row = [&](location_base_t r)
+            {
+                src.load(first + r, bytes.data());
+                simd::integral(bytes.data(), table_row(r) + 1, table_row(r + 1) + 1, bytes.size());
+            };
+
+            for (location_base_t r = 0; r + 1 < kh; ++r)
+            {
+                add_row(r);
+            }
+
+            for (location_base_t y = first; y < last; ++y)
+            {
+                const location_base_t r = y - first;
+                add_row(r + kh - 1);
+
+                const std::uint32_t* top = table_row(r);
+                const std::uint32_t* bottom = table_row(r + kh);
+                for (std::size_t x = 0; x < width; ++x)
+                {
+                    const std::uint32_t sum = bottom[x + offset] - bottom[x] - top[x + offset] + top[x];
+                    values[x] = weight * static_cast<float>(static_cast<std::int32_t>(sum));
+                }
+                simd::narrow(values.data(), out.data(), width);
+                func(y, out.data());
+            }
+        });
+}
+
+// Running max (or min) over a kh x kw rectangle with the van Herk/Gil-Werman algorithm, separably: rows first, then
+// columns. Each pass splits the line into blocks of the window length and combines a block-suffix and a block-prefix
+// extremum, about three comparisons per sample regardless of the window. Calls func(y, row) for every row of the
+// valid region.
+template <class Op, class Func>
+void extremum_rows(
+    const execution_t& policy,
+    const padded_source_t& src,
+    const extent_t<2, extent_base_t>& window,
+    Op op,
+    Func&& func)
+{
+    static constexpr location_base_t strip_height = 64;
+
+    const extent_base_t kh = window[0];
+    const extent_base_t kw = window[1];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src.extent()[0] - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+
+    const auto width = static_cast<std::size_t>(w);
+    const auto line_width = static_cast<std::size_t>(src_w);
+    const auto k_w = static_cast<std::size_t>(kw);
+    const auto k_h = static_cast<std::size_t>(kh);
+
+    for_each_band(
+        policy,
+        h,
+        [&](location_base_t first, location_base_t last)
+        {
+            const auto strip_rows = static_cast<std::size_t>(strip_height + kh - 1);
+            std::vector<std::uint8_t> line(line_width);
+            std::vector<std::uint8_t> prefix(std::max(line_width, strip_rows * width));
+            std::vector<std::uint8_t> suffix(prefix.size());
+            std::vector<std::uint8_t> horizontal(strip_rows * width);
+            std::vector<std::uint8_t> out(width);
+
+            for (location_base_t strip = first; strip < last; strip += strip_height)
+            {
+                const location_base_t strip_last = std::min(strip + strip_height, last);
+                const auto rows = static_cast<std::size_t>(strip_last - strip + kh - 1);
+
+                for (std::size_t r = 0; r < rows; ++r)
+                {
+                    src.load(strip + static_cast<location_base_t>(r), line.data());
+
+                    for (std::size_t begin = 0; begin < line_width; begin += k_w)
+                    {
+                        const std::size_t end = std::min(begin + k_w, line_width);
+                        prefix[begin] = line[begin];
+                        for (std::size_t x = begin + 1; x < end; ++x)
+                        {
+                            prefix[x] = op(prefix[x - 1], line[x]);
+                        }
+                        suffix[end - 1] = line[end - 1];
+                        for (std::size_t x = end - 1; x > begin; --x)
+                        {
+                            suffix[x - 1] = op(suffix[x], line[x - 1]);
+                        }
+                    }
+
+                    std::uint8_t* out_row = horizontal.data() + r * width;
+                    for (std::size_t x = 0; x < width; ++x)
+                    {
+                        out_row[x] = op(suffix[x], prefix[x + k_w - 1]);
+                    }
+                }
+
+                for (std::size_t begin = 0; begin < rows; begin += k_h)
+                {
+                    const std::size_t end = std::min(begin + k_h, rows);
+                    std::copy_n(horizontal.data() + begin * width, width, prefix.data() + begin * width);
+                    for (std::size_t r = begin + 1; r < end; ++r)
+                    {
+                        const std::uint8_t* previous = prefix.data() + (r - 1) * width;
+                        const std::uint8_t* current = horizontal.data() + r * width;
+                        std::uint8_t* result = prefix.data() + r * width;
+                        for (std::size_t x = 0; x < width; ++x)
+                        {
+                            result[x] = op(previous[x], current[x]);
+                        }
+                    }
+
+                    std::copy_n(horizontal.data() + (end - 1) * width, width, suffix.data() + (end - 1) * width);
+                    for (std::size_t r = end - 1; r > begin; --r)
+                    {
+                        const std::uint8_t* next = suffix.data() + r * width;
+                        const std::uint8_t* current = horizontal.data() + (r - 1) * width;
+                        std::uint8_t* result = suffix.data() + (r - 1) * width;
+                        for (std::size_t x = 0; x < width; ++x)
+                        {
+                            result[x] = op(next[x], current[x]);
+                        }
+                    }
+                }
+
+                for (location_base_t y = strip; y < strip_last; ++y)
+                {
+                    const auto r = static_cast<std::size_t>(y - strip);
+                    const std::uint8_t* lhs = suffix.data() + r * width;
+                    const std::uint8_t* rhs = prefix.data() + (r + k_h - 1) * width;
+                    for (std::size_t x = 0; x < width; ++x)
+                    {
+                        out[x] = op(lhs[x], rhs[x]);
+                    }
+                    func(y, out.data());
+                }
+            }
+        });
+}
+
+// Spectrum of a mask mirrored into a size x size block (so that the product with an image spectrum correlates the
+// image with the mask), scaled by 1 / size^2 to normalize the inverse transform.
+struct fft_spectrum_t
+{
+    std::size_t size = 0;
+    extent_t<2, extent_base_t> window = {};
+    std::vector<complex_t> values;
+};
+
+inline fft_spectrum_t make_fft_spectrum(const array_view_t<float, 2>& mask, std::size_t size)
+{
+    const extent_t<2, extent_base_t> window = mask.extent();
+    fft_spectrum_t result{ size, window, std::vector<complex_t>(size * size) };
+    for (location_base_t y = 0; y < window[0]; ++y)
+    {
+        for (location_base_t x = 0; x < window[1]; ++x)
+        {
+            const std::size_t row = (size - static_cast<std::size_t>(y)) % size;
+            const std::size_t column = (size - static_cast<std::size_t>(x)) % size;
+            result.values[row * size + column] = complex_t{ mask[{ y, x }], 0.F };
+        }
+    }
+
+    std::vector<complex_t> column;
+    fft_plan_t{ size }.transform_2d(result.values.data(), column);
+
+    const float scale = 1.F / static_cast<float>(size * size);
+    for (complex_t& value : result.values)
+    {
+        value *= scale;
+    }
+    return result;
+}
+
+// Overlap-save convolution: every size x size block of the source yields (size - kh + 1) x (size - kw + 1) outputs.
+// The mask is real, so two blocks share one complex transform as its real and imaginary parts. Calls func(y, x, value)
+// for every output of the valid region.
+template <class Func>
+void fft_tiles(const execution_t& policy, const padded_source_t& src, const fft_spectrum_t& spectrum, Func&& func)
+{
+    const extent_base_t kh = spectrum.window[0];
+    const extent_base_t kw = spectrum.window[1];
+    const extent_base_t src_h = src.extent()[0];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src_h - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+
+    const std::size_t n = spectrum.size;
+    const auto size = static_cast<extent_base_t>(n);
+    const extent_base_t block_h = size - kh + 1;
+    const extent_base_t block_w = size - kw + 1;
+    const extent_base_t tile_rows = (h + block_h - 1) / block_h;
+    const extent_base_t tile_columns = (w + block_w - 1) / block_w;
+    const fft_plan_t plan{ n };
+
+    for_each_band(
+        policy,
+        tile_rows,
+        [&](location_base_t first, location_base_t last)
+        {
+            std::vector<std::uint8_t> lines(n * static_cast<std::size_t>(src_w));
+            std::vector<complex_t> data(n * n);
+            std::vector<complex_t> column;
+
+            for (location_base_t tile_row = first; tile_row < last; ++tile_row)
+            {
+                const location_base_t y0 = tile_row * block_h;
+                const extent_base_t rows = std::min(size, src_h - y0);
+                for (location_base_t r = 0; r < rows; ++r)
+                {
+                    src.load(y0 + r, lines.data() + static_cast<std::size_t>(r) * static_cast<std::size_t>(src_w));
+                }
+
+                for (location_base_t tile = 0; tile < tile_columns; tile += 2)
+                {
+                    std::fill(data.begin(), data.end(), complex_t{});
+                    for (location_base_t part = 0; part < 2 && tile + part < tile_columns; ++part)
+                    {
+                        const location_base_t x0 = (tile + part) * block_w;
+                        const extent_base_t columns = std::min(size, src_w - x0);
+                        for (location_base_t r = 0; r < rows; ++r)
+                        {
+                            const std::uint8_t* line = lines.data() + r * src_w + x0;
+                            complex_t* out = data.data() + static_cast<std::size_t>(r) * n;
+                            for (location_base_t c = 0; c < columns; ++c)
+                            {
+                                const auto value = static_cast<float>(line[c]);
+                                out[c] = part == 0 ? complex_t{ value, out[c].imag() } : complex_t{ out[c].real(), value };
+                            }
+                        }
+                    }
+
+                    plan.transform_2d(data.data(), column);
+                    for (std::size_t i = 0; i < data.size(); ++i)
+                    {
+                        const complex_t a = data[i];
+                        const complex_t b = spectrum.values[i];
+                        data[i] = complex_t{ a.real() * b.real() - a.imag() * b.imag(),
+                                             a.real() * b.imag() + a.imag() * b.real() };
+                    }
+                    plan.transform_2d(data.data(), column, true);
+
+                    for (location_base_t part = 0; part < 2 && tile + part < tile_columns; ++part)
+                    {
+                        const location_base_t x0 = (tile + part) * block_w;
+                        const extent_base_t out_h = std::min(block_h, h - y0);
+                        const extent_base_t out_w = std::min(block_w, w - x0);
+                        for (location_base_t y = 0; y < out_h; ++y)
+                        {
+                            const complex_t* row = data.data() + static_cast<std::size_t>(y) * n;
+                            for (location_base_t x = 0; x < out_w; ++x)
+                            {
+                                func(y0 + y, x0 + x, part == 0 ? row[x].real() : row[x].imag());
+                            }
+                        }
+                    }
+                }
+            }
+        });
+}
+
+// Sliding-window order statistic over a kh x kw rectangle (Perreault-Hebert): every source column keeps a histogram
+// of its kh rows, the window histogram moves along x by adding one column and removing another, and a 16-bin coarse
+// level narrows the rank search. Calls func(y, row) with the index-th smallest value of every window in row y.
+template <class Func>
+void percentile_rows(
+    const execution_t& policy,
+    const padded_source_t& src,
+    const extent_t<2, extent_base_t>& window,
+    std::size_t index,
+    Func&& func)
+{
+    using count_t = std::uint16_t;
+    static constexpr std::size_t bins = 256;
+    static constexpr std::size_t coarse_bins = 16;
+    static constexpr std::size_t coarse_shift = 4;
+
+    const extent_base_t kh = window[0];
+    const extent_base_t kw = window[1];
+    const extent_base_t src_w = src.extent()[1];
+    const extent_base_t h = src.extent()[0] - kh + 1;
+    const extent_base_t w = src_w - kw + 1;
+    if (h <= 0 || w <= 0)
+    {
+        return;
+    }
+    if (kh * kw > std::numeric_limits<count_t>::max())
+    {
+        throw std::invalid_argument{ format("percentile_rows: window ", window, " is too large") };
+    }
+
+    const auto columns = static_cast<std::size_t>(src_w);
+
+    for_each_band(
+        policy,
+        h,
+        [&](location_base_t first, location_base_t last)
+        {
+            std::vector<count_t> fine(columns * bins);
+            std::vector<count_t> coarse(columns * coarse_bins);
+            std::array<count_t, bins> window_fine = {};
+            std::array<count_t, coarse_bins> window_coarse = {};
+            std::vector<std::uint8_t> out(static_cast<std::size_t>(w));
+
+            std::vector<std::uint8_t> line(columns);
+
+            const auto update_row = [&](location_base_t y, int delta)
+            {
+                src.load(y, line.data());
+                for (std::size_t x = 0; x < columns; ++x)
+                {
+                    const std::size_t value = line[x];
+                    fine[x * bins + value] = static_cast<count_t>(fine[x * bins + value] + delta);
+                    coarse[x * coarse_bins + (value >> coarse_shift)]
+                        = static_cast<count_t>(coarse[x * coarse_bins + (value >> coarse_shift)] + delta);
+                }
+            };
+
+            // window += column[add] - column[remove]; unsigned wrap-around keeps intermediate values exact
+            const auto move_window = [&](std::size_t add, std::size_t remove)
+            {
+                const count_t* add_fine = fine.data() + add * bins;
+                const count_t* remove_fine = fine.data() + remove * bins;
+                for (std::size_t b = 0; b < bins; ++b)
+                {
+                    window_fine[b] = static_cast<count_t>(window_fine[b] + add_fine[b] - remove_fine[b]);
+                }
+                const count_t* add_coarse = coarse.data() + add * coarse_bins;
+                const count_t* remove_coarse = coarse.data() + remove * coarse_bins;
+                for (std::size_t b = 0; b < coarse_bins; ++b)
+                {
+                    window_coarse[b] = static_cast<count_t>(window_coarse[b] + add_coarse[b] - remove_coarse[b]);
+                }
+            };
+
+            const auto select = [&]() -> std::uint8_t
+            {
+                std::size_t remaining = index;
+                std::size_t c = 0;
+                while (window_coarse[c] <= remaining)
+                {
+                    remaining -= window_coarse[c++];
+                }
+                std::size_t b = c << coarse_shift;
+                while (window_fine[b] <= remaining)
+                {
+                    remaining -= window_fine[b++];
+                }
+                return static_cast<std::uint8_t>(b);
+            };
+
+            for (location_base_t r = first; r < first + kh; ++r)
+            {
+                update_row(r, +1);
+            }
+
+            for (location_base_t y = first; y < last; ++y)
+            {
+                if (y != first)
+                {
+                    update_row(y - 1, -1);
+                    update_row(y + kh - 1, +1);
+                }
+
+                window_fine.fill(0);
+                window_coarse.fill(0);
+                for (std::size_t x = 0; x < static_cast<std::size_t>(kw); ++x)
+                {
+                    std::transform(
+                        window_fine.begin(), window_fine.end(), fine.data() + x * bins, window_fine.begin(), std::plus<>{});
+                    std::transform(
+                        window_coarse.begin(),
+                        window_coarse.end(),
+                        coarse.data() + x * coarse_bins,
+                        window_coarse.begin(),
+                        std::plus<>{});
+                }
+
+                for (std::size_t x = 0; x < out.size(); ++x)
+                {
+                    if (x != 0)
+                    {
+                        move_window(x + static_cast<std::size_t>(kw) - 1, x - 1);
+                    }
+                    out[x] = select();
+                }
+                func(y, out.data());
+            }
+        });
+}
+
+}  // namespace detail
+
+}  // namespace mat
+}  // namespace zx
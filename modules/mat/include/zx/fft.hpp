@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <zx/format.hpp>
+
+namespace zx
+{
+namespace mat
+{
+
+using complex_t = std::complex<float>;
+
+// Iterative radix-2 FFT of a fixed power-of-two size. The inverse transform is not normalized.
+struct fft_plan_t
+{
+    std::size_t m_size;
+    std::vector<complex_t> m_twiddles;
+    std::vector<std::size_t> m_reversed;
+
+    explicit fft_plan_t(std::size_t size) : m_size{ size }, m_twiddles(size / 2), m_reversed(size)
+    {
+        if (size == 0 || (size & (size - 1)) != 0)
+        {
+            throw std::invalid_argument{ format("fft: size ", size, " is not a power of two") };
+        }
+
+        const double pi = std::acos(-1.0);
+        for (std::size_t i = 0; i < m_twiddles.size(); ++i)
+        {
+            const double angle = -2.0 * pi * static_cast<double>(i) / static_cast<double>(size);
+            m_twiddles[i] = complex_t{ static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+        }
+
+        std::size_t bits = 0;
+        while ((std::size_t{ 1 } << bits) < size)
+        {
+            ++bits;
+        }
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            std::size_t reversed = 0;
+            for (std::size_t b = 0; b < bits; ++b)
+            {
+                reversed |= ((i >> b) & 1U) << (bits - 1 - b);
+            }
+            m_reversed[i] = reversed;
+        }
+    }
+
+    std::size_t size() const { return m_size; }
+
+    void operator()(complex_t* data, bool inverse = false) const
+    {
+        for (std::size_t i = 0; i < m_size; ++i)
+        {
+            const std::size_t j = m_reversed[i];
+            if (i < j)
+            {
+                std::swap(data[i], data[j]);
+            }
+        }
+
+        const float sign = inverse ? -1.F : 1.F;
+        for (std::size_t length = 2; length <= m_size; length <<= 1)
+        {
+            const std::size_t half = length / 2;
+            const std::size_t step = m_size / length;
+            for (std::size_t i = 0; i < m_size; i += length)
+            {
+                for (std::size_t k = 0; k < half; ++k)
+                {
+                    const complex_t w = m_twiddles[k * step];
+                    const float w_re = w.real();
+                    const float w_im = sign * w.imag();
+                    const complex_t u = data[i + k];
+                    const complex_t v = data[i + k + half];
+                    const complex_t t{ v.real() * w_re - v.imag() * w_im, v.real() * w_im + v.imag() * w_re };
+                    data[i + k] = complex_t{ u.real() + t.real(), u.imag() + t.imag() };
+                    data[i + k + half] = complex_t{ u.real() - t.real(), u.imag() - t.imag() };
+                }
+            }
+        }
+    }
+
+    // Transforms a row-major size x size block: rows first, then columns through the column buffer.
+    void transform_2d(complex_t* data, std::vector<complex_t>& column, bool inverse = false) const
+    {
+        for (std::size_t r = 0; r < m_size; ++r)
+        {
+            (*this)(data + r * m_size, inverse);
+        }
+
+        column.resize(m_size);
+        for (std::size_t c = 0; c < m_size; ++c)
+        {
+            for (std::size_t r = 0; r < m_size; ++r)
+            {
+                column[r] = data[r * m_size + c];
+            }
+            (*this)(column.data(), inverse);
+            for (std::size_t r = 0; r < m_size; ++r)
+            {
+                data[r * m_size + c] = column[r];
+            }
+        }
+    }
+};
+
+namespace detail
+{
+
+inline std::size_t next_power_of_two(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+}  // namespace detail
+
+}  // namespace mat
+}  // namespace zx
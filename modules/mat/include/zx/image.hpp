@@ -4,9 +4,13 @@
 #include <cstdint>
 #include <fstream>
 #include <zx/array.hpp>
+#include <zx/array_expr.hpp>
 #include <zx/colors.hpp>
+#include <zx/convolution.hpp>
 #include <zx/format.hpp>
 #include <zx/function_ref.hpp>
+#include <zx/mat/matrix.hpp>
+#include <zx/parallel.hpp>
 #include <zx/raster.hpp>
 
 namespace zx
@@ -28,6 +32,200 @@ struct filepath_t
     friend std::ostream& operator<<(std::ostream& os, const filepath_t& item) { return os << item.m_path; }
 };
 
+enum class image_layout_t
+{
+    // channels of a pixel are adjacent
+    interleaved,
+    // each channel is a separate contiguous plane
+    planar,
+};
+
+inline std::ostream& operator<<(std::ostream& os, image_layout_t item)
+{
+    switch (item)
+    {
+        case image_layout_t::interleaved: return os << "interleaved";
+        case image_layout_t::planar: return os << "planar";
+    }
+    return os;
+}
+
+enum class resize_filter_t
+{
+    box,
+    bilinear,
+    lanczos,
+};
+
+inline std::ostream& operator<<(std::ostream& os, resize_filter_t item)
+{
+    switch (item)
+    {
+        case resize_filter_t::box: return os << "box";
+        case resize_filter_t::bilinear: return os << "bilinear";
+        case resize_filter_t::lanczos: return os << "lanczos";
+    }
+    return os;
+}
+
+enum class interpolation_t
+{
+    nearest,
+    bilinear,
+    bicubic,
+};
+
+inline std::ostream& operator<<(std::ostream& os, interpolation_t item)
+{
+    switch (item)
+    {
+        case interpolation_t::nearest: return os << "nearest";
+        case interpolation_t::bilinear: return os << "bilinear";
+        case interpolation_t::bicubic: return os << "bicubic";
+    }
+    return os;
+}
+
+namespace detail
+{
+
+// a planar image with a single column or pixel has equal plane and column strides, an interleaved one never does
+template <class Shape>
+image_layout_t image_layout(const Shape& shape)
+{
+    return std::abs(shape.dim(2).stride) >= std::abs(shape.dim(1).stride) ? image_layout_t::planar
+                                                                            : image_layout_t::interleaved;
+}
+
+// rows of the view are further apart in memory than its columns, as after a quarter turn
+template <class Shape>
+bool is_transposed(const Shape& shape)
+{
+    return std::abs(shape.dim(1).stride) > std::abs(shape.dim(0).stride);
+}
+
+// Copies a height x width plane of elements of Size contiguous bytes from a source whose rows are transposed in
+// memory. Strips of 64 rows are copied in 8 x 8 blocks going down each column of blocks, so that a source cache line
+// is used up before it is evicted. Byte blocks are transposed in registers when the source steps by one byte along y
+// and the destination along x.
+template <location_base_t Size = 1>
+void copy_plane_transposed(
+    byte_t* dst,
+    flat_offset_t dst_y,
+    flat_offset_t dst_x,
+    const byte_t* src,
+    flat_offset_t src_y,
+    flat_offset_t src_x,
+    extent_base_t height,
+    extent_base_t width)
+{
+    const bool registers = Size == 1 && std::abs(src_y) == 1 && dst_x == 1;
+    static constexpr location_base_t block = 8;
+    static constexpr location_base_t strip = 64;
+    for (location_base_t y0 = 0; y0 < height; y0 += strip)
+    {
+        const location_base_t y1 = std::min(y0 + strip, height);
+        for (location_base_t x = 0; x < width; x += block)
+        {
+            const location_base_t x_end = std::min(x + block, width);
+            for (location_base_t y = y0; y < y1; y += block)
+            {
+                const location_base_t y_end = std::min(y + block, y1);
+                if (registers && x_end - x == block && y_end - y == block)
+                {
+                    // a reversed source is read from the last row of the block, which is written upwards
+                    const location_base_t first = src_y > 0 ? y : y_end - 1;
+                    simd::transpose_8x8(
+                        src + first * src_y + x * src_x, src_x, dst + first * dst_y + x * dst_x, src_y * dst_y);
+                    continue;
+                }
+                for (location_base_t yy = y; yy < y_end; ++yy)
+                {
+                    for (location_base_t xx = x; xx < x_end; ++xx)
+                    {
+                        std::copy_n(src + yy * src_y + xx * src_x, Size, dst + yy * dst_y + xx * dst_x);
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void copy_pixels(array_mut_view_t<byte_t, 3> dst, array_view_t<byte_t, 3> src)
+{
+    if (dst.extent() != src.extent())
+    {
+        throw std::invalid_argument{ "Source and destination sizes do not match" };
+    }
+
+    if (is_transposed(src.shape()) && !is_transposed(dst.shape()))
+    {
+        const shape_t<3>& s = src.shape();
+        const shape_t<3>& d = dst.shape();
+        if (s.dim(2).extent == 3 && s.dim(2).stride == 1 && d.dim(2).stride == 1)
+        {
+            copy_plane_transposed<3>(
+                dst.from_offset(0),
+                d.dim(0).stride,
+                d.dim(1).stride,
+                src.from_offset(0),
+                s.dim(0).stride,
+                s.dim(1).stride,
+                s.dim(0).extent,
+                s.dim(1).extent);
+            return;
+        }
+        for (location_base_t z = 0; z < src.extent()[2]; ++z)
+        {
+            copy_plane_transposed(
+                dst.from_offset(flat_offset_t{ z } * dst.shape().dim(2).stride),
+                dst.shape().dim(0).stride,
+                dst.shape().dim(1).stride,
+                src.from_offset(flat_offset_t{ z } * src.shape().dim(2).stride),
+                src.shape().dim(0).stride,
+                src.shape().dim(1).stride,
+                src.extent()[0],
+                src.extent()[1]);
+        }
+        return;
+    }
+
+    const extent_base_t height = src.extent()[0];
+    const extent_base_t width = src.extent()[1];
+    const extent_base_t channels = src.extent()[2];
+    const dim_t& dst_x = dst.shape().dim(1);
+    const dim_t& dst_z = dst.shape().dim(2);
+    const dim_t& src_x = src.shape().dim(1);
+    const dim_t& src_z = src.shape().dim(2);
+
+    for (location_base_t y = 0; y < height; ++y)
+    {
+        const byte_t* src_row = src.from_offset(flat_offset_t{ y } * src.shape().dim(0).stride);
+        byte_t* dst_row = dst.from_offset(flat_offset_t{ y } * dst.shape().dim(0).stride);
+        for (location_base_t z = 0; z < channels; ++z)
+        {
+            const byte_t* s = src_row + flat_offset_t{ z } * src_z.stride;
+            byte_t* d = dst_row + flat_offset_t{ z } * dst_z.stride;
+            if (dst_x.stride == 1)
+            {
+                for (location_base_t x = 0; x < width; ++x)
+                {
+                    d[x] = s[flat_offset_t{ x } * src_x.stride];
+                }
+            }
+            else
+            {
+                for (location_base_t x = 0; x < width; ++x)
+                {
+                    d[flat_offset_t{ x } * dst_x.stride] = s[flat_offset_t{ x } * src_x.stride];
+                }
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
 template <extent_base_t Channels>
 struct image_base_t
 {
@@ -94,6 +292,8 @@ struct image_base_t
 
         extent_base_t channel_count() const { return m_data.extent()[2]; }
 
+        image_layout_t layout() const { return detail::image_layout(m_data.shape()); }
+
         channel_type::view_type channel(std::size_t channel_index) const
         {
             // return channel_type::view_type{ m_data.data() + channel_index, m_data.shape().erase(2) };
@@ -128,6 +328,8 @@ struct image_base_t
 
         extent_base_t channel_count() const { return m_data.extent()[2]; }
 
+        image_layout_t layout() const { return detail::image_layout(m_data.shape()); }
+
         channel_type::mut_view_type channel(std::size_t channel_index) const
         {
             // return channel_type::mut_view_type{ m_data.data() + channel_index, m_data.shape().erase(2) };
@@ -154,13 +356,27 @@ struct image_base_t
     storage_type::mut_view_type mut_data() { return m_data.mut_view(); }
     storage_type::view_type data() const { return m_data.view(); }
 
-    image_base_t(const storage_type::extent_type& extent) : m_data{ extent } { }
-    image_base_t(const extent_type& extent) : image_base_t{ append(extent, Channels) } { }
-    image_base_t(const view_type& view) : m_data{ view.data() } { }
+    image_base_t(const storage_type::extent_type& extent, image_layout_t layout = image_layout_t::interleaved)
+        : m_data{ extent, dimension_order(layout) }
+    {
+    }
+
+    image_base_t(const extent_type& extent, image_layout_t layout = image_layout_t::interleaved)
+        : image_base_t{ append(extent, Channels), layout }
+    {
+    }
+
+    image_base_t(const view_type& view, image_layout_t layout) : image_base_t{ view.data().extent(), layout }
+    {
+        detail::copy_pixels(m_data.mut_view(), view.data());
+    }
+
+    image_base_t(const view_type& view) : image_base_t{ view, view.layout() } { }
 
     extent_type extent() const { return view().extent(); }
     bounds_type bounds() const { return view().bounds(); }
     extent_base_t channel_count() const { return view().channel_count(); }
+    image_layout_t layout() const { return view().layout(); }
 
     operator view_type() const { return view(); }
     operator mut_view_type() { return mut_view(); }
@@ -173,6 +389,13 @@ struct image_base_t
 
     true_color_t operator[](const location_type& loc) const { return view()[loc]; }
     proxy_t operator[](const location_type& loc) { return mut_view()[loc]; }
+
+private:
+    static std::array<std::size_t, 3> dimension_order(image_layout_t layout)
+    {
+        return layout == image_layout_t::planar ? std::array<std::size_t, 3>{ 2, 0, 1 }
+                                                : std::array<std::size_t, 3>{ 0, 1, 2 };
+    }
 };
 
 using rgb_image_t = image_base_t<3>;
@@ -182,6 +405,129 @@ using mask_t = array_t<float, 2>;
 
 using segment_type = segment_t<2, location_base_t>;
 using circle_type = circle_t<location_base_t>;
+using polygon_type = polygon_t<2, location_base_t>;
+
+// The parts of an image changed since the last clear(), kept as a grid of tile x tile blocks. Marking a region costs
+// one flag per block it covers; rows() and rectangles() return the marked blocks merged and clipped to the image.
+struct dirty_region_t
+{
+    extent_t<2, extent_base_t> m_extent;
+    extent_base_t m_tile;
+    extent_t<2, extent_base_t> m_tiles;
+    std::vector<bool> m_dirty;
+
+    explicit dirty_region_t(const extent_t<2, extent_base_t>& extent, extent_base_t tile = 64)
+        : m_extent{ extent }
+        , m_tile{ tile }
+        , m_tiles{}
+    {
+        if (tile <= 0 || extent[0] < 0 || extent[1] < 0)
+        {
+            throw std::invalid_argument{ str("dirty_region_t: invalid extent ", extent, " or tile ", tile) };
+        }
+        for (std::size_t d = 0; d < 2; ++d)
+        {
+            m_tiles[d] = (extent[d] + tile - 1) / tile;
+        }
+        m_dirty.resize(static_cast<std::size_t>(m_tiles[0]) * static_cast<std::size_t>(m_tiles[1]));
+    }
+
+    extent_t<2, extent_base_t> extent() const { return m_extent; }
+
+    extent_base_t tile() const { return m_tile; }
+
+    bool empty() const { return std::none_of(m_dirty.begin(), m_dirty.end(), [](bool dirty) { return dirty; }); }
+
+    void clear() { std::fill(m_dirty.begin(), m_dirty.end(), false); }
+
+    void add_all() { std::fill(m_dirty.begin(), m_dirty.end(), true); }
+
+    // bounds outside of the image are ignored
+    void add(const bounds_t<2>& bounds)
+    {
+        std::array<interval_type, 2> tiles;
+        for (std::size_t d = 0; d < 2; ++d)
+        {
+            const extent_base_t lower = std::max(bounds[d][0], extent_base_t{ 0 });
+            const extent_base_t upper = std::min(bounds[d][1], m_extent[d]);
+            if (lower >= upper)
+            {
+                return;
+            }
+            tiles[d] = interval_type{ lower / m_tile, (upper - 1) / m_tile + 1 };
+        }
+        for (location_base_t y = tiles[0][0]; y < tiles[0][1]; ++y)
+        {
+            for (location_base_t x = tiles[1][0]; x < tiles[1][1]; ++x)
+            {
+                m_dirty[index(y, x)] = true;
+            }
+        }
+    }
+
+    // disjoint row intervals in increasing order that contain a marked block
+    std::vector<interval_type> rows() const
+    {
+        std::vector<interval_type> result;
+        for (location_base_t y = 0; y < m_tiles[0]; ++y)
+        {
+            const auto first = m_dirty.begin() + static_cast<std::ptrdiff_t>(index(y, 0));
+            if (std::none_of(first, first + m_tiles[1], [](bool dirty) { return dirty; }))
+            {
+                continue;
+            }
+            const interval_type rows = tile_span(0, y, y + 1);
+            if (!result.empty() && result.back()[1] == rows[0])
+            {
+                result.back()[1] = rows[1];
+            }
+            else
+            {
+                result.push_back(rows);
+            }
+        }
+        return result;
+    }
+
+    // disjoint rectangles, one for every horizontal run of marked blocks in a row of blocks
+    std::vector<bounds_t<2>> rectangles() const
+    {
+        std::vector<bounds_t<2>> result;
+        for (location_base_t y = 0; y < m_tiles[0]; ++y)
+        {
+            location_base_t x = 0;
+            while (x < m_tiles[1])
+            {
+                if (!m_dirty[index(y, x)])
+                {
+                    ++x;
+                    continue;
+                }
+                const location_base_t first = x;
+                while (x < m_tiles[1] && m_dirty[index(y, x)])
+                {
+                    ++x;
+                }
+                bounds_t<2> bounds;
+                bounds[0] = tile_span(0, y, y + 1);
+                bounds[1] = tile_span(1, first, x);
+                result.push_back(bounds);
+            }
+        }
+        return result;
+    }
+
+private:
+    std::size_t index(location_base_t y, location_base_t x) const
+    {
+        return static_cast<std::size_t>(y) * static_cast<std::size_t>(m_tiles[1]) + static_cast<std::size_t>(x);
+    }
+
+    interval_type tile_span(std::size_t d, location_base_t first, location_base_t last) const
+    {
+        return interval_type{ first * m_tile, std::min(last * m_tile, m_extent[d]) };
+    }
+};
 
 namespace detail
 {
@@ -202,10 +548,8 @@ T read(std::istream& is)
 
 inline void write_n(std::ostream& os, std::size_t count, byte_t value = 0)
 {
-    for (std::size_t i = 0; i < count; ++i)
-    {
-        write<byte_t>(os, value);
-    }
+    const std::vector<char> buffer(count, static_cast<char>(value));
+    os.write(buffer.data(), static_cast<std::streamsize>(count));
 }
 
 inline auto get_padding(std::size_t width, std::size_t bits_per_pixel) -> std::size_t
@@ -335,187 +679,498 @@ inline void save_header(
     dib_hdr.save(os);
 }
 
-struct load_bitmap_fn
+// Row buffers hold the pixels of one row in file order (bgr, 3 bytes each) followed by the row padding.
+inline void decode_bgr_row(const byte_t* line, const rgb_image_t::mut_view_type& row)
 {
-    auto operator()(std::istream& is) const -> rgb_image_t
+    const shape_t<3>& shape = row.m_data.shape();
+    const extent_base_t w = shape.dim(1).extent;
+    byte_t* out = row.m_data.from_offset(0);
+    if (shape.dim(1).stride == 3 && shape.dim(2).stride == 1)
     {
-        if (!is)
-        {
-            throw std::runtime_error{ "load_bitmap: invalid stream" };
-        }
-
-        const bmp_header bmp_hdr = bmp_header::load(is);
-        const dib_header dib_hdr = dib_header::load(is);
-
-        (void)bmp_hdr;
-
-        switch (dib_hdr.bits_per_pixel)
-        {
-            case 8: return load_bitmap_8(is, dib_hdr);
-            case 24: return load_bitmap_24(is, dib_hdr);
-            default: throw std::runtime_error{ "load_bitmap: format not supported" };
-        }
+        simd::swap_rb(line, out, static_cast<std::size_t>(w));
+        return;
     }
-
-    auto operator()(const filepath_t& path) const -> rgb_image_t
+    for (location_base_t x = 0; x < w; ++x)
     {
-        std::ifstream fs(path.c_str(), std::ifstream::binary);
-        if (!fs)
+        for (location_base_t z = 0; z < 3; ++z)
         {
-            throw std::runtime_error{ str("load_bitmap: can not load file '", path, "'") };
+            out[flat_offset_t{ x } * shape.dim(1).stride + flat_offset_t{ z } * shape.dim(2).stride] = line[3 * x + 2 - z];
         }
-        return (*this)(fs);
     }
+}
 
-    static auto prepare_array(const dib_header& header) -> rgb_image_t
+inline void encode_bgr_row(const rgb_image_t::view_type& row, byte_t* line)
+{
+    const shape_t<3>& shape = row.m_data.shape();
+    const extent_base_t w = shape.dim(1).extent;
+    const byte_t* in = row.m_data.from_offset(0);
+    if (shape.dim(1).stride == 3 && shape.dim(2).stride == 1)
     {
-        return rgb_image_t{ rgb_image_t::extent_type{ static_cast<extent_base_t>(header.height),
-                                                      static_cast<extent_base_t>(header.width) } };
+        simd::swap_rb(in, line, static_cast<std::size_t>(w));
+        return;
     }
-
-    static auto read_color(std::istream& is) -> true_color_t
+    for (location_base_t x = 0; x < w; ++x)
     {
-        true_color_t result = {};
-        result[2] = read<byte_t>(is);
-        result[1] = read<byte_t>(is);
-        result[0] = read<byte_t>(is);
-        return result;
+        for (location_base_t z = 0; z < 3; ++z)
+        {
+            line[3 * x + 2 - z] = in[flat_offset_t{ x } * shape.dim(1).stride + flat_offset_t{ z } * shape.dim(2).stride];
+        }
     }
+}
 
-    static auto load_bitmap_8(std::istream& is, const dib_header& header) -> rgb_image_t
-    {
-        const auto padding = get_padding(header.width, header.bits_per_pixel);
+// Decodes one row at a time, in file order (bottom-up).
+struct bitmap_reader_t
+{
+    std::istream& m_is;
+    dib_header m_header;
+    std::array<true_color_t, 256> m_palette = {};
+    std::vector<byte_t> m_line;
 
-        rgb_image_t result = prepare_array(header);
-        auto view = result.mut_view();
+    explicit bitmap_reader_t(std::istream& is) : m_is{ is }
+    {
+        if (!m_is)
+        {
+            throw std::runtime_error{ "load_bitmap: invalid stream" };
+        }
 
-        using palette_t = std::array<true_color_t, 256>;
-        palette_t palette = {};
+        bmp_header::load(m_is);
+        m_header = dib_header::load(m_is);
 
-        for (std::size_t i = 0; i < 256; ++i)
+        if (m_header.bits_per_pixel != 8 && m_header.bits_per_pixel != 24)
         {
-            palette[i] = read_color(is);
-            is.ignore(1);
+            throw std::runtime_error{ "load_bitmap: format not supported" };
         }
 
-        const auto [h, w] = view.extent();
-
-        for (location_base_t y = h - 1; y >= 0; --y)
+        if (m_header.bits_per_pixel == 8)
         {
-            for (location_base_t x = 0; x < w; ++x)
+            std::array<byte_t, 4 * 256> entries = {};
+            read_bytes(entries.data(), entries.size());
+            for (std::size_t i = 0; i < 256; ++i)
             {
-                view[rgb_image_t::location_type{ y, x }] = palette.at(read<byte_t>(is));
+                m_palette[i] = true_color_t{ entries[4 * i + 2], entries[4 * i + 1], entries[4 * i] };
             }
-
-            is.ignore(static_cast<std::streamsize>(padding));
         }
 
-        return result;
+        m_line.resize(m_header.width * m_header.bits_per_pixel / 8 + get_padding(m_header.width, m_header.bits_per_pixel));
     }
 
-    static auto load_bitmap_24(std::istream& is, const dib_header& header) -> rgb_image_t
+    rgb_image_t::extent_type extent() const
     {
-        const auto padding = get_padding(header.width, header.bits_per_pixel);
-
-        rgb_image_t result = prepare_array(header);
-        auto view = result.mut_view();
+        return { static_cast<extent_base_t>(m_header.height), static_cast<extent_base_t>(m_header.width) };
+    }
 
-        const auto [h, w] = view.extent();
+    void read_row(const rgb_image_t::mut_view_type& row)
+    {
+        read_bytes(m_line.data(), m_line.size());
+        if (m_header.bits_per_pixel == 24)
+        {
+            decode_bgr_row(m_line.data(), row);
+            return;
+        }
 
-        for (location_base_t y = h - 1; y >= 0; --y)
+        const auto w = static_cast<location_base_t>(m_header.width);
+        for (location_base_t x = 0; x < w; ++x)
         {
-            for (location_base_t x = 0; x < w; ++x)
-            {
-                view[rgb_image_t::location_type{ y, x }] = read_color(is);
-            }
+            row[{ 0, x }] = m_palette[m_line[static_cast<std::size_t>(x)]];
+        }
+    }
 
-            is.ignore(static_cast<std::streamsize>(padding));
+    void read_bytes(byte_t* data, std::size_t count)
+    {
+        m_is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count));
+        if (m_is.gcount() != static_cast<std::streamsize>(count))
+        {
+            throw std::runtime_error{ "load_bitmap: unexpected end of stream" };
         }
-        return result;
     }
 };
 
-struct save_bitmap_fn
+struct load_bitmap_fn
 {
-    void operator()(const rgb_image_t::view_type& image, std::ostream& os) const
+    auto operator()(std::istream& is) const -> rgb_image_t
     {
-        static const std::size_t bits_per_pixel = 24;
-
-        const auto [h, w] = image.extent();
-
-        const std::size_t padding = get_padding(static_cast<std::size_t>(w), bits_per_pixel);
+        bitmap_reader_t reader{ is };
+        rgb_image_t result{ reader.extent() };
+        auto view = result.mut_view();
+        for (location_base_t y = reader.extent()[0] - 1; y >= 0; --y)
+        {
+            reader.read_row(view.slice({ { y, y + 1 }, {} }));
+        }
+        return result;
+    }
 
-        save_header(os, static_cast<std::size_t>(w), static_cast<std::size_t>(h), padding, bits_per_pixel, 0);
+    auto operator()(const filepath_t& path) const -> rgb_image_t
+    {
+        std::ifstream fs = open(path);
+        return (*this)(fs);
+    }
 
-        for (location_base_t y = h - 1; y >= 0; --y)
+    static std::ifstream open(const filepath_t& path)
+    {
+        std::ifstream fs(path.c_str(), std::ifstream::binary);
+        if (!fs)
         {
-            for (location_base_t x = 0; x < w; ++x)
-            {
-                write_color(os, image[rgb_image_t::location_type{ y, x }]);
-            }
-
-            write_n(os, padding);
+            throw std::runtime_error{ str("load_bitmap: can not load file '", path, "'") };
         }
+        return fs;
     }
+};
 
-    static void write_color(std::ostream& os, const true_color_t& color)
+// Calls func(y, row) for every row in file order (bottom-up) without holding the whole image; row is a 1 x width view
+// valid only during the call. Returns the image extent.
+struct load_bitmap_rows_fn
+{
+    template <class Func>
+    auto operator()(std::istream& is, Func&& func) const -> rgb_image_t::extent_type
     {
-        write<byte_t>(os, color[2]);
-        write<byte_t>(os, color[1]);
-        write<byte_t>(os, color[0]);
+        bitmap_reader_t reader{ is };
+        rgb_image_t row{ rgb_image_t::extent_type{ 1, reader.extent()[1] } };
+        for (location_base_t y = reader.extent()[0] - 1; y >= 0; --y)
+        {
+            reader.read_row(row.mut_view());
+            func(y, row.view());
+        }
+        return reader.extent();
     }
 
-    void operator()(const rgb_image_t::view_type& image, const filepath_t& path) const
+    template <class Func>
+    auto operator()(const filepath_t& path, Func&& func) const -> rgb_image_t::extent_type
     {
-        std::ofstream fs(path.c_str(), std::ofstream::binary);
-        (*this)(image, fs);
+        std::ifstream fs = load_bitmap_fn::open(path);
+        return (*this)(fs, std::forward<Func>(func));
     }
 };
 
-template <class T>
-struct inject_t
+// Encodes one 24-bit row at a time, in file order (bottom-up).
+struct bitmap_writer_t
 {
-    T m_value;
+    static const inline std::size_t bits_per_pixel = 24;
 
-    constexpr inject_t(T value) : m_value{ std::move(value) } { }
+    std::ostream& m_os;
+    std::vector<byte_t> m_line;
 
-    template <class... Args>
-    constexpr const T& operator()(Args&&...) const
+    bitmap_writer_t(std::ostream& os, const rgb_image_t::extent_type& extent) : m_os{ os }
     {
-        return m_value;
+        const auto w = static_cast<std::size_t>(extent[1]);
+        const std::size_t padding = get_padding(w, bits_per_pixel);
+        save_header(m_os, w, static_cast<std::size_t>(extent[0]), padding, bits_per_pixel, 0);
+        m_line.resize(3 * w + padding);
     }
-};
 
-using color_filter_t = function_ref<rgb_color_t(const rgb_color_t&)>;
-using binary_color_filter_t = function_ref<rgb_color_t(const rgb_color_t&, const rgb_color_t&)>;
+    void write_row(const rgb_image_t::view_type& row)
+    {
+        encode_bgr_row(row, m_line.data());
+        m_os.write(reinterpret_cast<const char*>(m_line.data()), static_cast<std::streamsize>(m_line.size()));
+    }
+};
 
-template <std::size_t D>
-void for_each(const shape_t<D>& shape, function_ref<void(const location_t<2>&)> func)
+struct save_bitmap_fn
 {
-    const extent_base_t h = shape[0].extent;
-    const extent_base_t w = shape[1].extent;
-
-    for (location_base_t y = 0; y < h; ++y)
+    // transposed views, e.g. after rotate, are copied first instead of reading a column for every row
+    void operator()(const rgb_image_t::view_type& image, std::ostream& os) const
     {
-        for (location_base_t x = 0; x < w; ++x)
+        if (is_transposed(image.data().shape()))
         {
-            func(location_t<2>{ y, x });
+            return (*this)(rgb_image_t{ image, image_layout_t::interleaved }, os);
+        }
+        bitmap_writer_t writer{ os, image.extent() };
+        for (location_base_t y = image.extent()[0] - 1; y >= 0; --y)
+        {
+            writer.write_row(image.slice({ { y, y + 1 }, {} }));
         }
     }
-}
 
-struct modify_fn
-{
-    void operator()(
-        const rgb_image_t::mut_view_type& image, const rgb_image_t::location_type& loc, color_filter_t filter) const
+    void operator()(const rgb_image_t::view_type& image, const filepath_t& path) const
     {
-        image[loc] = filter(image[loc]);
+        std::ofstream fs(path.c_str(), std::ofstream::binary);
+        (*this)(image, fs);
     }
 
-    void operator()(const rgb_image_t::mut_view_type& image, color_filter_t filter) const
+    // Rewrites in place only the rows of a bitmap of image, saved earlier to stream, that hold a dirty block.
+    void operator()(const rgb_image_t::view_type& image, std::iostream& stream, const dirty_region_t& dirty) const
+    {
+        if (dirty.extent() != image.extent())
+        {
+            throw std::invalid_argument{ str("save_bitmap: dirty region ", dirty.extent(), " of image ", image.extent()) };
+        }
+        if (!holds_bitmap_of(stream, image.extent()))
+        {
+            throw std::runtime_error{ str("save_bitmap: the stream does not hold a bitmap of ", image.extent()) };
+        }
+        const auto w = static_cast<std::size_t>(image.extent()[1]);
+        const std::size_t padding = get_padding(w, bitmap_writer_t::bits_per_pixel);
+        const std::size_t data_offset = bmp_header::size + dib_header::size;
+        std::vector<byte_t> line(3 * w + padding);
+
+        for (const auto& rows : dirty.rows())
+        {
+            // file rows run bottom-up, so the last image row of the interval comes first
+            const auto first = static_cast<std::size_t>(image.extent()[0] - rows[1]);
+            stream.seekp(static_cast<std::streamoff>(data_offset + first * line.size()));
+            for (location_base_t y = rows[1] - 1; y >= rows[0]; --y)
+            {
+                encode_bgr_row(image.slice({ { y, y + 1 }, {} }), line.data());
+                stream.write(reinterpret_cast<const char*>(line.data()), static_cast<std::streamsize>(line.size()));
+            }
+        }
+        if (!stream)
+        {
+            throw std::runtime_error{ "save_bitmap: cannot update the bitmap" };
+        }
+    }
+
+    // files that are missing or hold a different bitmap are saved whole
+    void operator()(const rgb_image_t::view_type& image, const filepath_t& path, const dirty_region_t& dirty) const
+    {
+        std::fstream fs(path.c_str(), std::fstream::binary | std::fstream::in | std::fstream::out);
+        if (!fs || !holds_bitmap_of(fs, image.extent()))
+        {
+            fs.close();
+            return (*this)(image, path);
+        }
+        (*this)(image, fs, dirty);
+    }
+
+private:
+    // a header as written by save_bitmap for extent, followed by all of its rows
+    static bool holds_bitmap_of(std::istream& is, const rgb_image_t::extent_type& extent)
+    {
+        const auto w = static_cast<std::size_t>(extent[1]);
+        const auto h = static_cast<std::size_t>(extent[0]);
+        const std::size_t data_offset = bmp_header::size + dib_header::size;
+        const std::size_t row_size = 3 * w + get_padding(w, bitmap_writer_t::bits_per_pixel);
+
+        is.seekg(0);
+        const bmp_header bmp_hdr = bmp_header::load(is);
+        const dib_header dib_hdr = dib_header::load(is);
+        is.seekg(0, std::istream::end);
+        const std::streamoff size = is.tellg();
+        const bool result = is && bmp_hdr.data_offset == data_offset && dib_hdr.width == w && dib_hdr.height == h
+                            && dib_hdr.bits_per_pixel == bitmap_writer_t::bits_per_pixel && dib_hdr.compression == 0
+                            && size >= static_cast<std::streamoff>(data_offset + h * row_size);
+        is.clear();
+        return result;
+    }
+};
+
+// Calls func(y, row) to fill every row in file order (bottom-up) before it is written; row is a 1 x width view
+// valid only during the call.
+struct save_bitmap_rows_fn
+{
+    template <class Func>
+    void operator()(std::ostream& os, const rgb_image_t::extent_type& extent, Func&& func) const
+    {
+        bitmap_writer_t writer{ os, extent };
+        rgb_image_t row{ rgb_image_t::extent_type{ 1, extent[1] } };
+        for (location_base_t y = extent[0] - 1; y >= 0; --y)
+        {
+            func(y, row.mut_view());
+            writer.write_row(row.view());
+        }
+    }
+
+    template <class Func>
+    void operator()(const filepath_t& path, const rgb_image_t::extent_type& extent, Func&& func) const
+    {
+        std::ofstream fs(path.c_str(), std::ofstream::binary);
+        (*this)(fs, extent, std::forward<Func>(func));
+    }
+};
+
+template <class T>
+struct inject_t
+{
+    T m_value;
+
+    constexpr inject_t(T value) : m_value{ std::move(value) } { }
+
+    template <class... Args>
+    constexpr const T& operator()(Args&&...) const
+    {
+        return m_value;
+    }
+};
+
+using color_filter_t = function_ref<rgb_color_t(const rgb_color_t&)>;
+using binary_color_filter_t = function_ref<rgb_color_t(const rgb_color_t&, const rgb_color_t&)>;
+
+inline void apply_table(byte_t* data, stride_base_t stride, extent_base_t count, const std::array<byte_t, 256>& table)
+{
+    if (stride == 1)
+    {
+        for (location_base_t x = 0; x < count; ++x)
+        {
+            data[x] = table[data[x]];
+        }
+    }
+    else
+    {
+        for (location_base_t x = 0; x < count; ++x)
+        {
+            byte_t& v = data[flat_offset_t{ x } * stride];
+            v = table[v];
+        }
+    }
+}
+
+// function_ref forwards any arguments, so invocability alone would take it for a span filter
+template <class Filter>
+struct is_function_ref : std::false_type
+{
+};
+
+template <class Signature>
+struct is_function_ref<function_ref<Signature>> : std::true_type
+{
+};
+
+// filters::* provide span calls over packed rgb rows next to the per-color call taken by color_filter_t
+template <class Filter>
+static constexpr bool is_span_filter_v
+    = !is_function_ref<Filter>::value && std::is_invocable_v<const Filter&, byte_t*, std::size_t>;
+
+template <class Filter>
+static constexpr bool is_span_blend_v
+    = !is_function_ref<Filter>::value && std::is_invocable_v<const Filter&, byte_t*, const byte_t*, std::size_t>;
+
+inline bool is_packed_rgb(const shape_t<3>& shape)
+{
+    return shape.dim(1).stride == 3 && shape.dim(2).stride == 1;
+}
+
+inline void pack_rgb_row(const byte_t* row, const shape_t<3>& shape, byte_t* line)
+{
+    for (location_base_t x = 0; x < shape.dim(1).extent; ++x)
+    {
+        for (location_base_t z = 0; z < 3; ++z)
+        {
+            line[3 * x + z] = row[flat_offset_t{ x } * shape.dim(1).stride + flat_offset_t{ z } * shape.dim(2).stride];
+        }
+    }
+}
+
+inline void unpack_rgb_row(const byte_t* line, const shape_t<3>& shape, byte_t* row)
+{
+    for (location_base_t x = 0; x < shape.dim(1).extent; ++x)
+    {
+        for (location_base_t z = 0; z < 3; ++z)
+        {
+            row[flat_offset_t{ x } * shape.dim(1).stride + flat_offset_t{ z } * shape.dim(2).stride] = line[3 * x + z];
+        }
+    }
+}
+
+struct modify_fn
+{
+    void operator()(
+        const rgb_image_t::mut_view_type& image, const rgb_image_t::location_type& loc, color_filter_t filter) const
+    {
+        image[loc] = filter(image[loc]);
+    }
+
+    template <class Filter, std::enable_if_t<is_span_filter_v<Filter>, int> = 0>
+    void operator()(const rgb_image_t::mut_view_type& image, const Filter& filter) const
+    {
+        (*this)(execution::sequential(), image, filter);
+    }
+
+    // rows that are not packed rgb go through a packed copy
+    template <class Filter, std::enable_if_t<is_span_filter_v<Filter>, int> = 0>
+    void operator()(const execution_t& policy, const rgb_image_t::mut_view_type& image, const Filter& filter) const
+    {
+        const auto data = image.data();
+        const shape_t<3>& shape = data.shape();
+        const auto width = static_cast<std::size_t>(shape.dim(1).extent);
+        const bool packed = is_packed_rgb(shape);
+
+        for_each_band(
+            policy,
+            shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                std::vector<byte_t> line(packed ? 0 : 3 * width);
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    byte_t* row = data.from_offset(flat_offset_t{ y } * shape.dim(0).stride);
+                    if (packed)
+                    {
+                        filter(row, width);
+                        continue;
+                    }
+                    pack_rgb_row(row, shape, line.data());
+                    filter(line.data(), width);
+                    unpack_rgb_row(line.data(), shape, row);
+                }
+            });
+    }
+
+    void operator()(const rgb_image_t::mut_view_type& image, color_filter_t filter) const
     {
         for_each(image.data().shape(), [&](const rgb_image_t::location_type& loc) { (*this)(image, loc, filter); });
     }
+
+    void operator()(const execution_t& policy, const rgb_image_t::mut_view_type& image, color_filter_t filter) const
+    {
+        for_each(
+            policy, image.data().shape(), [&](const rgb_image_t::location_type& loc) { (*this)(image, loc, filter); });
+    }
+
+    // only the blocks marked in dirty
+    template <class Filter>
+    void operator()(const rgb_image_t::mut_view_type& image, const Filter& filter, const dirty_region_t& dirty) const
+    {
+        (*this)(execution::sequential(), image, filter, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& image,
+        const Filter& filter,
+        const dirty_region_t& dirty) const
+    {
+        for (const auto& bounds : dirty.rectangles())
+        {
+            (*this)(policy, image.slice(to_slice(bounds)), filter);
+        }
+    }
+
+    void operator()(const rgb_image_t::mut_view_type& image, const lookup_table_t& table) const
+    {
+        (*this)(execution::sequential(), image, table);
+    }
+
+    // the same table applies to every channel, so rows of an interleaved image and planes of a planar one are
+    // transformed as contiguous byte runs
+    void operator()(const execution_t& policy, const rgb_image_t::mut_view_type& image, const lookup_table_t& table) const
+    {
+        const std::array<byte_t, 256> bytes = table.to_bytes();
+        const auto data = image.data();
+        const shape_t<3>& shape = data.shape();
+        const extent_base_t width = shape.dim(1).extent;
+        const extent_base_t channels = shape.dim(2).extent;
+        const bool packed_rows = shape.dim(2).stride == 1 && shape.dim(1).stride == channels;
+
+        for_each_band(
+            policy,
+            shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    byte_t* row = data.from_offset(flat_offset_t{ y } * shape.dim(0).stride);
+                    if (packed_rows)
+                    {
+                        apply_table(row, 1, width * channels, bytes);
+                        continue;
+                    }
+                    for (location_base_t z = 0; z < channels; ++z)
+                    {
+                        apply_table(row + flat_offset_t{ z } * shape.dim(2).stride, shape.dim(1).stride, width, bytes);
+                    }
+                }
+            });
+    }
 };
 
 struct with_fn
@@ -529,8 +1184,225 @@ struct with_fn
     }
 };
 
+// Reads pixels of an image at fractional positions; a position is inside the image when it lies within the area
+// covered by its pixels, and neighbours beyond the edge repeat the edge pixels.
+struct image_sampler_t
+{
+    const byte_t* m_data;
+    flat_offset_t m_stride_y;
+    flat_offset_t m_stride_x;
+    flat_offset_t m_stride_z;
+    location_base_t m_height;
+    location_base_t m_width;
+    location_base_t m_channels;
+
+    explicit image_sampler_t(const rgb_image_t::view_type& image)
+        : m_data{ image.data().from_offset(0) }
+        , m_stride_y{ image.data().shape().dim(0).stride }
+        , m_stride_x{ image.data().shape().dim(1).stride }
+        , m_stride_z{ image.data().shape().dim(2).stride }
+        , m_height{ image.data().shape().dim(0).extent }
+        , m_width{ image.data().shape().dim(1).extent }
+        , m_channels{ image.data().shape().dim(2).extent }
+    {
+    }
+
+    bool contains(double x, double y) const
+    {
+        return x >= -0.5 && y >= -0.5 && x < static_cast<double>(m_width) - 0.5
+               && y < static_cast<double>(m_height) - 0.5;
+    }
+
+    const byte_t* pixel(location_base_t x, location_base_t y) const
+    {
+        return m_data + flat_offset_t{ std::clamp(y, 0, m_height - 1) } * m_stride_y
+               + flat_offset_t{ std::clamp(x, 0, m_width - 1) } * m_stride_x;
+    }
+
+    // positions inside the image are above -1, so truncation of the shifted value does not need std::floor
+    static location_base_t floor(double v) { return static_cast<location_base_t>(v + 1.0) - 1; }
+
+    // Keys cubic convolution weights (a = -0.5) of the pixels at -1, 0, 1 and 2 relative to the position
+    static std::array<float, 4> cubic_weights(float t)
+    {
+        const auto near = [](float d) { return (1.5F * d - 2.5F) * d * d + 1.F; };
+        const auto far = [](float d) { return ((-0.5F * d + 2.5F) * d - 4.F) * d + 2.F; };
+        return { far(1.F + t), near(t), near(1.F - t), far(2.F - t) };
+    }
+
+    template <interpolation_t Interpolation>
+    void operator()(double x, double y, byte_t* out, flat_offset_t out_stride) const
+    {
+        if (!contains(x, y))
+        {
+            return;
+        }
+
+        if constexpr (Interpolation == interpolation_t::nearest)
+        {
+            const byte_t* p = pixel(floor(x + 0.5), floor(y + 0.5));
+            for (location_base_t z = 0; z < m_channels; ++z)
+            {
+                out[z * out_stride] = p[z * m_stride_z];
+            }
+        }
+        else if constexpr (Interpolation == interpolation_t::bilinear)
+        {
+            const location_base_t x0 = floor(x);
+            const location_base_t y0 = floor(y);
+            const auto tx = static_cast<float>(x - x0);
+            const auto ty = static_cast<float>(y - y0);
+            const byte_t* p00 = pixel(x0, y0);
+            const byte_t* p01 = pixel(x0 + 1, y0);
+            const byte_t* p10 = pixel(x0, y0 + 1);
+            const byte_t* p11 = pixel(x0 + 1, y0 + 1);
+            for (location_base_t z = 0; z < m_channels; ++z)
+            {
+                const flat_offset_t o = z * m_stride_z;
+                const float top = static_cast<float>(p00[o]) + tx * static_cast<float>(p01[o] - p00[o]);
+                const float bottom = static_cast<float>(p10[o]) + tx * static_cast<float>(p11[o] - p10[o]);
+                out[z * out_stride] = static_cast<byte_t>(top + ty * (bottom - top) + 0.5F);
+            }
+        }
+        else
+        {
+            const location_base_t x0 = floor(x);
+            const location_base_t y0 = floor(y);
+            const std::array<float, 4> wx = cubic_weights(static_cast<float>(x - x0));
+            const std::array<float, 4> wy = cubic_weights(static_cast<float>(y - y0));
+            std::array<flat_offset_t, 4> columns = {};
+            std::array<const byte_t*, 4> rows = {};
+            for (std::size_t i = 0; i < 4; ++i)
+            {
+                const auto d = static_cast<location_base_t>(i) - 1;
+                columns[i] = flat_offset_t{ std::clamp(x0 + d, 0, m_width - 1) } * m_stride_x;
+                rows[i] = m_data + flat_offset_t{ std::clamp(y0 + d, 0, m_height - 1) } * m_stride_y;
+            }
+            for (location_base_t z = 0; z < m_channels; ++z)
+            {
+                float sum = 0.F;
+                for (std::size_t j = 0; j < 4; ++j)
+                {
+                    const byte_t* row = rows[j] + z * m_stride_z;
+                    sum += wy[j]
+                           * (wx[0] * static_cast<float>(row[columns[0]]) + wx[1] * static_cast<float>(row[columns[1]])
+                              + wx[2] * static_cast<float>(row[columns[2]]) + wx[3] * static_cast<float>(row[columns[3]]));
+                }
+                out[z * out_stride] = static_cast<byte_t>(std::clamp(sum, 0.F, 255.F) + 0.5F);
+            }
+        }
+    }
+};
+
+struct warp_affine_fn
+{
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const matrix_t<3, 3, float>& matrix,
+        interpolation_t interpolation = interpolation_t::bilinear) const
+    {
+        (*this)(execution::sequential(), dst, src, matrix, interpolation);
+    }
+
+    // The matrix maps (x, y) positions of src pixel centers to dst, in the row-vector convention of the rotation,
+    // translation and scale builders. Dst pixels whose position maps outside src are left unchanged.
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const matrix_t<3, 3, float>& matrix,
+        interpolation_t interpolation = interpolation_t::bilinear) const
+    {
+        const auto inverse = invert(matrix);
+        if (!inverse)
+        {
+            throw std::invalid_argument{ "warp_affine: matrix is not invertible" };
+        }
+        if (dst.channel_count() != src.channel_count())
+        {
+            throw std::invalid_argument{ "warp_affine: channel counts do not match" };
+        }
+
+        switch (interpolation)
+        {
+            case interpolation_t::nearest: return run<interpolation_t::nearest>(policy, dst, src, *inverse);
+            case interpolation_t::bilinear: return run<interpolation_t::bilinear>(policy, dst, src, *inverse);
+            case interpolation_t::bicubic: return run<interpolation_t::bicubic>(policy, dst, src, *inverse);
+        }
+    }
+
+private:
+    // the source position of each row starts from the matrix product and then moves by the first row of the
+    // inverse for every pixel
+    template <interpolation_t Interpolation>
+    static void run(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const matrix_t<3, 3, float>& inverse)
+    {
+        const image_sampler_t sampler{ src };
+        const auto data = dst.data();
+        const shape_t<3>& shape = data.shape();
+        const double step_x = inverse[{ 0, 0 }];
+        const double step_y = inverse[{ 0, 1 }];
+
+        for_each_band(
+            policy,
+            shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    double sx = y * double{ inverse[{ 1, 0 }] } + double{ inverse[{ 2, 0 }] };
+                    double sy = y * double{ inverse[{ 1, 1 }] } + double{ inverse[{ 2, 1 }] };
+                    byte_t* row = data.from_offset(flat_offset_t{ y } * shape.dim(0).stride);
+                    for (location_base_t x = 0; x < shape.dim(1).extent; ++x)
+                    {
+                        sampler.operator()<Interpolation>(
+                            sx, sy, row + flat_offset_t{ x } * shape.dim(1).stride, shape.dim(2).stride);
+                        sx += step_x;
+                        sy += step_y;
+                    }
+                }
+            });
+    }
+};
+
 struct rotate_fn
 {
+    auto operator()(const rgb_image_t::view_type& image, float degrees, interpolation_t interpolation) const -> rgb_image_t
+    {
+        return (*this)(execution::sequential(), image, degrees, interpolation);
+    }
+
+    // Rotates clockwise about the image center, as the quarter turns do. The result is large enough to hold the
+    // rotated image; pixels outside of it are black. The interpolation is required, so that an angle alone always
+    // selects the quarter turn views below.
+    auto operator()(
+        const execution_t& policy, const rgb_image_t::view_type& image, float degrees, interpolation_t interpolation) const
+        -> rgb_image_t
+    {
+        const float angle = degrees * math::pi<float> / 180.F;
+        const float c = std::abs(math::cos(angle));
+        const float s = std::abs(math::sin(angle));
+        const auto width = static_cast<float>(image.extent()[1]);
+        const auto height = static_cast<float>(image.extent()[0]);
+        // the tolerance keeps quarter turns from growing by a pixel through rounding of sin and cos
+        const auto fit = [](float v) { return static_cast<extent_base_t>(std::ceil(v - 1e-3F)); };
+        rgb_image_t result{ rgb_image_t::extent_type{ fit(width * s + height * c), fit(width * c + height * s) } };
+
+        const auto center = [](const auto& extent)
+        {
+            return vector_t<2, float>{ static_cast<float>(extent[1] - 1) / 2.F, static_cast<float>(extent[0] - 1) / 2.F };
+        };
+        const matrix_t<3, 3, float> matrix
+            = translation(-center(image.extent())) * rotation(angle) * translation(center(result.extent()));
+        warp_affine_fn{}(policy, result.mut_view(), image, matrix, interpolation);
+        return result;
+    }
+
     template <class T>
     auto operator()(array_view_base_t<T, 2> image, int degrees) const -> array_view_base_t<T, 2>
     {
@@ -550,6 +1422,9 @@ struct rotate_fn
         return { { image.data().from_offset(offset), shape } };
     }
 
+    // a floating-point angle would otherwise be truncated to the quarter turns; resampling takes an interpolation
+    auto operator()(const rgb_image_t::view_type& image, double degrees) const -> rgb_image_t::view_type = delete;
+
     static int normalize_quarter_turns(int degrees)
     {
         if (degrees % 90 != 0)
@@ -612,46 +1487,301 @@ struct rotate_fn
     }
 };
 
-template <std::size_t D>
-struct flip_fn
+// Output sample i along an axis is sum_k coefficients[i * taps + k] * source[first[i] + k] / 2^shift. Coefficients
+// of every output sample sum to exactly 2^shift.
+struct resample_table_t
 {
-    static_assert(D < 2, "flip: axis out of range");
+    static constexpr int shift = 14;
 
-    template <class T>
-    auto operator()(const array_view_base_t<T, 2>& image) const -> array_view_base_t<T, 2>
+    location_base_t taps;
+    std::vector<location_base_t> first;
+    std::vector<std::int16_t> coefficients;
+
+    // The filter is stretched by the scale when downsampling, so that every source sample contributes.
+    static resample_table_t create(extent_base_t src_size, extent_base_t dst_size, resize_filter_t filter)
     {
-        const auto [shape, offset] = new_shape_and_offset(image.shape());
-        return { image.from_offset(offset), shape };
+        const double scale = static_cast<double>(src_size) / static_cast<double>(dst_size);
+        const double stretch = std::max(scale, 1.0);
+        const double support = filter_support(filter) * stretch;
+        const auto taps = std::min(static_cast<location_base_t>(std::ceil(support)) * 2 + 1, src_size);
+
+        resample_table_t result{ taps, {}, {} };
+        result.first.reserve(static_cast<std::size_t>(dst_size));
+        result.coefficients.reserve(static_cast<std::size_t>(dst_size) * static_cast<std::size_t>(taps));
+        std::vector<double> weights;
+        for (location_base_t i = 0; i < dst_size; ++i)
+        {
+            const double center = (i + 0.5) * scale;
+            const auto lo = std::max(static_cast<location_base_t>(std::floor(center - support + 0.5)), 0);
+            const auto hi = std::min(static_cast<location_base_t>(std::floor(center + support + 0.5)), src_size);
+            const location_base_t first = std::min(lo, src_size - taps);
+
+            weights.assign(static_cast<std::size_t>(taps), 0.0);
+            double total = 0.0;
+            for (location_base_t x = lo; x < hi; ++x)
+            {
+                const double w = filter_weight(filter, (x + 0.5 - center) / stretch);
+                weights[static_cast<std::size_t>(x - first)] = w;
+                total += w;
+            }
+
+            const auto begin = result.coefficients.size();
+            for (const double w : weights)
+            {
+                result.coefficients.push_back(
+                    static_cast<std::int16_t>(std::lround(total != 0.0 ? w / total * (1 << shift) : 0.0)));
+            }
+            // rounding error goes to the largest coefficient so that flat areas stay flat
+            const auto row = result.coefficients.begin() + static_cast<std::ptrdiff_t>(begin);
+            const int sum = std::accumulate(row, result.coefficients.end(), 0);
+            std::int16_t& largest = *std::max_element(row, result.coefficients.end());
+            largest = static_cast<std::int16_t>(largest + (1 << shift) - sum);
+            result.first.push_back(first);
+        }
+        return result;
     }
 
-    auto operator()(const rgb_image_t::view_type& image) const -> rgb_image_t::view_type
+    static double filter_support(resize_filter_t filter)
     {
-        const auto [shape, offset] = new_shape_and_offset(image.data().shape());
-        return { { image.data().from_offset(offset), shape } };
+        switch (filter)
+        {
+            case resize_filter_t::box: return 0.5;
+            case resize_filter_t::bilinear: return 1.0;
+            case resize_filter_t::lanczos: return 3.0;
+        }
+        return 1.0;
     }
 
-    auto operator()(const rgb_image_t::mut_view_type& image) const -> rgb_image_t::mut_view_type
+    static double filter_weight(resize_filter_t filter, double x)
     {
-        const auto [shape, offset] = new_shape_and_offset(image.data().shape());
-        return { { image.data().from_offset(offset), shape } };
+        const auto sinc = [](double v) { return v == 0.0 ? 1.0 : std::sin(math::pi<double> * v) / (math::pi<double> * v); };
+        switch (filter)
+        {
+            case resize_filter_t::box: return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+            case resize_filter_t::bilinear: return std::max(1.0 - std::abs(x), 0.0);
+            case resize_filter_t::lanczos: return std::abs(x) < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+        }
+        return 0.0;
     }
+};
 
-    static auto new_shape_and_offset(const shape_t<2>& src) -> std::pair<shape_t<2>, flat_offset_t>
-    {
-        const auto bounds = src.bounds();
-        shape_t<2> out_shape = src;
-        out_shape[D] = src[D].flip();
+inline byte_t resample_round(std::int32_t acc)
+{
+    return static_cast<byte_t>(
+        std::clamp((acc + (1 << (resample_table_t::shift - 1))) >> resample_table_t::shift, 0, 255));
+}
 
-        const flat_offset_t base_offset = D == 0 ? src.flat_offset(bounds.get({ side_t::last, side_t::first }))
-                                                 : src.flat_offset(bounds.get({ side_t::first, side_t::last }));
-        return { out_shape, base_offset };
+struct resize_fn
+{
+    auto operator()(
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::extent_type& extent,
+        resize_filter_t filter = resize_filter_t::bilinear) const -> rgb_image_t
+    {
+        return (*this)(execution::sequential(), src, extent, filter);
     }
 
-    static auto new_shape_and_offset(const shape_t<3>& src) -> std::pair<shape_t<3>, flat_offset_t>
+    // Resamples rows and then columns, each pass in 14-bit fixed point rounded back to bytes. An axis whose size
+    // does not change is not resampled. Rows of the result and of the intermediate image are packed rgb.
+    auto operator()(
+        const execution_t& policy,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::extent_type& extent,
+        resize_filter_t filter = resize_filter_t::bilinear) const -> rgb_image_t
     {
-        const auto bounds = src.bounds();
-        shape_t<3> out_shape = src;
-        out_shape[D] = src[D].flip();
+        const auto src_extent = src.extent();
+        if (src_extent[0] <= 0 || src_extent[1] <= 0 || extent[0] <= 0 || extent[1] <= 0)
+        {
+            throw std::invalid_argument{ str("resize: cannot resize ", src_extent, " to ", extent) };
+        }
+
+        std::optional<rgb_image_t> columns;
+        if (extent[1] != src_extent[1])
+        {
+            columns.emplace(rgb_image_t::extent_type{ src_extent[0], extent[1] });
+            resample_rows(policy, columns->mut_view(), src, resample_table_t::create(src_extent[1], extent[1], filter));
+        }
+        const rgb_image_t::view_type rows_src = columns ? columns->view() : src;
+
+        if (extent[0] == src_extent[0])
+        {
+            return columns ? std::move(*columns) : rgb_image_t{ src, image_layout_t::interleaved };
+        }
+        rgb_image_t result{ extent };
+        resample_columns(policy, result.mut_view(), rows_src, resample_table_t::create(src_extent[0], extent[0], filter));
+        return result;
+    }
+
+private:
+    static void resample_rows(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const resample_table_t& table)
+    {
+        const auto dst_data = dst.data();
+        const auto src_data = src.data();
+        const shape_t<3>& dst_shape = dst_data.shape();
+        const shape_t<3>& src_shape = src_data.shape();
+        const bool packed = is_packed_rgb(src_shape);
+
+        for_each_band(
+            policy,
+            dst_shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                std::vector<byte_t> line(packed ? 0 : 3 * static_cast<std::size_t>(src_shape.dim(1).extent));
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    const byte_t* in = src_data.from_offset(flat_offset_t{ y } * src_shape.dim(0).stride);
+                    if (!packed)
+                    {
+                        pack_rgb_row(in, src_shape, line.data());
+                        in = line.data();
+                    }
+                    byte_t* out = dst_data.from_offset(flat_offset_t{ y } * dst_shape.dim(0).stride);
+                    resample_row(in, out, table);
+                }
+            });
+    }
+
+    // both rows are packed rgb
+    static void resample_row(const byte_t* in, byte_t* out, const resample_table_t& table)
+    {
+        const std::int16_t* coeff = table.coefficients.data();
+        for (const location_base_t first : table.first)
+        {
+            const byte_t* pixel = in + 3 * flat_offset_t{ first };
+            std::int32_t r = 0;
+            std::int32_t g = 0;
+            std::int32_t b = 0;
+            for (location_base_t k = 0; k < table.taps; ++k, pixel += 3)
+            {
+                const std::int32_t c = coeff[k];
+                r += c * std::int32_t{ pixel[0] };
+                g += c * std::int32_t{ pixel[1] };
+                b += c * std::int32_t{ pixel[2] };
+            }
+            coeff += table.taps;
+            out[0] = resample_round(r);
+            out[1] = resample_round(g);
+            out[2] = resample_round(b);
+            out += 3;
+        }
+    }
+
+    // source rows are accumulated as flat runs of bytes, through a packed copy when they are not packed already
+    static void resample_columns(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const resample_table_t& table)
+    {
+        const auto dst_data = dst.data();
+        const auto src_data = src.data();
+        const shape_t<3>& dst_shape = dst_data.shape();
+        const shape_t<3>& src_shape = src_data.shape();
+        const auto width = static_cast<std::size_t>(dst_shape.dim(1).extent);
+        const bool packed = is_packed_rgb(src_shape);
+
+        for_each_band(
+            policy,
+            dst_shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                std::vector<std::int32_t> acc(3 * width);
+                std::vector<byte_t> line(packed ? 0 : 3 * width);
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    std::fill(acc.begin(), acc.end(), 0);
+                    const std::int16_t* coeff
+                        = table.coefficients.data() + static_cast<std::ptrdiff_t>(y) * table.taps;
+                    for (location_base_t k = 0; k < table.taps; ++k)
+                    {
+                        const location_base_t row = table.first[static_cast<std::size_t>(y)] + k;
+                        const byte_t* in = src_data.from_offset(flat_offset_t{ row } * src_shape.dim(0).stride);
+                        if (!packed)
+                        {
+                            pack_rgb_row(in, src_shape, line.data());
+                            in = line.data();
+                        }
+                        simd::accumulate(acc.data(), in, acc.size(), coeff[k]);
+                    }
+                    byte_t* out = dst_data.from_offset(flat_offset_t{ y } * dst_shape.dim(0).stride);
+                    std::transform(acc.begin(), acc.end(), out, &resample_round);
+                }
+            });
+    }
+};
+
+struct pyramid_fn
+{
+    auto operator()(const rgb_image_t::view_type& src, std::size_t levels) const -> std::vector<rgb_image_t>
+    {
+        return (*this)(execution::sequential(), src, levels);
+    }
+
+    // Level i is half the size of level i - 1, rounded up, with src before the first one. Halving with the bilinear
+    // filter blurs with [1 3 3 1] / 8 in the same pass that drops every other sample.
+    auto operator()(const execution_t& policy, const rgb_image_t::view_type& src, std::size_t levels) const
+        -> std::vector<rgb_image_t>
+    {
+        std::vector<rgb_image_t> result;
+        result.reserve(levels);
+        for (std::size_t level = 0; level < levels; ++level)
+        {
+            const rgb_image_t::view_type previous = level == 0 ? src : result.back().view();
+            const auto extent = previous.extent();
+            result.push_back(resize_fn{}(
+                policy,
+                previous,
+                rgb_image_t::extent_type{ (extent[0] + 1) / 2, (extent[1] + 1) / 2 },
+                resize_filter_t::bilinear));
+        }
+        return result;
+    }
+};
+
+template <std::size_t D>
+struct flip_fn
+{
+    static_assert(D < 2, "flip: axis out of range");
+
+    template <class T>
+    auto operator()(const array_view_base_t<T, 2>& image) const -> array_view_base_t<T, 2>
+    {
+        const auto [shape, offset] = new_shape_and_offset(image.shape());
+        return { image.from_offset(offset), shape };
+    }
+
+    auto operator()(const rgb_image_t::view_type& image) const -> rgb_image_t::view_type
+    {
+        const auto [shape, offset] = new_shape_and_offset(image.data().shape());
+        return { { image.data().from_offset(offset), shape } };
+    }
+
+    auto operator()(const rgb_image_t::mut_view_type& image) const -> rgb_image_t::mut_view_type
+    {
+        const auto [shape, offset] = new_shape_and_offset(image.data().shape());
+        return { { image.data().from_offset(offset), shape } };
+    }
+
+    static auto new_shape_and_offset(const shape_t<2>& src) -> std::pair<shape_t<2>, flat_offset_t>
+    {
+        const auto bounds = src.bounds();
+        shape_t<2> out_shape = src;
+        out_shape[D] = src[D].flip();
+
+        const flat_offset_t base_offset = D == 0 ? src.flat_offset(bounds.get({ side_t::last, side_t::first }))
+                                                 : src.flat_offset(bounds.get({ side_t::first, side_t::last }));
+        return { out_shape, base_offset };
+    }
+
+    static auto new_shape_and_offset(const shape_t<3>& src) -> std::pair<shape_t<3>, flat_offset_t>
+    {
+        const auto bounds = src.bounds();
+        shape_t<3> out_shape = src;
+        out_shape[D] = src[D].flip();
 
         const flat_offset_t base_offset = D == 0
                                               ? src.flat_offset(bounds.get({ side_t::last, side_t::first, side_t::first }))
@@ -660,6 +1790,48 @@ struct flip_fn
     }
 };
 
+// Copies a view, e.g. of rotate or flip, into new storage whose rows are contiguous and run forward in memory, so
+// that later passes over it read sequentially. Images keep the layout of the view.
+struct materialize_fn
+{
+    auto operator()(const rgb_image_t::view_type& image) const -> rgb_image_t { return rgb_image_t{ image }; }
+
+    auto operator()(const array_view_t<byte_t, 2>& plane) const -> array_t<byte_t, 2>
+    {
+        array_t<byte_t, 2> result{ plane.extent() };
+        const shape_t<2>& src = plane.shape();
+        const shape_t<2>& dst = result.shape();
+        if (is_transposed(src))
+        {
+            copy_plane_transposed(
+                result.mut_view().data(),
+                dst.dim(0).stride,
+                dst.dim(1).stride,
+                plane.data(),
+                src.dim(0).stride,
+                src.dim(1).stride,
+                src.dim(0).extent,
+                src.dim(1).extent);
+        }
+        else
+        {
+            copy_from_view(result.mut_view(), plane);
+        }
+        return result;
+    }
+};
+
+// bounds of the pixels between two corners, both included
+inline bounds_t<2> pixel_bounds(const location_t<2>& a, const location_t<2>& b)
+{
+    bounds_t<2> result;
+    for (std::size_t d = 0; d < 2; ++d)
+    {
+        result[d] = interval_type{ std::min(a[d], b[d]), std::max(a[d], b[d]) + 1 };
+    }
+    return result;
+}
+
 struct draw_pixel_t
 {
     rgb_image_t::mut_view_type m_image;
@@ -674,12 +1846,68 @@ struct draw_pixel_t
     }
 };
 
-struct bresenham_line_fn
+template <class Filter>
+struct span_painter_t;
+
+// pixels a stroke may reach around the pixels of its path
+inline location_base_t stroke_margin(const stroke_t& pen)
+{
+    const float reach = pen.width <= 1.F ? 0.F : pen.width / 2.F;
+    return static_cast<location_base_t>(std::ceil(reach)) + (pen.antialiased ? 1 : 0);
+}
+
+inline bounds_t<2> grown(bounds_t<2> bounds, location_base_t margin)
+{
+    for (std::size_t d = 0; d < 2; ++d)
+    {
+        bounds[d] = interval_type{ bounds[d][0] - margin, bounds[d][1] + margin };
+    }
+    return bounds;
+}
+
+// Bresenham or Wu runs for strokes up to a pixel wide, round-capped capsules for wider ones
+struct draw_line_fn
 {
+    template <class Filter>
     void operator()(
-        const rgb_image_t::mut_view_type& image, const segment_type& seg, const color_filter_t& color_filter) const
+        const rgb_image_t::mut_view_type& image,
+        const segment_type& seg,
+        const Filter& filter,
+        const stroke_t& pen = stroke_t{}) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        const bounds_t<2> clip = image.bounds();
+        if (pen.width > 1.F)
+        {
+            thick_line_runs(seg[0], seg[1], pen, clip, paint);
+        }
+        else if (pen.antialiased)
+        {
+            wu_line_runs(seg[0], seg[1], clip, std::max(pen.width, 0.F), paint);
+        }
+        else
+        {
+            line_runs(seg[0], seg[1], clip, paint);
+        }
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image, const segment_type& seg, const Filter& filter, dirty_region_t& dirty) const
     {
-        (*this)(seg[0], seg[1], draw_pixel_t{ image, color_filter });
+        (*this)(image, seg, filter, stroke_t{}, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const segment_type& seg,
+        const Filter& filter,
+        const stroke_t& pen,
+        dirty_region_t& dirty) const
+    {
+        (*this)(image, seg, filter, pen);
+        dirty.add(grown(pixel_bounds(seg[0], seg[1]), stroke_margin(pen)));
     }
 
     void operator()(
@@ -695,7 +1923,7 @@ struct bresenham_line_fn
         std::transform(direction.begin(), direction.end(), dist.begin(), math::abs);
         std::transform(direction.begin(), direction.end(), dir.begin(), math::sign);
 
-        bresenham_line_fn::bresenham(
+        draw_line_fn::bresenham(
             start,
             dir,
             dist,
@@ -731,285 +1959,1590 @@ struct bresenham_line_fn
 
             if (e < dist[1])
             {
-                err += dist[0];
-                cur[1] += dir[1];
-            }
-        }
+                err += dist[0];
+                cur[1] += dir[1];
+            }
+        }
+    }
+};
+
+// the midpoint circle for thin strokes, a ring of the stroke width for wide or antialiased ones
+struct draw_circle_fn
+{
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const circle_type& circle,
+        const Filter& filter,
+        const stroke_t& pen = stroke_t{}) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        const bounds_t<2> clip = image.bounds();
+        if (pen.width > 1.F || pen.antialiased)
+        {
+            ring_runs(circle, pen, clip, paint);
+        }
+        else
+        {
+            circle_outline_runs(circle, clip, paint);
+        }
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const circle_type& circle,
+        const Filter& filter,
+        dirty_region_t& dirty) const
+    {
+        (*this)(image, circle, filter, stroke_t{}, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const circle_type& circle,
+        const Filter& filter,
+        const stroke_t& pen,
+        dirty_region_t& dirty) const
+    {
+        (*this)(image, circle, filter, pen);
+        const location_t<2> radius{ circle.radius, circle.radius };
+        dirty.add(grown(pixel_bounds(circle.center - radius, circle.center + radius), stroke_margin(pen)));
+    }
+
+    void operator()(
+        const rgb_image_t::location_type& center,
+        int radius,
+        function_ref<void(const rgb_image_t::location_type&)> output) const
+    {
+        midpoint_octant(
+            radius,
+            [&](location_base_t a, location_base_t b)
+            {
+                output(point(center[0] + a, center[1] + b));
+                output(point(center[0] + b, center[1] + a));
+                output(point(center[0] - b, center[1] + a));
+                output(point(center[0] - a, center[1] + b));
+                output(point(center[0] - a, center[1] - b));
+                output(point(center[0] - b, center[1] - a));
+                output(point(center[0] + b, center[1] - a));
+                output(point(center[0] + a, center[1] - b));
+            });
+    }
+};
+
+struct draw_rectangle_fn
+{
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const rectangle_t<location_base_t>& rect,
+        const Filter& filter,
+        const stroke_t& pen = stroke_t{}) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        rectangle_outline_runs(rect, pen, image.bounds(), paint);
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const rectangle_t<location_base_t>& rect,
+        const Filter& filter,
+        dirty_region_t& dirty) const
+    {
+        (*this)(image, rect, filter, stroke_t{}, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image,
+        const rectangle_t<location_base_t>& rect,
+        const Filter& filter,
+        const stroke_t& pen,
+        dirty_region_t& dirty) const
+    {
+        (*this)(image, rect, filter, pen);
+        const auto width = std::max(static_cast<location_base_t>(std::lround(pen.width)), location_base_t{ 1 });
+        dirty.add(grown(rect, (width - 1) / 2));
+    }
+};
+
+// Applies a filter to the pixels [first, last) of row y, clipped once against the image. Span filters (see modify) take
+// the whole run in one call, through a packed copy when the row is not packed rgb.
+template <class Filter>
+struct span_painter_t
+{
+    rgb_image_t::mut_view_type m_image;
+    const Filter& m_filter;
+    std::vector<byte_t> m_line = {};
+    std::vector<byte_t> m_filtered = {};
+
+    // a coverage below 1 blends the run with its filtered colors
+    void operator()(location_base_t y, location_base_t first, location_base_t last, float coverage = 1.F)
+    {
+        const auto data = m_image.data();
+        const shape_t<3>& shape = data.shape();
+        first = std::max(first, location_base_t{ 0 });
+        last = std::min(last, shape.dim(1).extent);
+        if (y < 0 || y >= shape.dim(0).extent || first >= last || !(coverage > 0.F))
+        {
+            return;
+        }
+
+        byte_t* origin
+            = data.from_offset(flat_offset_t{ y } * shape.dim(0).stride + flat_offset_t{ first } * shape.dim(1).stride);
+        const auto n = static_cast<std::size_t>(last - first);
+        if constexpr (is_span_filter_v<Filter>)
+        {
+            if (is_packed_rgb(shape))
+            {
+                if (coverage >= 1.F)
+                {
+                    m_filter(origin, n);
+                    return;
+                }
+                m_filtered.assign(origin, origin + 3 * n);
+                m_filter(m_filtered.data(), n);
+                simd::lerp(origin, m_filtered.data(), 3 * n, coverage);
+                return;
+            }
+            shape_t<3> run = shape;
+            run[1].extent = last - first;
+            m_line.resize(3 * n);
+            pack_rgb_row(origin, run, m_line.data());
+            if (coverage >= 1.F)
+            {
+                m_filter(m_line.data(), n);
+            }
+            else
+            {
+                m_filtered.assign(m_line.begin(), m_line.end());
+                m_filter(m_filtered.data(), n);
+                simd::lerp(m_line.data(), m_filtered.data(), 3 * n, coverage);
+            }
+            unpack_rgb_row(m_line.data(), run, origin);
+        }
+        else
+        {
+            const stride_base_t step = shape.dim(1).stride;
+            const stride_base_t channel = shape.dim(2).stride;
+            for (std::size_t i = 0; i < n; ++i, origin += step)
+            {
+                const rgb_color_t color{ static_cast<float>(origin[0]),
+                                         static_cast<float>(origin[channel]),
+                                         static_cast<float>(origin[2 * channel]) };
+                const rgb_color_t filtered = m_filter(color);
+                const true_color_t result{ coverage >= 1.F ? filtered : color + (filtered - color) * coverage };
+                origin[0] = result[0];
+                origin[channel] = result[1];
+                origin[2 * channel] = result[2];
+            }
+        }
+    }
+};
+
+inline bounds_t<2> shape_bounds(const raster_t::shape_t& shape)
+{
+    bounds_t<2> bounds;
+    bounds[0] = interval_type{ shape.begin()->first, shape.rbegin()->first + 1 };
+    bounds[1] = interval_type{ std::numeric_limits<location_base_t>::max(), std::numeric_limits<location_base_t>::min() };
+    for (const auto& [y, spans] : shape)
+    {
+        for (const auto& span : spans)
+        {
+            bounds[1][0] = std::min(bounds[1][0], span[0]);
+            bounds[1][1] = std::max(bounds[1][1], span[1]);
+        }
+    }
+    return bounds;
+}
+
+struct draw_raster_fn
+{
+    // spans are clipped once and filtered as runs
+    template <class Filter>
+    void operator()(const rgb_image_t::mut_view_type& image, const raster_t& raster, const Filter& filter) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        for (const auto& shape : raster)
+        {
+            for (const auto& [y, spans] : shape)
+            {
+                for (const auto& span : spans)
+                {
+                    paint(y, span[0], span[1]);
+                }
+            }
+        }
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image, const raster_t& raster, const Filter& filter, dirty_region_t& dirty) const
+    {
+        (*this)(image, raster, filter);
+        for (const auto& shape : raster)
+        {
+            if (!shape.empty())
+            {
+                dirty.add(shape_bounds(shape));
+            }
+        }
+    }
+
+    void operator()(const raster_t::shape_t& shape, const draw_pixel_t& do_draw) const
+    {
+        for (const auto& [y, spans] : shape)
+        {
+            for (const auto& span : spans)
+            {
+                for (location_base_t x = span[0]; x < span[1]; ++x)
+                {
+                    do_draw(location_t<2>{ y, x });
+                }
+            }
+        }
+    }
+};
+
+// Filled shapes painted a row span at a time, with filters taken as in draw_raster.
+struct fill_fn
+{
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image, const rectangle_t<location_base_t>& rect, const Filter& filter) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        const location_base_t first = std::max(rect[0][0], location_base_t{ 0 });
+        const location_base_t last = std::min(rect[0][1], image.extent()[0]);
+        for (location_base_t y = first; y < last; ++y)
+        {
+            paint(y, rect[1][0], rect[1][1]);
+        }
+    }
+
+    template <class Filter>
+    void operator()(const rgb_image_t::mut_view_type& image, const circle_type& circle, const Filter& filter) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        circle_spans(circle, [&](location_base_t y, const interval_type& span) { paint(y, span[0], span[1]); });
+    }
+
+    template <class Filter>
+    void operator()(const rgb_image_t::mut_view_type& image, const polygon_type& polygon, const Filter& filter) const
+    {
+        span_painter_t<Filter> paint{ image, filter };
+        polygon_spans(
+            polygon,
+            [&](location_base_t y, const std::vector<interval_type>& spans)
+            {
+                for (const auto& span : spans)
+                {
+                    paint(y, span[0], span[1]);
+                }
+            });
+    }
+
+    template <class Shape, class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& image, const Shape& shape, const Filter& filter, dirty_region_t& dirty) const
+    {
+        (*this)(image, shape, filter);
+        dirty.add(bounds(shape));
+    }
+
+private:
+    static bounds_t<2> bounds(const rectangle_t<location_base_t>& rect) { return rect; }
+
+    static bounds_t<2> bounds(const circle_type& circle)
+    {
+        const location_t<2> radius{ circle.radius, circle.radius };
+        return pixel_bounds(circle.center - radius, circle.center + radius);
+    }
+
+    static bounds_t<2> bounds(const polygon_type& polygon)
+    {
+        bounds_t<2> result;
+        for (std::size_t d = 0; d < 2; ++d)
+        {
+            const auto [lower, upper] = std::minmax_element(
+                polygon.begin(),
+                polygon.end(),
+                [&](const location_t<2>& lhs, const location_t<2>& rhs) { return lhs[d] < rhs[d]; });
+            result[d] = polygon.empty() ? interval_type{} : interval_type{ (*lower)[d], (*upper)[d] };
+        }
+        return result;
+    }
+};
+
+struct paste_fn
+{
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location) const
+    {
+        (*this)(execution::sequential(), dst, src, location, filters::normal);
+    }
+
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location) const
+    {
+        (*this)(policy, dst, src, location, filters::normal);
+    }
+
+    template <class Filter, std::enable_if_t<is_span_blend_v<Filter>, int> = 0>
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        const Filter& filter) const
+    {
+        (*this)(execution::sequential(), dst, src, location, filter);
+    }
+
+    // rows that are not packed rgb go through packed copies
+    template <class Filter, std::enable_if_t<is_span_blend_v<Filter>, int> = 0>
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        const Filter& filter) const
+    {
+        const auto [clipped_dst, clipped_src] = clip(dst, src, location);
+        const auto dst_data = clipped_dst.data();
+        const auto src_data = clipped_src.data();
+        const shape_t<3>& dst_shape = dst_data.shape();
+        const shape_t<3>& src_shape = src_data.shape();
+        const auto width = static_cast<std::size_t>(dst_shape.dim(1).extent);
+        const bool dst_packed = is_packed_rgb(dst_shape);
+        const bool src_packed = is_packed_rgb(src_shape);
+
+        for_each_band(
+            policy,
+            dst_shape.dim(0).extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                std::vector<byte_t> dst_line(dst_packed ? 0 : 3 * width);
+                std::vector<byte_t> src_line(src_packed ? 0 : 3 * width);
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    byte_t* dst_row = dst_data.from_offset(flat_offset_t{ y } * dst_shape.dim(0).stride);
+                    const byte_t* src_row = src_data.from_offset(flat_offset_t{ y } * src_shape.dim(0).stride);
+                    if (!dst_packed)
+                    {
+                        pack_rgb_row(dst_row, dst_shape, dst_line.data());
+                    }
+                    if (!src_packed)
+                    {
+                        pack_rgb_row(src_row, src_shape, src_line.data());
+                    }
+                    filter(dst_packed ? dst_row : dst_line.data(), src_packed ? src_row : src_line.data(), width);
+                    if (!dst_packed)
+                    {
+                        unpack_rgb_row(dst_line.data(), dst_shape, dst_row);
+                    }
+                }
+            });
+    }
+
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        binary_color_filter_t filter) const
+    {
+        (*this)(execution::sequential(), dst, src, location, filter);
+    }
+
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        binary_color_filter_t filter) const
+    {
+        const auto [clipped_dst, clipped_src] = clip(dst, src, location);
+        for_each(
+            policy,
+            clipped_dst.data().shape(),
+            [&](const rgb_image_t::location_type& loc) { clipped_dst[loc] = filter(clipped_dst[loc], clipped_src[loc]); });
+    }
+
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        dirty_region_t& dirty) const
+    {
+        (*this)(execution::sequential(), dst, src, location, filters::normal, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        const Filter& filter,
+        dirty_region_t& dirty) const
+    {
+        (*this)(execution::sequential(), dst, src, location, filter, dirty);
+    }
+
+    template <class Filter>
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location,
+        const Filter& filter,
+        dirty_region_t& dirty) const
+    {
+        (*this)(policy, dst, src, location, filter);
+        bounds_t<2> bounds;
+        for (std::size_t d = 0; d < 2; ++d)
+        {
+            bounds[d] = interval_type{ location[d], location[d] + src.extent()[d] };
+        }
+        dirty.add(bounds);
+    }
+
+private:
+    static auto clip(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const rgb_image_t::location_type& location) -> std::pair<rgb_image_t::mut_view_type, rgb_image_t::view_type>
+    {
+        const auto [src_bounds, dst_bounds] = adjust_bounds(dst.data().bounds(), src.data().bounds(), append(location, 0));
+        return { rgb_image_t::mut_view_type{ dst.data().slice(to_slice(dst_bounds)) },
+                 rgb_image_t::view_type{ src.data().slice(to_slice(src_bounds)) } };
+    }
+};
+
+// Mask coefficients in row-major order.
+struct mask_taps_t
+{
+    struct tap_t
+    {
+        location_base_t y;
+        location_base_t x;
+        float coeff;
+    };
+
+    rgb_image_t::channel_type::extent_type m_extent;
+    std::vector<tap_t> m_taps;
+
+    explicit mask_taps_t(const mask_t::view_type& mask) : m_extent{ mask.extent() }
+    {
+        m_taps.reserve(static_cast<std::size_t>(mask.volume()));
+        for (location_base_t y = 0; y < m_extent[0]; ++y)
+        {
+            for (location_base_t x = 0; x < m_extent[1]; ++x)
+            {
+                m_taps.push_back(tap_t{ y, x, mask[{ y, x }] });
+            }
+        }
+    }
+
+    void offsets(const shape_t<2>& shape, std::vector<flat_offset_t>& result) const
+    {
+        result.resize(m_taps.size());
+        std::transform(
+            m_taps.begin(),
+            m_taps.end(),
+            result.begin(),
+            [&](const tap_t& tap)
+            { return flat_offset_t{ tap.y } * shape.dim(0).stride + flat_offset_t{ tap.x } * shape.dim(1).stride; });
+    }
+};
+
+// Byte offsets of the taps into regions, owned by the loop that convolves and recomputed when the strides change.
+struct tap_offsets_t
+{
+    std::array<stride_base_t, 2> m_strides = {};
+    std::vector<flat_offset_t> m_values;
+
+    const flat_offset_t* get(const mask_taps_t& taps, const shape_t<2>& shape)
+    {
+        const std::array<stride_base_t, 2> strides = { shape.dim(0).stride, shape.dim(1).stride };
+        if (m_values.size() != taps.m_taps.size() || strides != m_strides)
+        {
+            taps.offsets(shape, m_values);
+            m_strides = strides;
+        }
+        return m_values.data();
+    }
+};
+
+// one set for each mask of a kernel
+using kernel_offsets_t = std::array<tap_offsets_t, 2>;
+
+template <class T, class Func>
+T accumulate(
+    const mask_taps_t& taps,
+    const rgb_image_t::channel_type::view_type& region,
+    T init,
+    Func&& func,
+    tap_offsets_t* offsets = nullptr)
+{
+    const auto& items = taps.m_taps;
+    const byte_t* origin = region.data();
+
+    if (offsets && region.extent() == taps.m_extent)
+    {
+        const flat_offset_t* values = offsets->get(taps, region.shape());
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            init = func(std::move(init), items[i].coeff, origin[values[i]]);
+        }
+        return init;
+    }
+
+    // regions clipped by the image border take only the overlapping taps
+    const stride_base_t row_stride = region.shape().dim(0).stride;
+    const stride_base_t col_stride = region.shape().dim(1).stride;
+    for (const auto& tap : items)
+    {
+        if (tap.y < region.extent()[0] && tap.x < region.extent()[1])
+        {
+            const flat_offset_t offset = flat_offset_t{ tap.y } * row_stride + flat_offset_t{ tap.x } * col_stride;
+            init = func(std::move(init), tap.coeff, origin[offset]);
+        }
+    }
+    return init;
+}
+
+// The weight shared by all coefficients of a flat rectangular mask; nothing for empty, mixed or negative masks.
+inline std::optional<float> uniform_weight(const mask_t& mask)
+{
+    if (mask.volume() == 0)
+    {
+        return std::nullopt;
+    }
+    const float weight = *mask.begin();
+    if (weight < 0.F || !std::all_of(mask.begin(), mask.end(), [&](float value) { return value == weight; }))
+    {
+        return std::nullopt;
+    }
+    return weight;
+}
+
+struct dilation_kernel_t
+{
+    mask_t m_mask;
+    mask_taps_t m_taps;
+    std::optional<float> m_uniform_weight;
+
+    dilation_kernel_t(mask_t mask) : m_mask{ std::move(mask) }, m_taps{ m_mask }, m_uniform_weight{ uniform_weight(m_mask) }
+    {
+    }
+
+    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region) const { return apply(region, nullptr); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets) const
+    {
+        return apply(region, &offsets[0]);
+    }
+
+private:
+    float apply(const rgb_image_t::channel_type::view_type& region, tap_offsets_t* offsets) const
+    {
+        return accumulate(
+            m_taps,
+            region,
+            0.F,
+            [](float acc, float mask_value, byte_t region_value)
+            { return std::max<float>(acc, mask_value * region_value); },
+            offsets);
+    }
+};
+
+struct erosion_kernel_t
+{
+    mask_t m_mask;
+    mask_taps_t m_taps;
+    std::optional<float> m_uniform_weight;
+
+    erosion_kernel_t(mask_t mask) : m_mask{ std::move(mask) }, m_taps{ m_mask }, m_uniform_weight{ uniform_weight(m_mask) }
+    {
+    }
+
+    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region) const { return apply(region, nullptr); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets) const
+    {
+        return apply(region, &offsets[0]);
+    }
+
+private:
+    float apply(const rgb_image_t::channel_type::view_type& region, tap_offsets_t* offsets) const
+    {
+        return accumulate(
+                   m_taps,
+                   region,
+                   std::optional<float>{},
+                   [](std::optional<float> acc, float mask_value, byte_t region_value)
+                   {
+                       if (mask_value <= 0.F)
+                       {
+                           return acc;
+                       }
+
+                       const float value = mask_value * static_cast<float>(region_value);
+                       if (!acc || value < *acc)
+                       {
+                           acc = value;
+                       }
+
+                       return acc;
+                   },
+                   offsets)
+            .value_or(0.F);
+    }
+};
+
+enum class morphology_op_t
+{
+    opening,
+    closing,
+    gradient,
+};
+
+inline std::ostream& operator<<(std::ostream& os, morphology_op_t item)
+{
+    switch (item)
+    {
+        case morphology_op_t::opening: return os << "opening";
+        case morphology_op_t::closing: return os << "closing";
+        case morphology_op_t::gradient: return os << "gradient";
+    }
+    return os;
+}
+
+// opening - erosion then dilation; closing - dilation then erosion; gradient - dilation minus erosion
+struct morphology_kernel_t
+{
+    morphology_op_t m_op;
+    dilation_kernel_t m_dilation;
+    erosion_kernel_t m_erosion;
+
+    morphology_kernel_t(morphology_op_t op, const mask_t& mask) : m_op{ op }, m_dilation{ mask }, m_erosion{ mask } { }
+
+    rgb_image_t::channel_type::extent_type extent() const
+    {
+        const auto size = m_dilation.extent();
+        return m_op == morphology_op_t::gradient
+                   ? size
+                   : rgb_image_t::channel_type::extent_type{ 2 * size[0] - 1, 2 * size[1] - 1 };
+    }
+};
+
+template <std::size_t N>
+struct apply_kernel_t;
+
+struct kernel_accumulator_t
+{
+    float operator()(float acc, float coeff, byte_t value) const { return acc + coeff * static_cast<float>(value); }
+};
+
+template <>
+struct apply_kernel_t<1>
+{
+    mask_t m_mask;
+    std::optional<separable_mask_t> m_separable;
+    std::optional<fixed_point_mask_t> m_fixed_point;
+    std::optional<float> m_uniform_weight;
+    kernel_precision_t m_precision;
+    mask_taps_t m_taps;
+    convolution_method_t m_method = convolution_method_t::automatic;
+
+    apply_kernel_t(mask_t mask, kernel_precision_t precision = kernel_precision_t::automatic)
+        : m_mask{ std::move(mask) }
+        , m_separable{ separate(m_mask.view()) }
+        , m_fixed_point{ quantize(m_mask.view()) }
+        , m_uniform_weight{ uniform_weight(m_mask) }
+        , m_precision{ precision }
+        , m_taps{ m_mask }
+    {
+    }
+
+    apply_kernel_t(separable_mask_t mask, kernel_precision_t precision = kernel_precision_t::automatic)
+        : m_mask{ mask.outer() }
+        , m_separable{ std::move(mask) }
+        , m_fixed_point{ quantize(m_mask.view()) }
+        , m_uniform_weight{ uniform_weight(m_mask) }
+        , m_precision{ precision }
+        , m_taps{ m_mask }
+    {
+    }
+
+    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    {
+        return accumulate(m_taps, region, 0.F, kernel_accumulator_t{});
+    }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets) const
+    {
+        return accumulate(m_taps, region, 0.F, kernel_accumulator_t{}, &offsets[0]);
+    }
+};
+
+// FFT block size for a window over an image: large enough to amortize the overlap, not larger than the image needs.
+inline std::size_t fft_size(const rgb_image_t::channel_type::extent_type& window, const extent_t<2, extent_base_t>& image)
+{
+    const auto longest = static_cast<std::size_t>(std::max(window[0], window[1]));
+    const auto image_size = static_cast<std::size_t>(std::max(image[0], image[1]));
+    return std::max(next_power_of_two(std::min(4 * longest, image_size)), next_power_of_two(2 * longest));
+}
+
+// Rough cost per output pixel of every method, in units of one separable tap.
+inline convolution_method_t select_method(const apply_kernel_t<1>& kernel, const extent_t<2, extent_base_t>& image)
+{
+    const auto window = kernel.extent();
+    const bool integral = kernel.m_uniform_weight && flat_offset_t{ window[0] } * window[1] <= max_box_volume;
+    if ((kernel.m_method == convolution_method_t::separable && !kernel.m_separable)
+        || (kernel.m_method == convolution_method_t::integral && !integral))
+    {
+        return convolution_method_t::direct;
+    }
+    if (kernel.m_method != convolution_method_t::automatic)
+    {
+        return kernel.m_method;
+    }
+
+    const bool fixed_point = kernel.m_precision == kernel_precision_t::automatic && kernel.m_fixed_point;
+    const auto taps = static_cast<double>(
+        fixed_point ? std::count_if(
+                          kernel.m_fixed_point->coefficients.begin(),
+                          kernel.m_fixed_point->coefficients.end(),
+                          [](std::int16_t c) { return c != 0; })
+                    : window[0] * window[1]);
+    const double direct_cost = taps * (fixed_point ? 1.5 : 11.0);
+    const double separable_cost
+        = kernel.m_separable ? static_cast<double>(window[0] + window[1]) : std::numeric_limits<double>::infinity();
+
+    const std::size_t n = fft_size(window, image);
+    const auto size = static_cast<double>(n);
+    const double outputs = (size - static_cast<double>(window[0]) + 1) * (size - static_cast<double>(window[1]) + 1);
+    const double fft_cost = 6.0 * size * size * std::log2(size) / outputs;
+
+    const double integral_cost = integral ? 4.0 : std::numeric_limits<double>::infinity();
+
+    if (integral_cost < separable_cost && integral_cost < direct_cost && integral_cost < fft_cost)
+    {
+        return convolution_method_t::integral;
+    }
+    if (fft_cost < separable_cost && fft_cost < direct_cost)
+    {
+        return convolution_method_t::fft;
+    }
+    return separable_cost <= direct_cost ? convolution_method_t::separable : convolution_method_t::direct;
+}
+
+template <>
+struct apply_kernel_t<2>
+{
+    std::array<mask_t, 2> m_masks;
+    std::array<std::optional<separable_mask_t>, 2> m_separable;
+    std::array<mask_taps_t, 2> m_taps;
+
+    apply_kernel_t(mask_t gx, mask_t gy)
+        : m_masks{ std::move(gx), std::move(gy) }
+        , m_separable{ separate(m_masks[0].view()), separate(m_masks[1].view()) }
+        , m_taps{ mask_taps_t{ m_masks[0] }, mask_taps_t{ m_masks[1] } }
+    {
+    }
+
+    rgb_image_t::channel_type::extent_type extent() const { return m_masks[0].extent(); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    {
+        const auto gx = accumulate(m_taps[0], region, 0.F, kernel_accumulator_t{});
+        const auto gy = accumulate(m_taps[1], region, 0.F, kernel_accumulator_t{});
+
+        return length(vector_t<2, float>{ gx, gy });
+    }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets) const
+    {
+        const auto gx = accumulate(m_taps[0], region, 0.F, kernel_accumulator_t{}, &offsets[0]);
+        const auto gy = accumulate(m_taps[1], region, 0.F, kernel_accumulator_t{}, &offsets[1]);
+
+        return length(vector_t<2, float>{ gx, gy });
+    }
+};
+
+struct percentile_kernel_t
+{
+    int m_rank;
+    mask_t m_mask;
+    mask_taps_t m_taps;
+    // set when every coefficient equals the same non-negative weight, which allows the sliding histogram path
+    std::optional<float> m_uniform_weight;
+    mutable std::vector<float> m_values;
+
+    percentile_kernel_t(int rank, mask_t mask)
+        : m_rank(rank)
+        , m_mask(std::move(mask))
+        , m_taps{ m_mask }
+        , m_uniform_weight{ uniform_weight(m_mask) }
+        , m_values{}
+    {
+        m_values.reserve(static_cast<std::size_t>(m_mask.volume()));
+    }
+
+    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region) const { return apply(region, nullptr); }
+
+    float operator()(const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets) const
+    {
+        return apply(region, &offsets[0]);
+    }
+
+private:
+    float apply(const rgb_image_t::channel_type::view_type& region, tap_offsets_t* offsets) const
+    {
+        m_values.clear();
+
+        accumulate(
+            m_taps,
+            region,
+            std::back_inserter(m_values),
+            [](auto acc, float mask_value, byte_t region_value)
+            {
+                *acc++ = mask_value * static_cast<float>(region_value);
+                return acc;
+            },
+            offsets);
+
+        const auto index = static_cast<std::ptrdiff_t>(m_values.size()) * m_rank / 100;
+        std::nth_element(m_values.begin(), m_values.begin() + index, m_values.end());
+        return m_values.begin()[index];
+    }
+};
+
+struct convolve_fn
+{
+    template <class Kernel>
+    void operator()(
+        rgb_image_t::channel_type::mut_view_type dst,
+        const rgb_image_t::channel_type::view_type& src,
+        const Kernel& kernel,
+        const border_t& border = {}) const
+    {
+        (*this)(execution::sequential(), dst, src, kernel, border);
+    }
+
+    template <class Kernel>
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const Kernel& kernel,
+        const border_t& border = {}) const
+    {
+        (*this)(execution::sequential(), dst, src, kernel, border);
+    }
+
+    template <class Kernel>
+    void operator()(const rgb_image_t::mut_view_type& src, const Kernel& kernel, const border_t& border = {}) const
+    {
+        (*this)(execution::sequential(), src, kernel, border);
+    }
+
+    template <class Kernel>
+    void operator()(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const rgb_image_t::channel_type::view_type& src,
+        const Kernel& kernel,
+        const border_t& border = {}) const
+    {
+        run(policy, dst, padded_source_t{ src, kernel.extent(), border }, kernel);
+    }
+
+    // each pass handles the border on its own
+    void operator()(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const rgb_image_t::channel_type::view_type& src,
+        const morphology_kernel_t& kernel,
+        const border_t& border = {}) const
+    {
+        const auto size = kernel.m_dilation.extent();
+        const padded_source_t source{ src, size, border };
+        array_t<byte_t, 2> first{ { source.extent()[0] - size[0] + 1, source.extent()[1] - size[1] + 1 } };
+        switch (kernel.m_op)
+        {
+            case morphology_op_t::opening:
+                (*this)(policy, first.mut_view(), src, kernel.m_erosion, border);
+                (*this)(policy, dst, first, kernel.m_dilation, border);
+                break;
+            case morphology_op_t::closing:
+                (*this)(policy, first.mut_view(), src, kernel.m_dilation, border);
+                (*this)(policy, dst, first, kernel.m_erosion, border);
+                break;
+            case morphology_op_t::gradient:
+            {
+                array_t<byte_t, 2> second{ first.extent() };
+                run(policy, first.mut_view(), source, kernel.m_dilation);
+                run(policy, second.mut_view(), source, kernel.m_erosion);
+                dst = output_region(dst, source, size);
+                for_each_band(
+                    policy,
+                    dst.extent()[0],
+                    [&](location_base_t begin, location_base_t end)
+                    {
+                        for (location_base_t y = begin; y < end; ++y)
+                        {
+                            for (location_base_t x = 0; x < dst.extent()[1]; ++x)
+                            {
+                                const int value = int{ first[{ y, x }] } - int{ second[{ y, x }] };
+                                dst[{ y, x }] = static_cast<byte_t>(std::max(value, 0));
+                            }
+                        }
+                    });
+                break;
+            }
+        }
+    }
+
+    // Bands of output rows are spread over the pool; each band is walked in tiles small enough for all channels of a
+    // tile, including the halo rows of the kernel, to stay in L2. Rows are computed independently, so the result
+    // does not depend on the tiling.
+    template <class Kernel>
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const Kernel& kernel,
+        const border_t& border = {}) const
+    {
+        const auto sources = channel_sources(src, kernel.extent(), border);
+        if (prefers_whole_channels(kernel, src.channel(0).extent()))
+        {
+            convolve_channels(policy, dst, sources, kernel);
+            return;
+        }
+        convolve_tiles(policy, dst, sources, kernel, 0, sources[0].extent()[0] - kernel.extent()[0] + 1);
+    }
+
+    // Recomputes only the output rows whose windows read a source row with a dirty block; with border_mode_t::wrap
+    // the last rows read the first ones, so any change recomputes everything.
+    template <class Kernel>
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const Kernel& kernel,
+        const border_t& border,
+        const dirty_region_t& dirty) const
+    {
+        if (dirty.extent() != src.extent())
+        {
+            throw std::invalid_argument{ str("convolve: dirty region ", dirty.extent(), " of image ", src.extent()) };
+        }
+        if (border.mode == border_mode_t::wrap)
+        {
+            if (!dirty.empty())
+            {
+                (*this)(policy, dst, src, kernel, border);
+            }
+            return;
+        }
+
+        const auto sources = channel_sources(src, kernel.extent(), border);
+        const extent_base_t kh = kernel.extent()[0];
+        const extent_base_t n = src.extent()[0];
+        const extent_base_t h = sources[0].extent()[0] - kh + 1;
+        const extent_base_t before = sources[0].m_before[0];
+        std::vector<interval_type> rows;
+        for (const auto& dirty_rows : dirty.rows())
+        {
+            // border rows repeat source rows within kh of the edges
+            const location_base_t lower = dirty_rows[0] < kh ? -kh : dirty_rows[0];
+            const location_base_t upper = dirty_rows[1] > n - kh ? n + kh : dirty_rows[1];
+            const location_base_t first = std::max(lower - kh + 1 + before, location_base_t{ 0 });
+            const location_base_t last = std::min(upper + before, h);
+            if (first >= last)
+            {
+                continue;
+            }
+            if (!rows.empty() && rows.back()[1] >= first)
+            {
+                rows.back()[1] = std::max(rows.back()[1], last);
+            }
+            else
+            {
+                rows.push_back(interval_type{ first, last });
+            }
+        }
+        for (const auto& interval : rows)
+        {
+            convolve_tiles(policy, dst, sources, kernel, interval[0], interval[1]);
+        }
+    }
+
+    // both passes would widen the halo; any change recomputes everything
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const morphology_kernel_t& kernel,
+        const border_t& border,
+        const dirty_region_t& dirty) const
+    {
+        if (!dirty.empty())
+        {
+            (*this)(policy, dst, src, kernel, border);
+        }
+    }
+
+    template <class Kernel>
+    void operator()(
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const Kernel& kernel,
+        const border_t& border,
+        const dirty_region_t& dirty) const
+    {
+        (*this)(execution::sequential(), dst, src, kernel, border, dirty);
+    }
+
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const rgb_image_t::view_type& src,
+        const morphology_kernel_t& kernel,
+        const border_t& border = {}) const
+    {
+        for (std::size_t z = 0; z < 3; ++z)
+        {
+            (*this)(policy, dst.channel(z), src.channel(z), kernel, border);
+        }
+    }
+
+    // with border_mode_t::valid everything outside of the valid region is cleared
+    template <class Kernel>
+    void operator()(
+        const execution_t& policy, const rgb_image_t::mut_view_type& src, const Kernel& kernel, const border_t& border = {})
+        const
+    {
+        if (prefers_whole_channels(kernel, src.channel(0).extent()))
+        {
+            // FFT blocks are taller than a strip
+            rgb_image_t dst{ src.extent() };
+            (*this)(policy, dst.mut_view(), src, kernel, border);
+            src.data().assign(dst.data());
+            return;
+        }
+        for (std::size_t z = 0; z < 3; ++z)
+        {
+            in_place(policy, src.channel(z), kernel, border);
+        }
+    }
+
+    void operator()(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& src,
+        const morphology_kernel_t& kernel,
+        const border_t& border = {}) const
+    {
+        rgb_image_t dst{ src.extent() };
+        (*this)(policy, dst.mut_view(), src, kernel, border);
+        src.data().assign(dst.data());
+    }
+
+private:
+    static auto output_region(
+        const rgb_image_t::channel_type::mut_view_type& dst,
+        const padded_source_t& source,
+        const rgb_image_t::channel_type::extent_type& kernel_size) -> rgb_image_t::channel_type::mut_view_type
+    {
+        return dst.slice({ { 0, source.extent()[0] - kernel_size[0] + 1 }, { 0, source.extent()[1] - kernel_size[1] + 1 } });
+    }
+
+    static auto channel_sources(
+        const rgb_image_t::view_type& src, const rgb_image_t::channel_type::extent_type& window, const border_t& border)
+        -> std::array<padded_source_t, 3>
+    {
+        return { padded_source_t{ src.channel(0), window, border },
+                 padded_source_t{ src.channel(1), window, border },
+                 padded_source_t{ src.channel(2), window, border } };
+    }
+
+    // output rows [begin, end) of all channels, tile by tile
+    template <class Kernel>
+    static void convolve_tiles(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const std::array<padded_source_t, 3>& sources,
+        const Kernel& kernel,
+        location_base_t begin,
+        location_base_t end)
+    {
+        // source bytes of all channels a tile may keep hot; tiles are whole multiples of the engines' row strips
+        static constexpr std::size_t tile_bytes = 1024 * 1024;
+        static constexpr extent_base_t strip_height = 64;
+
+        const extent_base_t kh = kernel.extent()[0];
+        const auto row_bytes = static_cast<std::size_t>(std::max(sources[0].extent()[1], extent_base_t{ 1 })) * 3;
+        const auto strips = std::max(static_cast<extent_base_t>(tile_bytes / row_bytes) / strip_height, extent_base_t{ 1 });
+        const extent_base_t min_strips = (4 * kh + strip_height - 1) / strip_height;
+        const extent_base_t tile = std::max(strips, min_strips) * strip_height;
+
+        for_each_band(
+            policy,
+            end - begin,
+            [&](location_base_t first, location_base_t last)
+            {
+                for (location_base_t y = begin + first; y < begin + last; y += tile)
+                {
+                    const extent_base_t count = std::min(tile, begin + last - y);
+                    for (std::size_t z = 0; z < 3; ++z)
+                    {
+                        run(execution::sequential(),
+                            dst.channel(z).slice({ { y, y + count }, {} }),
+                            sources[z].rows(y, count + kh - 1),
+                            kernel);
+                    }
+                }
+            });
     }
-};
 
-struct bresenham_circle_fn
-{
-    void operator()(const rgb_image_t::mut_view_type& image, const circle_type& circle, color_filter_t color_filter) const
+    // FFT blocks span many rows, so row tiles would waste most of every transform
+    template <class Kernel>
+    static bool prefers_whole_channels(const Kernel&, const extent_t<2, extent_base_t>&)
     {
-        (*this)(circle.center, circle.radius, draw_pixel_t{ image, color_filter });
+        return false;
     }
 
-    void operator()(
-        const rgb_image_t::location_type& center,
-        int radius,
-        function_ref<void(const rgb_image_t::location_type&)> output) const
+    static bool prefers_whole_channels(const apply_kernel_t<1>& kernel, const extent_t<2, extent_base_t>& image)
     {
-        rgb_image_t::location_type cur{ radius, 0 };
-        int err = 0;
+        return select_method(kernel, image) == convolution_method_t::fft;
+    }
 
-        while (cur[0] >= cur[1])
+    template <class Kernel>
+    static void convolve_channels(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const std::array<padded_source_t, 3>& sources,
+        const Kernel& kernel)
+    {
+        for (std::size_t z = 0; z < 3; ++z)
         {
-            output(point(center[0] + cur[0], center[1] + cur[1]));
-            output(point(center[0] + cur[1], center[1] + cur[0]));
-            output(point(center[0] - cur[1], center[1] + cur[0]));
-            output(point(center[0] - cur[0], center[1] + cur[1]));
-            output(point(center[0] - cur[0], center[1] - cur[1]));
-            output(point(center[0] - cur[1], center[1] - cur[0]));
-            output(point(center[0] + cur[1], center[1] - cur[0]));
-            output(point(center[0] + cur[0], center[1] - cur[1]));
-
-            if (err <= 0)
-            {
-                cur[1] += 1;
-                err += 2 * cur[1] + 1;
-            }
-
-            if (err > 0)
-            {
-                cur[0] -= 1;
-                err -= 2 * cur[0] + 1;
-            }
+            run(policy, dst.channel(z), sources[z], kernel);
         }
     }
-};
 
-struct draw_rectangle_fn
-{
-    void operator()(
-        const rgb_image_t::mut_view_type& image, const rectangle_t<location_base_t>& rect, color_filter_t color_filter) const
+    // all channels share the extent, so one spectrum serves them all
+    static void convolve_channels(
+        const execution_t& policy,
+        const rgb_image_t::mut_view_type& dst,
+        const std::array<padded_source_t, 3>& sources,
+        const apply_kernel_t<1>& kernel)
     {
-        for (const auto seg : segments(rect))
+        const fft_spectrum_t spectrum
+            = make_fft_spectrum(kernel.m_mask.view(), fft_size(kernel.extent(), sources[0].m_src.extent()));
+        for (std::size_t z = 0; z < 3; ++z)
         {
-            bresenham_line_fn{}(image, seg, color_filter);
+            run_fft(policy, dst.channel(z), sources[z], spectrum);
         }
     }
-};
 
-struct draw_raster_fn
-{
-    void operator()(const rgb_image_t::mut_view_type& image, const raster_t& raster, color_filter_t color_filter) const
+    static void run_fft(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const fft_spectrum_t& spectrum)
+    {
+        dst = output_region(dst, source, spectrum.window);
+        const stride_base_t dst_y = dst.shape().dim(0).stride;
+        const stride_base_t dst_x = dst.shape().dim(1).stride;
+        byte_t* origin = dst.from_offset(0);
+        fft_tiles(
+            policy,
+            source,
+            spectrum,
+            [&](location_base_t y, location_base_t x, float value)
+            { origin[flat_offset_t{ y } * dst_y + flat_offset_t{ x } * dst_x] = true_color_t::from_float(value); });
+    }
+
+    template <class Func>
+    static void store_row(const rgb_image_t::channel_type::mut_view_type& dst, location_base_t y, Func&& func)
     {
-        const auto do_draw = draw_pixel_t{ image, color_filter };
-        for (const auto& shape : raster)
+        byte_t* row = dst.from_offset(flat_offset_t{ y } * dst.shape().dim(0).stride);
+        const stride_base_t step = dst.shape().dim(1).stride;
+        for (location_base_t x = 0; x < dst.extent()[1]; ++x)
         {
-            (*this)(shape, do_draw);
+            row[flat_offset_t{ x } * step] = func(x);
         }
     }
 
-    void operator()(const raster_t::shape_t& shape, const draw_pixel_t& do_draw) const
-    {
-        for (const auto& [y, spans] : shape)
+    // Output rows are kept in a rolling pair of strips, each written back one strip later, once no remaining
+    // window reads the source rows it replaces.
+    template <class Kernel>
+    void in_place(
+        const execution_t& policy,
+        const rgb_image_t::channel_type::mut_view_type& image,
+        const Kernel& kernel,
+        const border_t& border) const
+    {
+        const padded_source_t source{ image, kernel.extent(), border };
+        const extent_base_t kh = kernel.extent()[0];
+        const extent_base_t h = std::max(source.extent()[0] - kh + 1, extent_base_t{ 0 });
+        const extent_base_t w = std::max(source.extent()[1] - kernel.extent()[1] + 1, extent_base_t{ 0 });
+
+        if (border.mode == border_mode_t::wrap)
         {
-            for (const auto& span : spans)
+            // the last rows read the first ones
+            array_t<byte_t, 2> result{ image.extent() };
+            run(policy, result.mut_view(), source, kernel);
+            image.assign(result);
+            return;
+        }
+
+        const extent_base_t strip = std::max(extent_base_t{ 64 }, kh);
+        std::array<array_t<byte_t, 2>, 2> strips = { array_t<byte_t, 2>{ { strip, w } },
+                                                     array_t<byte_t, 2>{ { strip, w } } };
+        const auto store = [&](location_base_t first)
+        {
+            const extent_base_t count = std::min(strip, h - first);
+            image.slice({ { first, first + count }, { 0, w } })
+                .assign(strips[static_cast<std::size_t>(first / strip % 2)].view().slice({ { 0, count }, {} }));
+        };
+
+        for (location_base_t first = 0; first < h; first += strip)
+        {
+            const extent_base_t count = std::min(strip, h - first);
+            run(policy,
+                strips[static_cast<std::size_t>(first / strip % 2)].mut_view(),
+                source.rows(first, count + kh - 1),
+                kernel);
+            if (first != 0)
             {
-                for (location_base_t x = span[0]; x < span[1]; ++x)
-                {
-                    do_draw(location_t<2>{ y, x });
-                }
+                store(first - strip);
             }
         }
+        if (h > 0)
+        {
+            store((h - 1) / strip * strip);
+        }
+
+        if (border.mode == border_mode_t::valid)
+        {
+            image.slice({ { h, image.extent()[0] }, {} }).fill(0);
+            image.slice({ { 0, h }, { w, image.extent()[1] } }).fill(0);
+        }
     }
-};
 
-struct paste_fn
-{
-    void operator()(
-        const rgb_image_t::mut_view_type& dst,
-        const rgb_image_t::view_type& src,
-        const rgb_image_t::location_type& location,
-        binary_color_filter_t filter = filters::normal) const
+    template <class Kernel>
+    static void run(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const Kernel& kernel)
     {
-        const auto [src_bounds, dst_bounds] = adjust_bounds(dst.data().bounds(), src.data().bounds(), append(location, 0));
-
-        const auto clipped_dst = rgb_image_t::mut_view_type{ dst.data().slice(to_slice(dst_bounds)) };
-        const auto clipped_src = rgb_image_t::view_type{ src.data().slice(to_slice(src_bounds)) };
-
-        for_each(
-            clipped_dst.data().shape(),
-            [&](const rgb_image_t::location_type& loc) { clipped_dst[loc] = filter(clipped_dst[loc], clipped_src[loc]); });
+        convolve_pixels(policy, dst, source, kernel);
     }
-};
 
-struct convolve_fn
-{
-    template <class Kernel>
-    void operator()(
+    static void run(
+        const execution_t& policy,
         rgb_image_t::channel_type::mut_view_type dst,
-        const rgb_image_t::channel_type::view_type& src,
-        const Kernel& kernel) const
+        const padded_source_t& source,
+        const apply_kernel_t<1>& kernel)
     {
-        const auto kernel_size = kernel.extent();
+        const convolution_method_t method = select_method(kernel, source.m_src.extent());
+        if (method == convolution_method_t::fft)
+        {
+            run_fft(
+                policy,
+                dst,
+                source,
+                make_fft_spectrum(kernel.m_mask.view(), fft_size(kernel.extent(), source.m_src.extent())));
+            return;
+        }
 
-        dst = dst.slice(
-            { { 0, src.shape()[0].extent - kernel_size[0] + 1 }, { 0, src.shape()[1].extent - kernel_size[1] + 1 } });
+        if (method == convolution_method_t::integral)
+        {
+            dst = output_region(dst, source, kernel.extent());
+            box_rows(
+                policy,
+                source,
+                kernel.extent(),
+                *kernel.m_uniform_weight,
+                [&](location_base_t y, const byte_t* values)
+                { store_row(dst, y, [&](location_base_t x) { return values[x]; }); });
+            return;
+        }
 
-        for_each(
-            dst.shape(),
-            [&](const location_t<2>& loc)
-            {
-                const auto region = src.slice({ { loc[0], loc[0] + kernel_size[0] }, { loc[1], loc[1] + kernel_size[1] } });
+        if (method == convolution_method_t::direct && kernel.m_precision == kernel_precision_t::automatic
+            && kernel.m_fixed_point)
+        {
+            dst = output_region(dst, source, kernel.extent());
+            fixed_point_rows(
+                policy,
+                source,
+                *kernel.m_fixed_point,
+                [&](location_base_t y, const byte_t* values)
+                { store_row(dst, y, [&](location_base_t x) { return values[x]; }); });
+            return;
+        }
 
-                dst[loc] = true_color_t::from_float(kernel(region));
-            });
+        if (method == convolution_method_t::direct)
+        {
+            convolve_pixels(policy, dst, source, kernel);
+            return;
+        }
+
+        dst = output_region(dst, source, kernel.extent());
+        separable_rows<1>(
+            policy,
+            source,
+            { &*kernel.m_separable },
+            [&](location_base_t y, const std::array<const float*, 1>& values)
+            { store_row(dst, y, [&](location_base_t x) { return true_color_t::from_float(values[0][x]); }); });
     }
 
-    template <class Kernel>
-    void operator()(const rgb_image_t::mut_view_type& dst, const rgb_image_t::view_type& src, const Kernel& kernel) const
+    static void run(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const apply_kernel_t<2>& kernel)
     {
-        for (std::size_t z = 0; z < 3; ++z)
+        if (!kernel.m_separable[0] || !kernel.m_separable[1])
         {
-            (*this)(dst.channel(z), src.channel(z), kernel);
+            convolve_pixels(policy, dst, source, kernel);
+            return;
         }
-    }
 
-    template <class Kernel>
-    void operator()(const rgb_image_t::mut_view_type& src, const Kernel& kernel) const
-    {
-        rgb_image_t dst{ src.extent() };
-        (*this)(dst.mut_view(), src, kernel);
-        src.data().assign(dst.data());
+        dst = output_region(dst, source, kernel.extent());
+        separable_rows<2>(
+            policy,
+            source,
+            { &*kernel.m_separable[0], &*kernel.m_separable[1] },
+            [&](location_base_t y, const std::array<const float*, 2>& values)
+            {
+                store_row(
+                    dst,
+                    y,
+                    [&](location_base_t x)
+                    {
+                        return true_color_t::from_float(
+                            std::sqrt(values[0][x] * values[0][x] + values[1][x] * values[1][x]));
+                    });
+            });
     }
-};
 
-template <class T, class Func>
-T accumulate(const mask_t::view_type& mask, const rgb_image_t::channel_type::view_type& region, T init, Func&& func)
-{
-    for_each(
-        region.shape(),
-        [&](const rgb_image_t::location_type& loc)
+    static void run(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const dilation_kernel_t& kernel)
+    {
+        if (!kernel.m_uniform_weight || *kernel.m_uniform_weight <= 0.F)
         {
-            if (contains(mask.bounds(), loc) && contains(region.bounds(), loc))
-            {
-                init = func(std::move(init), mask[loc], region[loc]);
-            }
-        });
-
-    return init;
-}
-
-struct dilation_kernel_t
-{
-    mask_t m_mask;
-
-    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+            convolve_pixels(policy, dst, source, kernel);
+            return;
+        }
+        run_extremum(
+            policy,
+            dst,
+            source,
+            kernel.extent(),
+            *kernel.m_uniform_weight,
+            [](byte_t lhs, byte_t rhs) { return std::max(lhs, rhs); });
+    }
 
-    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    static void run(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const erosion_kernel_t& kernel)
     {
-        return accumulate(
-            m_mask,
-            region,
-            0.F,
-            [](float acc, float mask_value, byte_t region_value)
-            { return std::max<float>(acc, mask_value * region_value); });
+        if (!kernel.m_uniform_weight || *kernel.m_uniform_weight <= 0.F)
+        {
+            convolve_pixels(policy, dst, source, kernel);
+            return;
+        }
+        run_extremum(
+            policy,
+            dst,
+            source,
+            kernel.extent(),
+            *kernel.m_uniform_weight,
+            [](byte_t lhs, byte_t rhs) { return std::min(lhs, rhs); });
     }
-};
-
-struct erosion_kernel_t
-{
-    mask_t m_mask;
-
-    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
 
-    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    static void run(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const percentile_kernel_t& kernel)
     {
-        return accumulate(
-                   m_mask,
-                   region,
-                   std::optional<float>{},
-                   [](std::optional<float> acc, float mask_value, byte_t region_value)
-                   {
-                       if (mask_value <= 0.F)
-                       {
-                           return acc;
-                       }
-
-                       const float value = mask_value * static_cast<float>(region_value);
-                       if (!acc || value < *acc)
-                       {
-                           acc = value;
-                       }
+        const auto volume = static_cast<std::ptrdiff_t>(kernel.m_mask.volume());
+        if (!kernel.m_uniform_weight || volume > std::numeric_limits<std::uint16_t>::max() || kernel.m_rank < 0
+            || volume * kernel.m_rank / 100 >= volume)
+        {
+            convolve_pixels(policy, dst, source, kernel);
+            return;
+        }
 
-                       return acc;
-                   })
-            .value_or(0.F);
+        dst = output_region(dst, source, kernel.extent());
+        const float weight = *kernel.m_uniform_weight;
+        percentile_rows(
+            policy,
+            source,
+            kernel.extent(),
+            static_cast<std::size_t>(volume * kernel.m_rank / 100),
+            [&](location_base_t y, const byte_t* values)
+            {
+                store_row(
+                    dst,
+                    y,
+                    [&](location_base_t x) { return true_color_t::from_float(weight * static_cast<float>(values[x])); });
+            });
     }
-};
 
-template <std::size_t N>
-struct apply_kernel_t;
-
-struct kernel_accumulator_t
-{
-    float operator()(float acc, float coeff, byte_t value) const { return acc + coeff * static_cast<float>(value); }
-};
+    template <class Op>
+    static void run_extremum(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const rgb_image_t::channel_type::extent_type& window,
+        float weight,
+        Op op)
+    {
+        dst = output_region(dst, source, window);
+        extremum_rows(
+            policy,
+            source,
+            window,
+            op,
+            [&](location_base_t y, const byte_t* values)
+            {
+                store_row(
+                    dst,
+                    y,
+                    [&](location_base_t x) { return true_color_t::from_float(weight * static_cast<float>(values[x])); });
+            });
+    }
 
-template <>
-struct apply_kernel_t<1>
-{
-    mask_t m_mask;
+    // Interior windows are views into the source; windows touching the border are gathered into a patch first.
+    template <class Kernel>
+    static void convolve_pixels(
+        const execution_t& policy,
+        rgb_image_t::channel_type::mut_view_type dst,
+        const padded_source_t& source,
+        const Kernel& kernel)
+    {
+        const auto kernel_size = kernel.extent();
 
-    apply_kernel_t(mask_t mask) : m_mask{ std::move(mask) } { }
+        dst = output_region(dst, source, kernel_size);
 
-    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
+        const extent_base_t w = dst.shape()[1].extent;
 
-    float operator()(const rgb_image_t::channel_type::view_type& region) const
-    {
-        return accumulate(m_mask, region, 0.F, kernel_accumulator_t{});
+        for_each_band(
+            policy,
+            dst.shape()[0].extent,
+            [&](location_base_t first, location_base_t last)
+            {
+                // kernels may keep scratch buffers, so each band works on its own copy
+                const Kernel band_kernel = kernel;
+                array_t<byte_t, 2> patch{ kernel_size };
+                kernel_offsets_t window_offsets;
+                kernel_offsets_t patch_offsets;
+                const auto apply = [&](const rgb_image_t::channel_type::view_type& region, kernel_offsets_t& offsets)
+                {
+                    if constexpr (std::is_invocable_v<const Kernel&, decltype(region), kernel_offsets_t&>)
+                    {
+                        return true_color_t::from_float(band_kernel(region, offsets));
+                    }
+                    else
+                    {
+                        return true_color_t::from_float(band_kernel(region));
+                    }
+                };
+                for (location_base_t y = first; y < last; ++y)
+                {
+                    for (location_base_t x = 0; x < w; ++x)
+                    {
+                        const location_t<2> loc{ y, x };
+                        if (const auto region = source.window(loc, kernel_size))
+                        {
+                            dst[loc] = apply(*region, window_offsets);
+                        }
+                        else
+                        {
+                            source.gather(loc, patch.mut_view());
+                            dst[loc] = apply(patch.view(), patch_offsets);
+                        }
+                    }
+                }
+            });
     }
 };
 
-template <>
-struct apply_kernel_t<2>
+// Summed-area tables of every channel; channels are independent, so the policy spreads them over the pool.
+struct integral_fn
 {
-    std::array<mask_t, 2> m_masks;
-
-    rgb_image_t::channel_type::extent_type extent() const { return m_masks[0].extent(); }
-
-    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    auto operator()(const rgb_image_t::channel_type::view_type& channel) const -> integral_image_t
     {
-        const auto gx = accumulate(m_masks[0], region, 0.F, kernel_accumulator_t{});
-        const auto gy = accumulate(m_masks[1], region, 0.F, kernel_accumulator_t{});
-
-        return length(vector_t<2, float>{ gx, gy });
+        integral_image_t result;
+        add_plane(result, channel);
+        plane(result, 0, channel);
+        return result;
     }
-};
-
-struct percentile_kernel_t
-{
-    int m_rank;
-    mask_t m_mask;
-    mutable std::vector<float> m_values;
 
-    percentile_kernel_t(int rank, mask_t mask) : m_rank(rank), m_mask(std::move(mask)), m_values{}
+    auto operator()(const rgb_image_t::view_type& image) const -> integral_image_t
     {
-        m_values.reserve(static_cast<std::size_t>(m_mask.volume()));
+        return (*this)(execution::sequential(), image);
     }
 
-    rgb_image_t::channel_type::extent_type extent() const { return m_mask.extent(); }
-
-    float operator()(const rgb_image_t::channel_type::view_type& region) const
+    auto operator()(const execution_t& policy, const rgb_image_t::view_type& image) const -> integral_image_t
     {
-        m_values.clear();
-
-        accumulate(
-            m_mask,
-            region,
-            std::back_inserter(m_values),
-            [](auto acc, float mask_value, byte_t region_value)
+        integral_image_t result;
+        for (std::size_t z = 0; z < 3; ++z)
+        {
+            add_plane(result, image.channel(z));
+        }
+        for_each_band(
+            policy,
+            3,
+            [&](location_base_t first, location_base_t last)
             {
-                *acc++ = mask_value * static_cast<float>(region_value);
-                return acc;
+                for (location_base_t z = first; z < last; ++z)
+                {
+                    const auto index = static_cast<std::size_t>(z);
+                    plane(result, index, image.channel(index));
+                }
             });
+        return result;
+    }
 
-        const auto index = static_cast<std::ptrdiff_t>(m_values.size()) * m_rank / 100;
-        std::nth_element(m_values.begin(), m_values.begin() + index, m_values.end());
-        return m_values.begin()[index];
+private:
+    static void add_plane(integral_image_t& result, const rgb_image_t::channel_type::view_type& channel)
+    {
+        const extent_t<2, extent_base_t> size{ channel.extent()[0] + 1, channel.extent()[1] + 1 };
+        result.sums.emplace_back(size);
+        result.square_sums.emplace_back(size);
+    }
+
+    static void plane(integral_image_t& result, std::size_t index, const rgb_image_t::channel_type::view_type& channel)
+    {
+        integral_plane(channel, result.sums[index].mut_view(), result.square_sums[index].mut_view());
     }
 };
 
@@ -1020,17 +3553,25 @@ static constexpr inline auto with = detail::with_fn{};
 
 static constexpr inline auto load_bitmap = detail::load_bitmap_fn{};
 static constexpr inline auto save_bitmap = detail::save_bitmap_fn{};
+static constexpr inline auto load_bitmap_rows = detail::load_bitmap_rows_fn{};
+static constexpr inline auto save_bitmap_rows = detail::save_bitmap_rows_fn{};
 
 static constexpr inline auto rotate = detail::rotate_fn{};
+static constexpr inline auto warp_affine = detail::warp_affine_fn{};
+static constexpr inline auto resize = detail::resize_fn{};
+static constexpr inline auto pyramid = detail::pyramid_fn{};
 static constexpr inline auto flip_horizontal = detail::flip_fn<1>{};
 static constexpr inline auto flip_vertical = detail::flip_fn<0>{};
+static constexpr inline auto materialize = detail::materialize_fn{};
 
-static constexpr inline auto draw_line = detail::bresenham_line_fn{};
-static constexpr inline auto draw_circle = detail::bresenham_circle_fn{};
+static constexpr inline auto draw_line = detail::draw_line_fn{};
+static constexpr inline auto draw_circle = detail::draw_circle_fn{};
 static constexpr inline auto draw_rectangle = detail::draw_rectangle_fn{};
 static constexpr inline auto draw_raster = detail::draw_raster_fn{};
+static constexpr inline auto fill = detail::fill_fn{};
 static constexpr inline auto paste = detail::paste_fn{};
 static constexpr inline auto convolve = detail::convolve_fn{};
+static constexpr inline auto integral = detail::integral_fn{};
 
 struct mask
 {
@@ -1070,6 +3611,18 @@ struct mask
 
 struct kernel
 {
+    // mean over a size[0] x size[1] window; convolve computes it from summed-area tables
+    static auto box(extent_t<2, extent_base_t> size) -> detail::apply_kernel_t<1>
+    {
+        mask_t result = mask::rect(size);
+        const float weight = 1.F / static_cast<float>(result.volume());
+        for (float& value : result.m_data)
+        {
+            value = weight;
+        }
+        return result;
+    }
+
     static auto sharpen() -> detail::apply_kernel_t<1>
     {
         return create_mask<3>({ 0.F, -1.F, 0.F, -1.F, 5.F, -1.F, 0.F, -1.F, 0.F });
@@ -1093,41 +3646,45 @@ struct kernel
 
     static auto gaussian(float sigma, location_base_t size) -> detail::apply_kernel_t<1>
     {
-        mask_t mask{ { size, size } };
+        std::vector<float> weights(static_cast<std::size_t>(size));
         const float mean = static_cast<float>(size - 1) / 2.F;
         const float sigma2 = 2.F * sigma * sigma;
 
-        detail::for_each(
-            mask.shape(),
-            [&](const location_t<2>& loc)
-            {
-                const float dx = static_cast<float>(loc[1]) - mean;
-                const float dy = static_cast<float>(loc[0]) - mean;
-                const float value = std::exp(-(dx * dx + dy * dy) / sigma2);
-                mask[loc] = value;
-            });
-        return normalize(mask);
+        for (std::size_t i = 0; i < weights.size(); ++i)
+        {
+            const float d = static_cast<float>(i) - mean;
+            weights[i] = std::exp(-(d * d) / sigma2);
+        }
+        const float sum = std::accumulate(weights.begin(), weights.end(), 0.F);
+        std::transform(weights.begin(), weights.end(), weights.begin(), [=](float value) { return value / sum; });
+        return separable(weights, weights);
+    }
+
+    // mask[y][x] == column[y] * row[x]
+    static auto separable(std::vector<float> column, std::vector<float> row) -> detail::apply_kernel_t<1>
+    {
+        return separable_mask_t{ std::move(column), std::move(row) };
     }
 
     static auto sobel() -> detail::apply_kernel_t<2>
     {
         static const auto gx_mask = create_mask<3>({ -1.F, 0.F, 1.F, -2.F, 0.F, 2.F, -1.F, 0.F, 1.F });
         static const auto gy_mask = create_mask<3>({ -1.F, -2.F, -1.F, 0.F, 0.F, 0.F, 1.F, 2.F, 1.F });
-        return { gx_mask, gy_mask };
+        return detail::apply_kernel_t<2>{ gx_mask, gy_mask };
     }
 
     static auto cross() -> detail::apply_kernel_t<2>
     {
         static const auto gx_mask = create_mask<3>({ 0.F, 0.F, 0.F, -1.F, 0.F, 1.F, 0.F, 0.F, 0.F });
         static const auto gy_mask = create_mask<3>({ 0.F, -1.F, 0.F, 0.F, 0.F, 0.F, 0.F, 1.F, 0.F });
-        return { gx_mask, gy_mask };
+        return detail::apply_kernel_t<2>{ gx_mask, gy_mask };
     }
 
     static auto prewitt() -> detail::apply_kernel_t<2>
     {
         static const auto gx_mask = create_mask<3>({ -1.F, 0.F, 1.F, -1.F, 0.F, 1.F, -1.F, 0.F, 1.F });
         static const auto gy_mask = create_mask<3>({ -1.F, -1.F, -1.F, 0.F, 0.F, 0.F, 1.F, 1.F, 1.F });
-        return { gx_mask, gy_mask };
+        return detail::apply_kernel_t<2>{ gx_mask, gy_mask };
     }
 
     static auto percentile(int rank, mask_t mask) -> detail::percentile_kernel_t { return { rank, std::move(mask) }; }
@@ -1137,6 +3694,21 @@ struct kernel
     static auto dilate(mask_t mask) -> detail::dilation_kernel_t { return { std::move(mask) }; }
     static auto erode(mask_t mask) -> detail::erosion_kernel_t { return { std::move(mask) }; }
 
+    static auto opening(const mask_t& mask) -> detail::morphology_kernel_t
+    {
+        return { detail::morphology_op_t::opening, mask };
+    }
+
+    static auto closing(const mask_t& mask) -> detail::morphology_kernel_t
+    {
+        return { detail::morphology_op_t::closing, mask };
+    }
+
+    static auto gradient(const mask_t& mask) -> detail::morphology_kernel_t
+    {
+        return { detail::morphology_op_t::gradient, mask };
+    }
+
 private:
     static mask_t normalize(mask_t kernel)
     {
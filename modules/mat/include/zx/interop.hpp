@@ -0,0 +1,312 @@
+#pragma once
+
+#include <memory>
+#include <zx/image.hpp>
+#include <zx/mat/mapped_file.hpp>
+
+namespace zx
+{
+namespace mat
+{
+
+// Views onto externally owned buffers (the caller keeps them alive) and shared ownership of our own storage.
+
+enum class channel_order_t
+{
+    rgb,
+    bgr,
+};
+
+inline std::ostream& operator<<(std::ostream& os, channel_order_t item)
+{
+    switch (item)
+    {
+        case channel_order_t::rgb: return os << "rgb";
+        case channel_order_t::bgr: return os << "bgr";
+    }
+    return os;
+}
+
+struct buffer_layout_t
+{
+    extent_base_t height = 0;
+    extent_base_t width = 0;
+    extent_base_t channels = 1;
+    // distances in bytes
+    stride_base_t row_stride = 0;
+    stride_base_t pixel_stride = 0;
+    stride_base_t channel_stride = 0;
+    // bgr - three channels, the first in memory is blue; views still present them in rgb order
+    channel_order_t order = channel_order_t::rgb;
+
+    friend bool operator==(const buffer_layout_t& lhs, const buffer_layout_t& rhs)
+    {
+        return std::tie(
+                   lhs.height, lhs.width, lhs.channels, lhs.row_stride, lhs.pixel_stride, lhs.channel_stride, lhs.order)
+               == std::tie(
+                   rhs.height, rhs.width, rhs.channels, rhs.row_stride, rhs.pixel_stride, rhs.channel_stride, rhs.order);
+    }
+
+    friend bool operator!=(const buffer_layout_t& lhs, const buffer_layout_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const buffer_layout_t& item)
+    {
+        return os << "{"
+                  << ":height " << item.height << " "
+                  << ":width " << item.width << " "
+                  << ":channels " << item.channels << " "
+                  << ":row_stride " << item.row_stride << " "
+                  << ":pixel_stride " << item.pixel_stride << " "
+                  << ":channel_stride " << item.channel_stride << " "
+                  << ":order " << item.order << "}";
+    }
+};
+
+struct buffer_layout
+{
+    // row_pitch 0 - rows are tightly packed
+    template <class T = byte_t>
+    static buffer_layout_t interleaved(
+        extent_base_t height,
+        extent_base_t width,
+        extent_base_t channels,
+        stride_base_t row_pitch = 0,
+        channel_order_t order = channel_order_t::rgb)
+    {
+        const auto element_size = static_cast<stride_base_t>(sizeof(T));
+        const stride_base_t pixel_stride = channels * element_size;
+        return buffer_layout_t{
+            height, width, channels, row_pitch != 0 ? row_pitch : width * pixel_stride, pixel_stride, element_size, order
+        };
+    }
+
+    // plane_pitch 0 - planes follow each other without gaps
+    template <class T = byte_t>
+    static buffer_layout_t planar(
+        extent_base_t height,
+        extent_base_t width,
+        extent_base_t channels,
+        stride_base_t row_pitch = 0,
+        stride_base_t plane_pitch = 0,
+        channel_order_t order = channel_order_t::rgb)
+    {
+        const auto element_size = static_cast<stride_base_t>(sizeof(T));
+        const stride_base_t row_stride = row_pitch != 0 ? row_pitch : width * element_size;
+        return buffer_layout_t{
+            height, width, channels, row_stride, element_size, plane_pitch != 0 ? plane_pitch : height * row_stride, order
+        };
+    }
+
+    template <class T>
+    static buffer_layout_t of(const array_view_base_t<T, 3>& view)
+    {
+        const shape_t<3>& shape = view.shape();
+        return buffer_layout_t{ shape.dim(0).extent, shape.dim(1).extent, shape.dim(2).extent,
+                                shape.dim(0).stride, shape.dim(1).stride, shape.dim(2).stride };
+    }
+
+    template <class T>
+    static buffer_layout_t of(const array_view_base_t<T, 2>& view)
+    {
+        const shape_t<2>& shape = view.shape();
+        return buffer_layout_t{ shape.dim(0).extent,
+                                shape.dim(1).extent,
+                                1,
+                                shape.dim(0).stride,
+                                shape.dim(1).stride,
+                                static_cast<stride_base_t>(sizeof(T)) };
+    }
+};
+
+namespace detail
+{
+
+inline void validate_layout(const void* data, const buffer_layout_t& layout, std::size_t element_size)
+{
+    if (layout.height < 0 || layout.width < 0 || layout.channels < 1)
+    {
+        throw std::invalid_argument{ format("wrap: invalid buffer layout ", layout) };
+    }
+
+    // the channel dimension is reversed as a whole, which would move the alpha of a bgra buffer to the front
+    if (layout.order == channel_order_t::bgr && layout.channels != 3)
+    {
+        throw std::invalid_argument{ format("wrap: bgr order expects 3 channels, got ", layout.channels) };
+    }
+
+    const auto size = static_cast<stride_base_t>(element_size);
+    for (const stride_base_t stride : { layout.row_stride, layout.pixel_stride, layout.channel_stride })
+    {
+        if (stride % size != 0)
+        {
+            throw std::invalid_argument{ format("wrap: stride ", stride, " is not a multiple of element size ", size) };
+        }
+    }
+
+    if (data == nullptr && layout.height * layout.width > 0)
+    {
+        throw std::invalid_argument{ "wrap: null buffer" };
+    }
+}
+
+struct wrap_fn
+{
+    template <class T>
+    auto operator()(T* data, const buffer_layout_t& layout) const -> array_view_base_t<T, 3>
+    {
+        validate_layout(data, layout, sizeof(T));
+
+        const dim_t channel_dim = { layout.channels, layout.channel_stride };
+        const shape_t<3> shape = { dim_t{ layout.height, layout.row_stride },
+                                   dim_t{ layout.width, layout.pixel_stride },
+                                   layout.order == channel_order_t::bgr ? channel_dim.flip() : channel_dim };
+
+        const flat_offset_t offset
+            = layout.order == channel_order_t::bgr ? flat_offset_t{ layout.channels - 1 } * layout.channel_stride : 0;
+        return array_view_base_t<T, 3>{ to_ptr<T*>(to_byte_ptr(data), offset), shape };
+    }
+
+    // single channel buffer; row_pitch 0 - rows are tightly packed
+    template <class T>
+    auto operator()(T* data, const extent_t<2, extent_base_t>& extent, stride_base_t row_pitch = 0) const
+        -> array_view_base_t<T, 2>
+    {
+        const auto element_size = static_cast<stride_base_t>(sizeof(T));
+        const buffer_layout_t layout = buffer_layout::planar<T>(extent[0], extent[1], 1, row_pitch);
+        validate_layout(data, layout, sizeof(T));
+        return array_view_base_t<T, 2>{ data,
+                                        shape_t<2>{ dim_t{ layout.height, layout.row_stride },
+                                                    dim_t{ layout.width, element_size } } };
+    }
+};
+
+struct wrap_image_fn
+{
+    rgb_image_t::view_type operator()(const byte_t* data, const buffer_layout_t& layout) const
+    {
+        return rgb_image_t::view_type{ wrap_channels(data, layout) };
+    }
+
+    rgb_image_t::mut_view_type operator()(byte_t* data, const buffer_layout_t& layout) const
+    {
+        return rgb_image_t::mut_view_type{ wrap_channels(data, layout) };
+    }
+
+private:
+    template <class T>
+    static auto wrap_channels(T* data, const buffer_layout_t& layout) -> array_view_base_t<T, 3>
+    {
+        if (layout.channels != 3)
+        {
+            throw std::invalid_argument{ format("wrap_image: expected 3 channels, got ", layout.channels) };
+        }
+        return wrap_fn{}(data, layout);
+    }
+};
+
+}  // namespace detail
+
+// Storage moved out of an array or image; owner() can outlive this object.
+template <class T, std::size_t D>
+struct shared_array_t
+{
+    using view_type = array_view_t<T, D>;
+    using mut_view_type = array_mut_view_t<T, D>;
+
+    std::shared_ptr<array_t<T, D>> m_array;
+
+    explicit shared_array_t(array_t<T, D> array) : m_array{ std::make_shared<array_t<T, D>>(std::move(array)) } { }
+
+    view_type view() const { return m_array->view(); }
+    mut_view_type mut_view() const { return m_array->mut_view(); }
+
+    T* data() const { return m_array->m_data.data(); }
+
+    const shape_t<D>& shape() const { return m_array->shape(); }
+
+    // pointer to the first element sharing ownership of the whole storage
+    std::shared_ptr<T> owner() const { return std::shared_ptr<T>{ m_array, data() }; }
+};
+
+namespace detail
+{
+
+struct share_fn
+{
+    template <class T, std::size_t D>
+    auto operator()(array_t<T, D>&& array) const -> shared_array_t<T, D>
+    {
+        return shared_array_t<T, D>{ std::move(array) };
+    }
+
+    template <extent_base_t Channels>
+    auto operator()(image_base_t<Channels>&& image) const -> shared_array_t<byte_t, 3>
+    {
+        return shared_array_t<byte_t, 3>{ std::move(image.m_data) };
+    }
+};
+
+}  // namespace detail
+
+// Read-only view of a 24-bit bitmap file that is mapped into memory instead of decoded; copies share the mapping.
+struct mapped_bitmap_t
+{
+    std::shared_ptr<const byte_t> m_file;
+    rgb_image_t::view_type m_view;
+
+    rgb_image_t::view_type view() const { return m_view; }
+    rgb_image_t::extent_type extent() const { return m_view.extent(); }
+};
+
+namespace detail
+{
+
+struct map_bitmap_fn
+{
+    // Bottom-up rows get a negative row stride, the bgr pixels a reversed channel dimension.
+    auto operator()(const filepath_t& path) const -> mapped_bitmap_t
+    {
+        std::ifstream fs = load_bitmap_fn::open(path);
+        const bmp_header bmp_hdr = bmp_header::load(fs);
+        const dib_header dib_hdr = dib_header::load(fs);
+        if (!fs || dib_hdr.bits_per_pixel != 24 || dib_hdr.compression != 0)
+        {
+            throw std::runtime_error{ str("map_bitmap: '", path, "' is not an uncompressed 24-bit bitmap") };
+        }
+        fs.close();
+
+        // a negative height marks rows stored top-down
+        const auto height = static_cast<std::int32_t>(static_cast<std::uint32_t>(dib_hdr.height));
+        const auto h = static_cast<extent_base_t>(height < 0 ? -height : height);
+        const auto w = static_cast<extent_base_t>(dib_hdr.width);
+        const auto row_bytes = static_cast<stride_base_t>(3 * dib_hdr.width + get_padding(dib_hdr.width, 24));
+
+        std::size_t size = 0;
+        std::shared_ptr<const byte_t> file = map_file(path.m_path, size);
+        if (!file)
+        {
+            throw std::runtime_error{ str("map_bitmap: can not map file '", path, "'") };
+        }
+        if (size < bmp_hdr.data_offset + static_cast<std::size_t>(h) * static_cast<std::size_t>(row_bytes))
+        {
+            throw std::runtime_error{ str("map_bitmap: '", path, "' is truncated") };
+        }
+
+        const byte_t* pixels = file.get() + bmp_hdr.data_offset;
+        const bool bottom_up = height > 0;
+        const byte_t* first_row = bottom_up && h > 0 ? pixels + flat_offset_t{ h - 1 } * row_bytes : pixels;
+        const buffer_layout_t layout
+            = buffer_layout::interleaved(h, w, 3, bottom_up ? -row_bytes : row_bytes, channel_order_t::bgr);
+        return mapped_bitmap_t{ std::move(file), wrap_image_fn{}(first_row, layout) };
+    }
+};
+
+}  // namespace detail
+
+static constexpr inline auto wrap = detail::wrap_fn{};
+static constexpr inline auto wrap_image = detail::wrap_image_fn{};
+static constexpr inline auto share = detail::share_fn{};
+static constexpr inline auto map_bitmap = detail::map_bitmap_fn{};
+
+}  // namespace mat
+}  // namespace zx
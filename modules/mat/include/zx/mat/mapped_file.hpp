@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32) && __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ZX_MAT_HAS_MMAP
+#endif
+
+namespace zx
+{
+namespace mat
+{
+namespace detail
+{
+
+// Read-only contents of a whole file, memory-mapped where the platform allows it; null if the file can not be read.
+inline std::shared_ptr<const std::uint8_t> map_file(const std::string& path, std::size_t& size)
+{
+#ifdef ZX_MAT_HAS_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat info = {};
+    void* data = ::fstat(fd, &info) == 0 && info.st_size > 0
+                     ? ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0)
+                     : MAP_FAILED;
+    ::close(fd);
+    if (data == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    size = static_cast<std::size_t>(info.st_size);
+    return std::shared_ptr<const std::uint8_t>{ static_cast<const std::uint8_t*>(data),
+                                                [size](const std::uint8_t* ptr)
+                                                { ::munmap(const_cast<std::uint8_t*>(ptr), size); } };
+#else
+    std::ifstream fs(path, std::ifstream::binary);
+    if (!fs)
+    {
+        return nullptr;
+    }
+    auto buffer = std::make_shared<std::vector<std::uint8_t>>(
+        std::istreambuf_iterator<char>{ fs }, std::istreambuf_iterator<char>{});
+    size = buffer->size();
+    return std::shared_ptr<const std::uint8_t>{ buffer, buffer->data() };
+#endif
+}
+
+#undef ZX_MAT_HAS_MMAP
+
+}  // namespace detail
+}  // namespace mat
+}  // namespace zx
@@ -0,0 +1,341 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <zx/array.hpp>
+#include <zx/function_ref.hpp>
+
+namespace zx
+{
+namespace mat
+{
+
+struct execution_t
+{
+    // 0 - use all threads of the pool
+    std::size_t thread_count = 1;
+    // 0 - derive the band height from the thread count
+    extent_base_t band_height = 0;
+    // bands depend only on band_height, never on the thread count or scheduling
+    bool deterministic = false;
+
+    friend bool operator==(const execution_t& lhs, const execution_t& rhs)
+    {
+        return std::tie(lhs.thread_count, lhs.band_height, lhs.deterministic)
+               == std::tie(rhs.thread_count, rhs.band_height, rhs.deterministic);
+    }
+
+    friend bool operator!=(const execution_t& lhs, const execution_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const execution_t& item)
+    {
+        return os << "{"
+                  << ":thread_count " << item.thread_count << " "
+                  << ":band_height " << item.band_height << " "
+                  << ":deterministic " << item.deterministic << "}";
+    }
+};
+
+struct execution
+{
+    static constexpr extent_base_t default_band_height = 16;
+
+    static execution_t sequential() { return execution_t{ 1, 0, false }; }
+
+    static execution_t parallel(std::size_t thread_count = 0) { return execution_t{ thread_count, 0, false }; }
+
+    static execution_t deterministic(std::size_t thread_count = 0, extent_base_t band_height = default_band_height)
+    {
+        return execution_t{ thread_count, band_height, true };
+    }
+};
+
+struct thread_pool_t
+{
+    using task_type = function_ref<void(std::size_t)>;
+
+    explicit thread_pool_t(std::size_t worker_count)
+    {
+        m_workers.reserve(worker_count);
+        for (std::size_t i = 0; i < worker_count; ++i)
+        {
+            m_workers.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t(thread_pool_t&&) = delete;
+    thread_pool_t& operator=(const thread_pool_t&) = delete;
+    thread_pool_t& operator=(thread_pool_t&&) = delete;
+
+    ~thread_pool_t()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    static thread_pool_t& instance()
+    {
+        static thread_pool_t pool{ std::max(std::thread::hardware_concurrency(), 1U) - 1U };
+        return pool;
+    }
+
+    // number of threads taking part in run(), including the calling thread
+    std::size_t concurrency() const { return m_workers.size() + 1; }
+
+    void run(std::size_t task_count, std::size_t max_concurrency, task_type task)
+    {
+        const std::size_t helper_count = std::min(std::max<std::size_t>(max_concurrency, 1), concurrency()) - 1;
+
+        if (task_count == 0)
+        {
+            return;
+        }
+
+        if (task_count == 1 || helper_count == 0 || is_inside_run())
+        {
+            for (std::size_t i = 0; i < task_count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_lock{ m_run_mutex };
+
+        job_t job{ std::move(task), task_count };
+        job.helper_slots = helper_count;
+
+        {
+            std::lock_guard<std::mutex> lock{ m_mutex };
+            m_job = &job;
+            m_pending_workers = m_workers.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        {
+            const inside_run_guard guard{};
+            execute(job);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock{ m_mutex };
+            m_done.wait(lock, [&]() { return m_pending_workers == 0; });
+            m_job = nullptr;
+        }
+
+        if (job.error)
+        {
+            std::rethrow_exception(job.error);
+        }
+    }
+
+private:
+    struct job_t
+    {
+        task_type task;
+        std::size_t task_count;
+        std::atomic<std::size_t> next_task = 0;
+        std::atomic<std::size_t> helper_slots = 0;
+        std::mutex error_mutex = {};
+        std::exception_ptr error = {};
+
+        job_t(task_type t, std::size_t count) : task{ std::move(t) }, task_count{ count } { }
+    };
+
+    struct inside_run_guard
+    {
+        inside_run_guard() { is_inside_run() = true; }
+        ~inside_run_guard() { is_inside_run() = false; }
+    };
+
+    static bool& is_inside_run()
+    {
+        static thread_local bool value = false;
+        return value;
+    }
+
+    static void execute(job_t& job)
+    {
+        for (std::size_t i = job.next_task++; i < job.task_count; i = job.next_task++)
+        {
+            try
+            {
+                job.task(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{ job.error_mutex };
+                if (!job.error)
+                {
+                    job.error = std::current_exception();
+                }
+                job.next_task = job.task_count;
+            }
+        }
+    }
+
+    static bool try_join(job_t& job)
+    {
+        std::size_t slots = job.helper_slots.load();
+        while (slots > 0)
+        {
+            if (job.helper_slots.compare_exchange_weak(slots, slots - 1))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop()
+    {
+        is_inside_run() = true;
+        std::uint64_t seen_generation = 0;
+        while (true)
+        {
+            job_t* job = nullptr;
+            {
+                std::unique_lock<std::mutex> lock{ m_mutex };
+                m_wake.wait(lock, [&]() { return m_stop || m_generation != seen_generation; });
+                if (m_stop)
+                {
+                    return;
+                }
+                seen_generation = m_generation;
+                job = m_job;
+            }
+
+            if (try_join(*job))
+            {
+                execute(*job);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ m_mutex };
+                --m_pending_workers;
+            }
+            m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    job_t* m_job = nullptr;
+    std::size_t m_pending_workers = 0;
+    std::uint64_t m_generation = 0;
+    bool m_stop = false;
+};
+
+namespace detail
+{
+
+inline std::size_t thread_count(const execution_t& policy)
+{
+    const std::size_t available = thread_pool_t::instance().concurrency();
+    return policy.thread_count == 0 ? available : std::min(policy.thread_count, available);
+}
+
+inline extent_base_t band_height(const execution_t& policy, extent_base_t height, std::size_t threads)
+{
+    if (policy.band_height > 0)
+    {
+        return policy.band_height;
+    }
+    if (policy.deterministic)
+    {
+        return execution::default_band_height;
+    }
+    const auto band_count = static_cast<extent_base_t>(threads * 4);
+    return std::max(extent_base_t{ 1 }, (height + band_count - 1) / band_count);
+}
+
+// Splits [0, height) into row bands and calls func(first, last) once per band.
+template <class Func>
+void for_each_band(const execution_t& policy, extent_base_t height, Func&& func)
+{
+    if (height <= 0)
+    {
+        return;
+    }
+
+    const std::size_t threads = policy.deterministic || policy.thread_count != 1 ? thread_count(policy) : 1;
+
+    if (threads == 1 && !policy.deterministic)
+    {
+        func(location_base_t{ 0 }, location_base_t{ height });
+        return;
+    }
+
+    const extent_base_t band = band_height(policy, height, threads);
+    const auto band_count = static_cast<std::size_t>((height + band - 1) / band);
+
+    thread_pool_t::instance().run(
+        band_count,
+        threads,
+        [&](std::size_t index)
+        {
+            const auto first = static_cast<location_base_t>(index) * band;
+            func(first, std::min(first + band, height));
+        });
+}
+
+template <std::size_t D, class Func>
+void for_each(const shape_t<D>& shape, Func&& func)
+{
+    const extent_base_t h = shape[0].extent;
+    const extent_base_t w = shape[1].extent;
+
+    for (location_base_t y = 0; y < h; ++y)
+    {
+        for (location_base_t x = 0; x < w; ++x)
+        {
+            func(location_t<2>{ y, x });
+        }
+    }
+}
+
+template <std::size_t D, class Func>
+void for_each(const execution_t& policy, const shape_t<D>& shape, Func&& func)
+{
+    const extent_base_t w = shape[1].extent;
+
+    for_each_band(
+        policy,
+        shape[0].extent,
+        [&](location_base_t first, location_base_t last)
+        {
+            for (location_base_t y = first; y < last; ++y)
+            {
+                for (location_base_t x = 0; x < w; ++x)
+                {
+                    func(location_t<2>{ y, x });
+                }
+            }
+        });
+}
+
+}  // namespace detail
+
+}  // namespace mat
+}  // namespace zx
@@ -1,11 +1,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <numeric>
+#include <ostream>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <zx/array.hpp>
+#include <zx/function_ref.hpp>
 
 namespace zx
 {
@@ -392,65 +399,718 @@ private:
     }
 };
 
+// Pen of draw_line, draw_circle and draw_rectangle; antialiased strokes blend edge pixels by their coverage.
+struct stroke_t
+{
+    float width = 1.F;
+    bool antialiased = false;
+
+    friend bool operator==(const stroke_t& lhs, const stroke_t& rhs)
+    {
+        return std::tie(lhs.width, lhs.antialiased) == std::tie(rhs.width, rhs.antialiased);
+    }
+
+    friend bool operator!=(const stroke_t& lhs, const stroke_t& rhs) { return !(lhs == rhs); }
+
+    friend std::ostream& operator<<(std::ostream& os, const stroke_t& item)
+    {
+        return os << "{"
+                  << ":width " << item.width << " "
+                  << ":antialiased " << item.antialiased << "}";
+    }
+};
+
+struct stroke
+{
+    static stroke_t solid(float width = 1.F) { return stroke_t{ width, false }; }
+    static stroke_t smooth(float width = 1.F) { return stroke_t{ width, true }; }
+};
+
 namespace detail
 {
 
-struct rasterize_fn
+// Calls func(a, b) for the offsets { a, b } of one octant of the midpoint circle, from { radius, 0 } to the diagonal.
+template <class Func>
+void midpoint_octant(location_base_t radius, Func&& func)
 {
-    raster_t operator()(const rectangle_t<location_base_t>& shape) const
+    vector_t<2, location_base_t> cur{ radius, 0 };
+    int err = 0;
+
+    while (cur[0] >= cur[1])
     {
-        raster_t::shape_t raster_shape;
+        func(cur[0], cur[1]);
 
-        for (location_base_t y = shape[0].get(side_t::lower); y < shape[0].get(side_t::upper); ++y)
+        if (err <= 0)
         {
-            raster_shape.emplace(
-                y, std::vector<interval_type>{ { shape[1].get(side_t::lower), shape[1].get(side_t::upper) } });
+            cur[1] += 1;
+            err += 2 * cur[1] + 1;
         }
 
-        return raster_t{ { raster_shape } };
+        if (err > 0)
+        {
+            cur[0] -= 1;
+            err -= 2 * cur[0] + 1;
+        }
     }
+}
 
-    raster_t operator()(const circle_t<location_base_t>& shape) const
+// Calls func(y, span) for every row of a filled circle, top to bottom, ending on the pixels of the midpoint circle.
+template <class Func>
+void circle_spans(const circle_t<location_base_t>& shape, Func&& func)
+{
+    if (shape.radius < 0)
     {
-        raster_t::shape_t raster_shape;
-        const auto center = shape.center;
+        return;
+    }
+
+    // half widths of the rows by their distance from the center
+    std::vector<location_base_t> half(static_cast<std::size_t>(shape.radius) + 1, 0);
+    midpoint_octant(
+        shape.radius,
+        [&](location_base_t a, location_base_t b)
+        {
+            half[static_cast<std::size_t>(b)] = std::max(half[static_cast<std::size_t>(b)], a);
+            half[static_cast<std::size_t>(a)] = std::max(half[static_cast<std::size_t>(a)], b);
+        });
+
+    const auto center = shape.center;
+    for (location_base_t dy = -shape.radius; dy <= shape.radius; ++dy)
+    {
+        const location_base_t h = half[static_cast<std::size_t>(std::abs(dy))];
+        func(center[0] + dy, interval_type{ center[1] - h, center[1] + h + 1 });
+    }
+}
+
+// Calls func(y, spans) for every row of a filled polygon, top to bottom, with the sorted disjoint spans of pixels
+// whose centers lie inside by the even-odd rule. Edges cover the rows from their upper end up to, not including,
+// their lower end and the columns from their left crossing up to, not including, the right one, so polygons sharing
+// an edge do not overlap and an axis-aligned polygon covers the pixels of the same rectangle_t. Crossings are
+// computed in exact integer arithmetic.
+template <class Func>
+void polygon_spans(const polygon_t<2, location_base_t>& polygon, Func&& func)
+{
+    struct edge_t
+    {
+        location_base_t y0;
+        location_base_t y1;
+        std::int64_t x0;
+        std::int64_t dx;
+    };
+
+    std::vector<edge_t> edges;
+    for (std::size_t i = 0; i < polygon.size(); ++i)
+    {
+        auto a = polygon[i];
+        auto b = polygon[(i + 1) % polygon.size()];
+        if (a[0] == b[0])
+        {
+            continue;
+        }
+        if (a[0] > b[0])
+        {
+            std::swap(a, b);
+        }
+        edges.push_back(edge_t{ a[0], b[0], a[1], std::int64_t{ b[1] } - a[1] });
+    }
+    if (edges.empty())
+    {
+        return;
+    }
+    std::sort(edges.begin(), edges.end(), [](const edge_t& lhs, const edge_t& rhs) { return lhs.y0 < rhs.y0; });
+
+    const location_base_t last = std::max_element(
+                                     edges.begin(),
+                                     edges.end(),
+                                     [](const edge_t& lhs, const edge_t& rhs) { return lhs.y1 < rhs.y1; })
+                                     ->y1;
+    std::vector<const edge_t*> active;
+    std::vector<location_base_t> crossings;
+    std::vector<interval_type> spans;
+    std::size_t next = 0;
+
+    for (location_base_t y = edges.front().y0; y < last; ++y)
+    {
+        for (; next < edges.size() && edges[next].y0 <= y; ++next)
+        {
+            active.push_back(&edges[next]);
+        }
+        active.erase(
+            std::remove_if(active.begin(), active.end(), [&](const edge_t* edge) { return edge->y1 <= y; }), active.end());
+
+        // the first pixel center at or right of every crossing
+        crossings.clear();
+        for (const edge_t* edge : active)
+        {
+            const std::int64_t height = edge->y1 - edge->y0;
+            const std::int64_t numerator = edge->x0 * height + (y - edge->y0) * edge->dx;
+            const std::int64_t quotient = numerator / height;
+            crossings.push_back(static_cast<location_base_t>(quotient + (quotient * height < numerator ? 1 : 0)));
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        spans.clear();
+        for (std::size_t i = 0; i + 1 < crossings.size(); i += 2)
+        {
+            if (crossings[i] < crossings[i + 1])
+            {
+                spans.push_back(interval_type{ crossings[i], crossings[i + 1] });
+            }
+        }
+        if (!spans.empty())
+        {
+            func(y, spans);
+        }
+    }
+}
 
-        auto output_row = [&](location_base_t y, interval_type interval)
+inline std::int64_t floor_div(std::int64_t num, std::int64_t den)
+{
+    const std::int64_t quotient = num / den;
+    return quotient - (quotient * den > num ? 1 : 0);
+}
+
+// floor((a * b + c) / den) and the remainder in [0, den), exact for 0 < den < 2^32 whenever the quotient fits in
+// int64_t; a * b itself may not, so both factors are reduced modulo den first.
+inline std::pair<std::int64_t, std::int64_t> floor_mul_div(
+    std::int64_t a, std::int64_t b, std::int64_t c, std::int64_t den)
+{
+    const std::int64_t qa = floor_div(a, den);
+    const std::int64_t qb = floor_div(b, den);
+    const auto ra = static_cast<std::uint64_t>(a - qa * den);
+    const auto rb = static_cast<std::uint64_t>(b - qb * den);
+    const std::uint64_t low = ra * rb;
+    const std::int64_t rest = static_cast<std::int64_t>(low % static_cast<std::uint64_t>(den)) + c;
+    const std::int64_t q = floor_div(rest, den);
+    const std::int64_t quotient
+        = qa * b + static_cast<std::int64_t>(ra) * qb + static_cast<std::int64_t>(low / static_cast<std::uint64_t>(den));
+    return { quotient + q, rest - q * den };
+}
+
+// Joins the pixels of a walk into runs of one row and coverage, passed on as func(y, first, last, coverage).
+template <class Func>
+struct run_joiner_t
+{
+    Func& m_func;
+    location_base_t m_y = 0;
+    interval_type m_run = interval_type{ 0, 0 };
+    float m_coverage = 0.F;
+
+    void operator()(location_base_t y, location_base_t x, float coverage)
+    {
+        if (y == m_y && coverage == m_coverage && m_run[0] < m_run[1])
         {
-            auto [it, inserted] = raster_shape.emplace(y, std::vector<interval_type>{});
-            if (inserted || it->second.empty())
+            if (x == m_run[1])
+            {
+                ++m_run[1];
+                return;
+            }
+            if (x + 1 == m_run[0])
             {
-                it->second.push_back(interval);
+                --m_run[0];
                 return;
             }
+        }
+        flush();
+        m_y = y;
+        m_run = interval_type{ x, x + 1 };
+        m_coverage = coverage;
+    }
+
+    void flush()
+    {
+        if (m_run[0] < m_run[1])
+        {
+            m_func(m_y, m_run[0], m_run[1], m_coverage);
+        }
+        m_run = interval_type{ 0, 0 };
+    }
+};
+
+// Steps [lower, upper] of a walk from start along dir whose coordinate d falls in the clip interval.
+inline std::pair<std::int64_t, std::int64_t> clip_steps(
+    const location_t<2>& start, std::size_t d, location_base_t dir, const rectangle_t<location_base_t>& clip)
+{
+    const std::int64_t first = clip[d][0];
+    const std::int64_t last = std::int64_t{ clip[d][1] } - 1;
+    return dir > 0 ? std::pair{ first - start[d], last - start[d] } : std::pair{ start[d] - last, start[d] - first };
+}
+
+// Calls func(y, first, last, 1.F) for the Bresenham line runs in clip; the steps inside clip are solved in closed form.
+template <class Func>
+void line_runs(
+    const location_t<2>& start, const location_t<2>& end, const rectangle_t<location_base_t>& clip, Func&& func)
+{
+    const std::size_t a
+        = std::abs(std::int64_t{ end[0] } - start[0]) > std::abs(std::int64_t{ end[1] } - start[1]) ? 0 : 1;
+    const std::size_t b = 1 - a;
+    const std::int64_t n = std::abs(std::int64_t{ end[a] } - start[a]);
+    const std::int64_t m = std::abs(std::int64_t{ end[b] } - start[b]);
+    const location_base_t dir_a = end[a] < start[a] ? -1 : 1;
+    const location_base_t dir_b = end[b] < start[b] ? -1 : 1;
+    const std::int64_t h = n / 2;
+
+    auto [lower, upper] = clip_steps(start, a, dir_a, clip);
+    lower = std::max(lower, std::int64_t{ 0 });
+    upper = std::min(upper, n);
+    const auto [minor_lower, minor_upper] = clip_steps(start, b, dir_b, clip);
+    if (lower > upper)
+    {
+        return;
+    }
+    if (m == 0)
+    {
+        if (minor_lower > 0 || minor_upper < 0)
+        {
+            return;
+        }
+    }
+    else
+    {
+        // the minor offset runs over [0, m], so the bounds are clamped to it before scaling by n
+        if (minor_lower > m || minor_upper < 0)
+        {
+            return;
+        }
+        lower = std::max(lower, floor_mul_div(std::max(minor_lower, std::int64_t{ 0 }) - 1, n, h, m).first + 1);
+        upper = std::min(upper, floor_mul_div(std::min(minor_upper, m), n, h, m).first);
+    }
+    if (lower > upper)
+    {
+        return;
+    }
 
-            auto& span = it->second.front();
-            span[0] = std::min(span[0], interval[0]);
-            span[1] = std::max(span[1], interval[1]);
+    // the minor offset q and the error q * n - (k * m - h), which stays in [0, n)
+    const auto [neg_q, rem] = n == 0 ? std::pair<std::int64_t, std::int64_t>{ 0, 0 } : floor_mul_div(-lower, m, h, n);
+    std::int64_t q = -neg_q;
+    std::int64_t err = rem;
+    run_joiner_t<std::remove_reference_t<Func>> join{ func };
+    location_t<2> loc;
+    for (std::int64_t k = lower; k <= upper; ++k)
+    {
+        loc[a] = start[a] + dir_a * static_cast<location_base_t>(k);
+        loc[b] = start[b] + dir_b * static_cast<location_base_t>(q);
+        join(loc[0], loc[1], 1.F);
+        err -= m;
+        if (err < 0)
+        {
+            ++q;
+            err += n;
+        }
+    }
+    join.flush();
+}
+
+// Calls func(y, first, last, coverage) for the antialiased line by Xiaolin Wu's algorithm, clipped as in line_runs.
+template <class Func>
+void wu_line_runs(
+    const location_t<2>& start,
+    const location_t<2>& end,
+    const rectangle_t<location_base_t>& clip,
+    float weight,
+    Func&& func)
+{
+    const std::size_t a
+        = std::abs(std::int64_t{ end[0] } - start[0]) > std::abs(std::int64_t{ end[1] } - start[1]) ? 0 : 1;
+    const std::size_t b = 1 - a;
+    const std::int64_t n = std::abs(std::int64_t{ end[a] } - start[a]);
+    const std::int64_t rise = std::int64_t{ end[b] } - start[b];
+    const location_base_t dir_a = end[a] < start[a] ? -1 : 1;
+
+    auto [lower, upper] = clip_steps(start, a, dir_a, clip);
+    lower = std::max(lower, std::int64_t{ 0 });
+    upper = std::min(upper, n);
+    if (lower > upper)
+    {
+        return;
+    }
+    if (rise != 0)
+    {
+        // steps whose lower pixel may lie in [clip[b][0] - 1, clip[b][1]), left to the painter to clip exactly
+        const std::int64_t den = std::abs(rise);
+        const std::int64_t sign = rise > 0 ? 1 : -1;
+        // the minor offset runs over [0, den], so the bounds are clamped just past it before scaling by n
+        const auto steps = [&](std::int64_t bound)
+        {
+            const std::int64_t offset = std::clamp(sign * (bound - start[b]), std::int64_t{ -1 }, den + 1);
+            return floor_mul_div(offset, n, 0, den).first;
         };
+        const std::int64_t from = steps(std::int64_t{ clip[b][0] } - 1);
+        const std::int64_t to = steps(clip[b][1]);
+        lower = std::max(lower, std::min(from, to));
+        upper = std::min(upper, std::max(from, to) + 1);
+    }
+    else if (start[b] < clip[b][0] || start[b] >= clip[b][1])
+    {
+        return;
+    }
+    if (lower > upper)
+    {
+        return;
+    }
+
+    run_joiner_t<std::remove_reference_t<Func>> join{ func };
+    location_t<2> loc;
+    for (std::int64_t k = lower; k <= upper; ++k)
+    {
+        // exact minor position start[b] + k * rise / n, as a pixel and the fraction past it
+        const auto [offset, rem] = n == 0 ? std::pair<std::int64_t, std::int64_t>{ 0, 0 } : floor_mul_div(k, rise, 0, n);
+        const float fraction = n == 0 ? 0.F : static_cast<float>(rem) / static_cast<float>(n);
+        loc[a] = start[a] + dir_a * static_cast<location_base_t>(k);
+        loc[b] = start[b] + static_cast<location_base_t>(offset);
+        join(loc[0], loc[1], weight * (1.F - fraction));
+        if (fraction > 0.F)
+        {
+            loc[b] += 1;
+            join(loc[0], loc[1], weight * fraction);
+        }
+    }
+    join.flush();
+}
 
-        vector_t<2, location_base_t> cur{ shape.radius, 0 };
-        int err = 0;
+// Distances from a shape up to which pixel centers are touched (outer) and covered entirely (full) by a stroke.
+struct stroke_profile_t
+{
+    double half;
+    double outer;
+    double full;
+
+    explicit stroke_profile_t(const stroke_t& pen)
+        : half{ std::max(pen.width, 0.F) / 2.0 }
+        , outer{ pen.antialiased ? half + 0.5 : half }
+        , full{ pen.antialiased ? half - 0.5 : half }
+    {
+    }
 
-        while (cur[0] >= cur[1])
+    float coverage(double distance) const { return static_cast<float>(std::clamp(half + 0.5 - distance, 0.0, 1.0)); }
+};
+
+// Calls func(y, first, last, coverage) for a round-capped stroke of the segment, cut row by row from the capsule.
+template <class Func>
+void thick_line_runs(
+    const location_t<2>& start,
+    const location_t<2>& end,
+    const stroke_t& pen,
+    const rectangle_t<location_base_t>& clip,
+    Func&& func)
+{
+    const stroke_profile_t profile{ pen };
+    const double y0 = start[0];
+    const double x0 = start[1];
+    const double uy = end[0] - start[0];
+    const double ux = end[1] - start[1];
+    const double length2 = uy * uy + ux * ux;
+    const double length = std::sqrt(length2);
+
+    // columns of row y within radius of the segment, empty when lower > upper
+    const auto row_extent = [&](double y, double radius)
+    {
+        double lower = std::numeric_limits<double>::infinity();
+        double upper = -lower;
+        for (const auto& [cy, cx] : { std::pair{ y0, x0 }, std::pair{ y0 + uy, x0 + ux } })
+        {
+            const double w2 = radius * radius - (y - cy) * (y - cy);
+            if (w2 >= 0.0)
+            {
+                lower = std::min(lower, cx - std::sqrt(w2));
+                upper = std::max(upper, cx + std::sqrt(w2));
+            }
+        }
+        if (length2 > 0.0)
+        {
+            // 0 <= (p - start) . u <= |u|^2 and |(p - start) x u| <= radius * |u|, both linear in x
+            double band_lower = -std::numeric_limits<double>::infinity();
+            double band_upper = -band_lower;
+            const auto constrain = [&](double slope, double offset, double min, double max)
+            {
+                if (slope == 0.0)
+                {
+                    if (offset < min || offset > max)
+                    {
+                        band_upper = band_lower;
+                        band_lower = std::numeric_limits<double>::infinity();
+                    }
+                    return;
+                }
+                const double p = (min - offset) / slope;
+                const double q = (max - offset) / slope;
+                band_lower = std::max(band_lower, std::min(p, q));
+                band_upper = std::min(band_upper, std::max(p, q));
+            };
+            const double dy = y - y0;
+            constrain(ux, dy * uy - x0 * ux, 0.0, length2);
+            constrain(uy, -x0 * uy - dy * ux, -radius * length, radius * length);
+            if (band_lower <= band_upper)
+            {
+                lower = std::min(lower, band_lower);
+                upper = std::max(upper, band_upper);
+            }
+        }
+        return std::pair{ lower, upper };
+    };
+
+    const auto distance = [&](double y, double x)
+    {
+        const double t = length2 > 0.0 ? std::clamp(((y - y0) * uy + (x - x0) * ux) / length2, 0.0, 1.0) : 0.0;
+        const double dy = y - y0 - t * uy;
+        const double dx = x - x0 - t * ux;
+        return std::sqrt(dy * dy + dx * dx);
+    };
+
+    const double clip_first = clip[1][0];
+    const double clip_last = clip[1][1] - 1;
+    const double top = std::min(y0, y0 + uy) - profile.outer;
+    const double bottom = std::max(y0, y0 + uy) + profile.outer;
+    const auto first_row = static_cast<location_base_t>(std::max(std::ceil(top), static_cast<double>(clip[0][0])));
+    const auto last_row = static_cast<location_base_t>(std::min(std::floor(bottom), clip[0][1] - 1.0));
+    for (location_base_t y = first_row; y <= last_row; ++y)
+    {
+        const auto [lower, upper] = row_extent(y, profile.outer);
+        const double first = std::max(std::ceil(lower), clip_first);
+        const double last = std::min(std::floor(upper), clip_last);
+        if (first > last)
         {
-            output_row(center[0] + cur[1], { center[1] - cur[0], center[1] + cur[0] + 1 });
-            output_row(center[0] - cur[1], { center[1] - cur[0], center[1] + cur[0] + 1 });
-            output_row(center[0] + cur[0], { center[1] - cur[1], center[1] + cur[1] + 1 });
-            output_row(center[0] - cur[0], { center[1] - cur[1], center[1] + cur[1] + 1 });
+            continue;
+        }
+        auto x = static_cast<location_base_t>(first);
+        const auto x_last = static_cast<location_base_t>(last);
+        if (!pen.antialiased)
+        {
+            func(y, x, x_last + 1, 1.F);
+            continue;
+        }
 
-            if (err <= 0)
+        auto [full_first, full_last] = std::pair{ x_last + 1, x_last };
+        if (profile.full > 0.0)
+        {
+            const auto [full_lower, full_upper] = row_extent(y, profile.full);
+            if (full_lower <= full_upper)
             {
-                cur[1] += 1;
-                err += 2 * cur[1] + 1;
+                full_first = static_cast<location_base_t>(std::clamp(std::ceil(full_lower), first, last + 1));
+                full_last = static_cast<location_base_t>(std::clamp(std::floor(full_upper), first - 1, last));
             }
+        }
+        const auto edge = [&](location_base_t from, location_base_t to)
+        {
+            for (location_base_t i = from; i <= to; ++i)
+            {
+                const float coverage = profile.coverage(distance(y, i));
+                if (coverage > 0.F)
+                {
+                    func(y, i, i + 1, coverage);
+                }
+            }
+        };
+        if (full_first > full_last)
+        {
+            edge(x, x_last);
+            continue;
+        }
+        edge(x, full_first - 1);
+        func(y, full_first, full_last + 1, 1.F);
+        edge(full_last + 1, x_last);
+    }
+}
+
+// Calls func(y, first, last, coverage) for a stroke of the circle, each row between two pairs of concentric circles.
+template <class Func>
+void ring_runs(
+    const circle_t<location_base_t>& circle, const stroke_t& pen, const rectangle_t<location_base_t>& clip, Func&& func)
+{
+    const stroke_profile_t profile{ pen };
+    const double radius = circle.radius;
+    if (radius + profile.outer < 0.0)
+    {
+        return;
+    }
+    const location_base_t cy = circle.center[0];
+    const location_base_t cx = circle.center[1];
+
+    // distances |dx| from the center of the pixels of row dy with centers at [from, to] from it
+    const auto columns = [](double dy, double from, double to)
+    {
+        if (to < 0.0 || to * to < dy * dy)
+        {
+            return std::pair{ location_base_t{ 1 }, location_base_t{ 0 } };
+        }
+        const double upper = std::floor(std::sqrt(to * to - dy * dy));
+        const double lower = from > 0.0 && from * from > dy * dy ? std::ceil(std::sqrt(from * from - dy * dy)) : 0.0;
+        return std::pair{ static_cast<location_base_t>(lower), static_cast<location_base_t>(upper) };
+    };
+    // both halves of the row, the center column once
+    const auto emit = [&](location_base_t y, location_base_t first, location_base_t last, float coverage)
+    {
+        if (first == 0)
+        {
+            func(y, cx - last, cx + last + 1, coverage);
+            return;
+        }
+        func(y, cx - last, cx - first + 1, coverage);
+        func(y, cx + first, cx + last + 1, coverage);
+    };
+
+    const auto reach = static_cast<location_base_t>(std::floor(radius + profile.outer));
+    const location_base_t first_row = std::max(-reach, clip[0][0] - cy);
+    const location_base_t last_row = std::min(reach, clip[0][1] - 1 - cy);
+    for (location_base_t dy = first_row; dy <= last_row; ++dy)
+    {
+        const location_base_t y = cy + dy;
+        const auto [lower, upper] = columns(dy, radius - profile.outer, radius + profile.outer);
+        if (lower > upper)
+        {
+            continue;
+        }
+        if (!pen.antialiased)
+        {
+            emit(y, lower, upper, 1.F);
+            continue;
+        }
 
-            if (err > 0)
+        auto [full_lower, full_upper] = columns(dy, radius - profile.full, radius + profile.full);
+        if (profile.full < 0.0 || full_lower > full_upper)
+        {
+            full_lower = upper + 1;
+            full_upper = upper;
+        }
+        for (location_base_t dx = lower; dx <= upper; ++dx)
+        {
+            if (dx == full_lower)
+            {
+                emit(y, full_lower, full_upper, 1.F);
+                dx = full_upper;
+                continue;
+            }
+            const double distance = std::sqrt(static_cast<double>(dx) * dx + static_cast<double>(dy) * dy);
+            const float coverage = profile.coverage(std::abs(distance - radius));
+            if (coverage > 0.F)
             {
-                cur[0] -= 1;
-                err -= 2 * cur[0] + 1;
+                emit(y, dx, dx, coverage);
             }
         }
+    }
+}
+
+// Calls func(y, first, last, 1.F) for the runs of the midpoint circle, each pixel once, clipped to clip.
+template <class Func>
+void circle_outline_runs(
+    const circle_t<location_base_t>& shape, const rectangle_t<location_base_t>& clip, Func&& func)
+{
+    if (shape.radius < 0)
+    {
+        return;
+    }
+
+    // by the distance of a row from the center, the columns of the two octants that meet there, both ends included
+    const auto size = static_cast<std::size_t>(shape.radius) + 1;
+    const interval_type none{ std::numeric_limits<location_base_t>::max(), std::numeric_limits<location_base_t>::min() };
+    std::vector<std::array<interval_type, 2>> columns(size, { none, none });
+    const auto include = [](interval_type& range, location_base_t value)
+    {
+        range[0] = std::min(range[0], value);
+        range[1] = std::max(range[1], value);
+    };
+    midpoint_octant(
+        shape.radius,
+        [&](location_base_t a, location_base_t b)
+        {
+            include(columns[static_cast<std::size_t>(b)][0], a);
+            include(columns[static_cast<std::size_t>(a)][1], b);
+        });
+
+    const location_base_t cy = shape.center[0];
+    const location_base_t cx = shape.center[1];
+    for (location_base_t dy = std::max(-shape.radius, clip[0][0] - cy); dy <= std::min(shape.radius, clip[0][1] - 1 - cy);
+         ++dy)
+    {
+        auto [near, far] = columns[static_cast<std::size_t>(std::abs(dy))];
+        if (near[0] > far[0])
+        {
+            std::swap(near, far);
+        }
+        if (far[0] <= near[1] + 1)
+        {
+            near[1] = std::max(near[1], far[1]);
+            far = none;
+        }
+        for (const auto& range : { near, far })
+        {
+            if (range[0] > range[1])
+            {
+                continue;
+            }
+            if (range[0] == 0)
+            {
+                func(cy + dy, cx - range[1], cx + range[1] + 1, 1.F);
+                continue;
+            }
+            func(cy + dy, cx - range[1], cx - range[0] + 1, 1.F);
+            func(cy + dy, cx + range[0], cx + range[1] + 1, 1.F);
+        }
+    }
+}
+
+// Calls func(y, first, last, 1.F) for the border of rect widened to round(width) pixels, clipped to clip.
+template <class Func>
+void rectangle_outline_runs(
+    const rectangle_t<location_base_t>& rect,
+    const stroke_t& pen,
+    const rectangle_t<location_base_t>& clip,
+    Func&& func)
+{
+    if (rect[0][0] >= rect[0][1] || rect[1][0] >= rect[1][1])
+    {
+        return;
+    }
+    const auto width = std::max(static_cast<location_base_t>(std::lround(pen.width)), location_base_t{ 1 });
+    const location_base_t grow = (width - 1) / 2;
+    rectangle_t<location_base_t> outer = rect;
+    rectangle_t<location_base_t> inner = rect;
+    for (std::size_t d = 0; d < 2; ++d)
+    {
+        outer[d] = interval_type{ rect[d][0] - grow, rect[d][1] + grow };
+        inner[d] = interval_type{ outer[d][0] + width, outer[d][1] - width };
+    }
+
+    const bool hollow = inner[1][0] < inner[1][1];
+    for (location_base_t y = std::max(outer[0][0], clip[0][0]); y < std::min(outer[0][1], clip[0][1]); ++y)
+    {
+        if (hollow && y >= inner[0][0] && y < inner[0][1])
+        {
+            func(y, outer[1][0], inner[1][0], 1.F);
+            func(y, inner[1][1], outer[1][1], 1.F);
+        }
+        else
+        {
+            func(y, outer[1][0], outer[1][1], 1.F);
+        }
+    }
+}
+
+struct rasterize_fn
+{
+    raster_t operator()(const rectangle_t<location_base_t>& shape) const
+    {
+        raster_t::shape_t raster_shape;
+
+        for (location_base_t y = shape[0].get(side_t::lower); y < shape[0].get(side_t::upper); ++y)
+        {
+            raster_shape.emplace(
+                y, std::vector<interval_type>{ { shape[1].get(side_t::lower), shape[1].get(side_t::upper) } });
+        }
+
+        return raster_t{ { raster_shape } };
+    }
+
+    raster_t operator()(const circle_t<location_base_t>& shape) const
+    {
+        raster_t::shape_t raster_shape;
+        circle_spans(shape, [&](location_base_t y, const interval_type& span) { raster_shape[y].push_back(span); });
+        return raster_t{ { raster_shape } };
+    }
+
+    raster_t operator()(const polygon_t<2, location_base_t>& shape) const
+    {
+        raster_t::shape_t raster_shape;
+        polygon_spans(shape, [&](location_base_t y, const std::vector<interval_type>& spans) { raster_shape[y] = spans; });
         return raster_t{ { raster_shape } };
     }
 
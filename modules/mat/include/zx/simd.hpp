@@ -0,0 +1,1150 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ZX_MAT_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define ZX_MAT_SIMD_X86 0
+#endif
+
+namespace zx
+{
+namespace mat
+{
+
+enum class simd_isa_t
+{
+    scalar,
+    sse2,
+    avx2,
+};
+
+inline std::ostream& operator<<(std::ostream& os, simd_isa_t item)
+{
+    switch (item)
+    {
+        case simd_isa_t::scalar: return os << "scalar";
+        case simd_isa_t::sse2: return os << "sse2";
+        case simd_isa_t::avx2: return os << "avx2";
+    }
+    return os;
+}
+
+namespace detail
+{
+
+namespace simd
+{
+
+// Kernels operating on contiguous runs of n > 0 elements.
+struct kernels_t
+{
+    simd_isa_t isa;
+    double (*sum_f32)(const float*, std::size_t);
+    std::uint64_t (*sum_u8)(const std::uint8_t*, std::size_t);
+    std::pair<float, float> (*minmax_f32)(const float*, std::size_t);
+    std::pair<std::uint8_t, std::uint8_t> (*minmax_u8)(const std::uint8_t*, std::size_t);
+    double (*dot_f32)(const float*, const float*, std::size_t);
+    void (*histogram_u8)(const std::uint8_t*, std::size_t, std::uint64_t*);
+    // n packed 3-byte pixels with the first and last byte exchanged; src may equal dst
+    void (*swap_rb_u8)(const std::uint8_t*, std::uint8_t*, std::size_t);
+    // blend modes dst = f(dst, src), truncated like the float color filters
+    void (*multiply_u8)(std::uint8_t*, const std::uint8_t*, std::size_t);
+    void (*screen_u8)(std::uint8_t*, const std::uint8_t*, std::size_t);
+    void (*overlay_u8)(std::uint8_t*, const std::uint8_t*, std::size_t);
+    void (*lerp_u8)(std::uint8_t*, const std::uint8_t*, std::size_t, float);
+    // clamped to [0, 255] and truncated
+    void (*narrow_f32_u8)(const float*, std::uint8_t*, std::size_t);
+    void (*widen_u8_f32)(const std::uint8_t*, float*, std::size_t);
+    // acc[i] += coefficient * src[i]
+    void (*accumulate_u8)(std::int32_t*, const std::uint8_t*, std::size_t, std::int16_t);
+    // dst[i * dst_stride + j] = src[j * src_stride + i] for an 8 x 8 block; strides may be negative
+    void (*transpose_8x8_u8)(const std::uint8_t*, std::ptrdiff_t, std::uint8_t*, std::ptrdiff_t);
+    // dst[i] = above[i] + src[0] + ... + src[i], modulo 2^32; above may equal dst
+    void (*integral_u8)(const std::uint8_t*, const std::uint32_t*, std::uint32_t*, std::size_t);
+    // n packed rgb pixels mapped in place by a 3 x 4 matrix given by rows: m[i][0], m[i][1], m[i][2], offset[i];
+    // each channel sums its terms from left to right, so all kernels round alike
+    void (*color_matrix_f32)(float*, std::size_t, const float*);
+    // as above, on bytes widened to floats and narrowed back like narrow_f32_u8
+    void (*color_matrix_u8)(std::uint8_t*, std::size_t, const float*);
+};
+
+namespace scalar
+{
+
+inline double sum_f32(const float* data, std::size_t n)
+{
+    double result = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<double>(data[i]);
+    }
+    return result;
+}
+
+inline std::uint64_t sum_u8(const std::uint8_t* data, std::size_t n)
+{
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        result += data[i];
+    }
+    return result;
+}
+
+template <class T>
+std::pair<T, T> minmax(const T* data, std::size_t n)
+{
+    T lo = data[0];
+    T up = data[0];
+    for (std::size_t i = 1; i < n; ++i)
+    {
+        lo = data[i] < lo ? data[i] : lo;
+        up = up < data[i] ? data[i] : up;
+    }
+    return { lo, up };
+}
+
+inline std::pair<float, float> minmax_f32(const float* data, std::size_t n)
+{
+    return minmax(data, n);
+}
+
+inline std::pair<std::uint8_t, std::uint8_t> minmax_u8(const std::uint8_t* data, std::size_t n)
+{
+    return minmax(data, n);
+}
+
+inline double dot_f32(const float* lhs, const float* rhs, std::size_t n)
+{
+    double result = 0.0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        result += static_cast<double>(lhs[i] * rhs[i]);
+    }
+    return result;
+}
+
+// four interleaved sub-histograms break the store-to-load dependency on runs of equal bytes
+inline void histogram_u8(const std::uint8_t* data, std::size_t n, std::uint64_t* bins)
+{
+    if (n < 1024)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ++bins[data[i]];
+        }
+        return;
+    }
+
+    std::array<std::array<std::uint32_t, 256>, 4> banks = {};
+    std::size_t i = 0;
+    while (i < n)
+    {
+        const std::size_t last = i + std::min<std::size_t>(n - i, std::size_t{ 1 } << 30);
+        for (; i + 4 <= last; i += 4)
+        {
+            ++banks[0][data[i + 0]];
+            ++banks[1][data[i + 1]];
+            ++banks[2][data[i + 2]];
+            ++banks[3][data[i + 3]];
+        }
+        for (; i < last; ++i)
+        {
+            ++banks[0][data[i]];
+        }
+        for (std::size_t b = 0; b < 256; ++b)
+        {
+            bins[b] += std::uint64_t{ banks[0][b] } + banks[1][b] + banks[2][b] + banks[3][b];
+        }
+        banks = {};
+    }
+}
+
+inline void swap_rb_u8(const std::uint8_t* src, std::uint8_t* dst, std::size_t n)
+{
+    for (std::size_t i = 0; i < 3 * n; i += 3)
+    {
+        const std::uint8_t first = src[i];
+        dst[i + 1] = src[i + 1];
+        dst[i] = src[i + 2];
+        dst[i + 2] = first;
+    }
+}
+
+// floor(value / 255) for value < 65535
+inline unsigned div255(unsigned value)
+{
+    return (value + 1 + (value >> 8)) >> 8;
+}
+
+inline void multiply_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(div255(unsigned{ dst[i] } * src[i]));
+    }
+}
+
+inline void screen_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(255 - div255((255U - dst[i]) * (255U - src[i]) + 254));
+    }
+}
+
+inline void overlay_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(
+            dst[i] < 128 ? div255(2U * dst[i] * src[i]) : 255 - div255(2U * (255U - dst[i]) * (255U - src[i]) + 254));
+    }
+}
+
+inline void lerp_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n, float alpha)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const float value = static_cast<float>(dst[i]) * (1.F - alpha) + static_cast<float>(src[i]) * alpha;
+        dst[i] = static_cast<std::uint8_t>(std::clamp(value, 0.F, 255.F));
+    }
+}
+
+// NaN narrows to 0, as it does in the simd kernels
+inline void narrow_f32_u8(const float* src, std::uint8_t* dst, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(std::min(src[i] > 0.F ? src[i] : 0.F, 255.F));
+    }
+}
+
+inline void widen_u8_f32(const std::uint8_t* src, float* dst, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        dst[i] = static_cast<float>(src[i]);
+    }
+}
+
+inline void accumulate_u8(std::int32_t* acc, const std::uint8_t* src, std::size_t n, std::int16_t coefficient)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        acc[i] += std::int32_t{ coefficient } * std::int32_t{ src[i] };
+    }
+}
+
+inline void transpose_8x8_u8(
+    const std::uint8_t* src, std::ptrdiff_t src_stride, std::uint8_t* dst, std::ptrdiff_t dst_stride)
+{
+    for (std::ptrdiff_t i = 0; i < 8; ++i)
+    {
+        for (std::ptrdiff_t j = 0; j < 8; ++j)
+        {
+            dst[i * dst_stride + j] = src[j * src_stride + i];
+        }
+    }
+}
+
+inline void integral_u8(const std::uint8_t* src, const std::uint32_t* above, std::uint32_t* dst, std::size_t n)
+{
+    std::uint32_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        sum += src[i];
+        dst[i] = above[i] + sum;
+    }
+}
+
+// coefficients are copied so that stores to values do not force reloading them
+inline void color_matrix_f32(float* values, std::size_t n, const float* matrix)
+{
+    std::array<float, 12> m;
+    std::copy(matrix, matrix + 12, m.begin());
+    for (std::size_t i = 0; i < 3 * n; i += 3)
+    {
+        const float r = values[i];
+        const float g = values[i + 1];
+        const float b = values[i + 2];
+        values[i] = m[0] * r + m[1] * g + m[2] * b + m[3];
+        values[i + 1] = m[4] * r + m[5] * g + m[6] * b + m[7];
+        values[i + 2] = m[8] * r + m[9] * g + m[10] * b + m[11];
+    }
+}
+
+// widened into a buffer of 64 pixels at a time
+inline void color_matrix_u8(std::uint8_t* pixels, std::size_t n, const float* matrix)
+{
+    constexpr std::size_t chunk = 64;
+    std::array<float, 3 * chunk> values;
+    for (std::size_t i = 0; i < n; i += chunk)
+    {
+        const std::size_t count = std::min(n - i, chunk);
+        widen_u8_f32(pixels + 3 * i, values.data(), 3 * count);
+        color_matrix_f32(values.data(), count, matrix);
+        narrow_f32_u8(values.data(), pixels + 3 * i, 3 * count);
+    }
+}
+
+inline const kernels_t& kernels()
+{
+    static const kernels_t result = { simd_isa_t::scalar,
+                                      sum_f32,
+                                      sum_u8,
+                                      minmax_f32,
+                                      minmax_u8,
+                                      dot_f32,
+                                      histogram_u8,
+                                      swap_rb_u8,
+                                      multiply_u8,
+                                      screen_u8,
+                                      overlay_u8,
+                                      lerp_u8,
+                                      narrow_f32_u8,
+                                      widen_u8_f32,
+                                      accumulate_u8,
+                                      transpose_8x8_u8,
+                                      integral_u8,
+                                      color_matrix_f32,
+                                      color_matrix_u8 };
+    return result;
+}
+
+}  // namespace scalar
+
+#if ZX_MAT_SIMD_X86
+
+namespace sse2
+{
+
+__attribute__((target("sse2"))) inline double hsum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+__attribute__((target("sse2"))) inline __m128d widen_add(__m128d acc, __m128 v)
+{
+    return _mm_add_pd(_mm_add_pd(acc, _mm_cvtps_pd(v)), _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+}
+
+__attribute__((target("sse2"))) inline double sum_f32(const float* data, std::size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = widen_add(acc0, _mm_loadu_ps(data + i));
+        acc1 = widen_add(acc1, _mm_loadu_ps(data + i + 4));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + scalar::sum_f32(data + i, n - i);
+}
+
+__attribute__((target("sse2"))) inline std::uint64_t sum_u8(const std::uint8_t* data, std::size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    std::array<std::uint64_t, 2> lanes;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes.data()), acc);
+    return lanes[0] + lanes[1] + scalar::sum_u8(data + i, n - i);
+}
+
+__attribute__((target("sse2"))) inline std::pair<float, float> minmax_f32(const float* data, std::size_t n)
+{
+    if (n < 4)
+    {
+        return scalar::minmax_f32(data, n);
+    }
+    __m128 lo = _mm_set1_ps(data[0]);
+    __m128 up = lo;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128 v = _mm_loadu_ps(data + i);
+        // NaN in v keeps the accumulator, matching the scalar comparisons
+        lo = _mm_min_ps(v, lo);
+        up = _mm_max_ps(v, up);
+    }
+    std::array<float, 4> l;
+    std::array<float, 4> u;
+    _mm_storeu_ps(l.data(), lo);
+    _mm_storeu_ps(u.data(), up);
+    std::pair<float, float> result = { scalar::minmax(l.data(), 4).first, scalar::minmax(u.data(), 4).second };
+    if (i < n)
+    {
+        const auto tail = scalar::minmax_f32(data + i, n - i);
+        result = { tail.first < result.first ? tail.first : result.first,
+                   result.second < tail.second ? tail.second : result.second };
+    }
+    return result;
+}
+
+__attribute__((target("sse2"))) inline std::pair<std::uint8_t, std::uint8_t> minmax_u8(
+    const std::uint8_t* data, std::size_t n)
+{
+    if (n < 16)
+    {
+        return scalar::minmax_u8(data, n);
+    }
+    __m128i lo = _mm_set1_epi8(static_cast<char>(data[0]));
+    __m128i up = lo;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        lo = _mm_min_epu8(lo, v);
+        up = _mm_max_epu8(up, v);
+    }
+    std::array<std::uint8_t, 16> l;
+    std::array<std::uint8_t, 16> u;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(l.data()), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(u.data()), up);
+    std::uint8_t rlo = *std::min_element(l.begin(), l.end());
+    std::uint8_t rup = *std::max_element(u.begin(), u.end());
+    for (; i < n; ++i)
+    {
+        rlo = std::min(rlo, data[i]);
+        rup = std::max(rup, data[i]);
+    }
+    return { rlo, rup };
+}
+
+__attribute__((target("sse2"))) inline double dot_f32(const float* lhs, const float* rhs, std::size_t n)
+{
+    __m128d acc0 = _mm_setzero_pd();
+    __m128d acc1 = _mm_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        acc0 = widen_add(acc0, _mm_mul_ps(_mm_loadu_ps(lhs + i), _mm_loadu_ps(rhs + i)));
+        acc1 = widen_add(acc1, _mm_mul_ps(_mm_loadu_ps(lhs + i + 4), _mm_loadu_ps(rhs + i + 4)));
+    }
+    return hsum(_mm_add_pd(acc0, acc1)) + scalar::dot_f32(lhs + i, rhs + i, n - i);
+}
+
+__attribute__((target("sse2"))) inline __m128i div255(__m128i value)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(value, one), _mm_srli_epi16(value, 8)), 8);
+}
+
+__attribute__((target("sse2"))) inline __m128i multiply(__m128i d, __m128i s)
+{
+    return div255(_mm_mullo_epi16(d, s));
+}
+
+__attribute__((target("sse2"))) inline __m128i screen(__m128i d, __m128i s)
+{
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i product = _mm_mullo_epi16(_mm_sub_epi16(max, d), _mm_sub_epi16(max, s));
+    return _mm_sub_epi16(max, div255(_mm_add_epi16(product, _mm_set1_epi16(254))));
+}
+
+__attribute__((target("sse2"))) inline __m128i overlay(__m128i d, __m128i s)
+{
+    const __m128i max = _mm_set1_epi16(255);
+    const __m128i dark = div255(_mm_slli_epi16(_mm_mullo_epi16(d, s), 1));
+    const __m128i product = _mm_slli_epi16(_mm_mullo_epi16(_mm_sub_epi16(max, d), _mm_sub_epi16(max, s)), 1);
+    const __m128i light = _mm_sub_epi16(max, div255(_mm_add_epi16(product, _mm_set1_epi16(254))));
+    const __m128i is_dark = _mm_cmplt_epi16(d, _mm_set1_epi16(128));
+    return _mm_or_si128(_mm_and_si128(is_dark, dark), _mm_andnot_si128(is_dark, light));
+}
+
+// Op works on 16-bit lanes; sixteen bytes per step, the tail goes to the scalar kernel.
+template <__m128i (*Op)(__m128i, __m128i), void (*Tail)(std::uint8_t*, const std::uint8_t*, std::size_t)>
+__attribute__((target("sse2"))) inline void blend_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = Op(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+        const __m128i hi = Op(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    Tail(dst + i, src + i, n - i);
+}
+
+__attribute__((target("sse2"))) inline __m128i lerp(__m128i d, __m128i s, __m128 keep, __m128 alpha)
+{
+    const __m128 value = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(d), keep), _mm_mul_ps(_mm_cvtepi32_ps(s), alpha));
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(255.F)));
+}
+
+__attribute__((target("sse2"))) inline void lerp_u8(std::uint8_t* dst, const std::uint8_t* src, std::size_t n, float alpha)
+{
+    const __m128 keep = _mm_set1_ps(1.F - alpha);
+    const __m128 weight = _mm_set1_ps(alpha);
+    const __m128i zero = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(dst + i)), zero);
+        const __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)), zero);
+        const __m128i lo = lerp(_mm_unpacklo_epi16(d, zero), _mm_unpacklo_epi16(s, zero), keep, weight);
+        const __m128i hi = lerp(_mm_unpackhi_epi16(d, zero), _mm_unpackhi_epi16(s, zero), keep, weight);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(_mm_packs_epi32(lo, hi), zero));
+    }
+    scalar::lerp_u8(dst + i, src + i, n - i, alpha);
+}
+
+// max returns its second operand when either is NaN, so NaN lanes become 0 before the min
+__attribute__((target("sse2"))) inline __m128i narrow(__m128 v)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 max = _mm_set1_ps(255.F);
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, zero), max));
+}
+
+__attribute__((target("sse2"))) inline __m128i narrow(const float* src)
+{
+    return narrow(_mm_loadu_ps(src));
+}
+
+// sixteen narrowed lanes packed into bytes
+__attribute__((target("sse2"))) inline __m128i narrow(const __m128* v)
+{
+    return _mm_packus_epi16(_mm_packs_epi32(narrow(v[0]), narrow(v[1])), _mm_packs_epi32(narrow(v[2]), narrow(v[3])));
+}
+
+__attribute__((target("sse2"))) inline void narrow_f32_u8(const float* src, std::uint8_t* dst, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i lo = _mm_packs_epi32(narrow(src + i), narrow(src + i + 4));
+        const __m128i hi = _mm_packs_epi32(narrow(src + i + 8), narrow(src + i + 12));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    scalar::narrow_f32_u8(src + i, dst + i, n - i);
+}
+
+// sixteen bytes into four vectors of floats
+__attribute__((target("sse2"))) inline void widen(__m128i v, __m128* out)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_unpacklo_epi8(v, zero);
+    const __m128i hi = _mm_unpackhi_epi8(v, zero);
+    out[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+    out[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+    out[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+    out[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+}
+
+__attribute__((target("sse2"))) inline void widen_u8_f32(const std::uint8_t* src, float* dst, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128 v[4];
+        widen(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), v);
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            _mm_storeu_ps(dst + i + 4 * j, v[j]);
+        }
+    }
+    scalar::widen_u8_f32(src + i, dst + i, n - i);
+}
+
+// bytes widened to 32-bit lanes are multiplied as 16-bit pairs (value, 0) with (coefficient, 0)
+__attribute__((target("sse2"))) inline void accumulate_u8(
+    std::int32_t* acc, const std::uint8_t* src, std::size_t n, std::int16_t coefficient)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c = _mm_set1_epi32(static_cast<std::uint16_t>(coefficient));
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i parts[] = { _mm_unpacklo_epi16(lo, zero),
+                                  _mm_unpackhi_epi16(lo, zero),
+                                  _mm_unpacklo_epi16(hi, zero),
+                                  _mm_unpackhi_epi16(hi, zero) };
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i + 4 * j);
+            _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_madd_epi16(parts[j], c)));
+        }
+    }
+    scalar::accumulate_u8(acc + i, src + i, n - i, coefficient);
+}
+
+// interleaves rows in pairs, then pairs of pairs and quadruples, which leaves the columns in consecutive 8-byte halves
+__attribute__((target("sse2"))) inline void transpose_8x8_u8(
+    const std::uint8_t* src, std::ptrdiff_t src_stride, std::uint8_t* dst, std::ptrdiff_t dst_stride)
+{
+    __m128i rows[8];
+    for (std::ptrdiff_t j = 0; j < 8; ++j)
+    {
+        rows[j] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + j * src_stride));
+    }
+    const __m128i b0 = _mm_unpacklo_epi8(rows[0], rows[1]);
+    const __m128i b1 = _mm_unpacklo_epi8(rows[2], rows[3]);
+    const __m128i b2 = _mm_unpacklo_epi8(rows[4], rows[5]);
+    const __m128i b3 = _mm_unpacklo_epi8(rows[6], rows[7]);
+    const __m128i c0 = _mm_unpacklo_epi16(b0, b1);
+    const __m128i c1 = _mm_unpackhi_epi16(b0, b1);
+    const __m128i c2 = _mm_unpacklo_epi16(b2, b3);
+    const __m128i c3 = _mm_unpackhi_epi16(b2, b3);
+    const __m128i columns[] = { _mm_unpacklo_epi32(c0, c2),
+                                _mm_unpackhi_epi32(c0, c2),
+                                _mm_unpacklo_epi32(c1, c3),
+                                _mm_unpackhi_epi32(c1, c3) };
+    for (std::ptrdiff_t i = 0; i < 4; ++i)
+    {
+        const __m128i v = columns[i];
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 2 * i * dst_stride), v);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + (2 * i + 1) * dst_stride), _mm_unpackhi_epi64(v, v));
+    }
+}
+
+// prefix sums of four 32-bit lanes in two shifted adds, offset by the total carried over from the previous lanes
+__attribute__((target("sse2"))) inline void integral_u8(
+    const std::uint8_t* src, const std::uint32_t* above, std::uint32_t* dst, std::size_t n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i carry = zero;
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        const __m128i parts[] = { _mm_unpacklo_epi16(lo, zero),
+                                  _mm_unpackhi_epi16(lo, zero),
+                                  _mm_unpacklo_epi16(hi, zero),
+                                  _mm_unpackhi_epi16(hi, zero) };
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            __m128i x = parts[j];
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+            x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+            x = _mm_add_epi32(x, carry);
+            carry = _mm_shuffle_epi32(x, 0xFF);
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + i + 4 * j));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4 * j), _mm_add_epi32(x, b));
+        }
+    }
+    if (i < n)
+    {
+        std::uint32_t sum = static_cast<std::uint32_t>(_mm_cvtsi128_si32(carry));
+        for (; i < n; ++i)
+        {
+            sum += src[i];
+            dst[i] = above[i] + sum;
+        }
+    }
+}
+
+// four packed pixels in three vectors, split into vectors of r, g and b, mapped by the broadcast coefficients m
+// and interleaved back
+__attribute__((target("sse2"))) inline void color_matrix(const __m128* m, __m128* v)
+{
+    // r0 g0 b0 r1 | g1 b1 r2 g2 | b2 r3 g3 b3
+    const __m128 r = _mm_shuffle_ps(v[0], _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    const __m128 g = _mm_shuffle_ps(
+        _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(0, 0, 1, 1)),
+        _mm_shuffle_ps(v[1], v[2], _MM_SHUFFLE(2, 2, 3, 3)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 b = _mm_shuffle_ps(
+        _mm_shuffle_ps(v[0], v[1], _MM_SHUFFLE(1, 1, 2, 2)),
+        _mm_shuffle_ps(v[2], v[2], _MM_SHUFFLE(3, 3, 0, 0)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 out[3];
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        const __m128 sum = _mm_add_ps(_mm_mul_ps(m[4 * i], r), _mm_mul_ps(m[4 * i + 1], g));
+        out[i] = _mm_add_ps(_mm_add_ps(sum, _mm_mul_ps(m[4 * i + 2], b)), m[4 * i + 3]);
+    }
+    v[0] = _mm_shuffle_ps(
+        _mm_shuffle_ps(out[0], out[1], _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm_shuffle_ps(out[2], out[0], _MM_SHUFFLE(1, 1, 0, 0)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    v[1] = _mm_shuffle_ps(
+        _mm_shuffle_ps(out[1], out[2], _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm_shuffle_ps(out[0], out[1], _MM_SHUFFLE(2, 2, 2, 2)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    v[2] = _mm_shuffle_ps(
+        _mm_shuffle_ps(out[2], out[0], _MM_SHUFFLE(3, 3, 2, 2)),
+        _mm_shuffle_ps(out[1], out[2], _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+__attribute__((target("sse2"))) inline void color_matrix_f32(float* values, std::size_t n, const float* matrix)
+{
+    __m128 m[12];
+    for (std::size_t j = 0; j < 12; ++j)
+    {
+        m[j] = _mm_set1_ps(matrix[j]);
+    }
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        float* p = values + 3 * i;
+        __m128 v[3] = { _mm_loadu_ps(p), _mm_loadu_ps(p + 4), _mm_loadu_ps(p + 8) };
+        color_matrix(m, v);
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            _mm_storeu_ps(p + 4 * j, v[j]);
+        }
+    }
+    scalar::color_matrix_f32(values + 3 * i, n - i, matrix);
+}
+
+// sixteen pixels per step, widened into four groups of three vectors without leaving the registers
+__attribute__((target("sse2"))) inline void color_matrix_u8(std::uint8_t* pixels, std::size_t n, const float* matrix)
+{
+    __m128 m[12];
+    for (std::size_t j = 0; j < 12; ++j)
+    {
+        m[j] = _mm_set1_ps(matrix[j]);
+    }
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + 3 * i);
+        __m128 v[12];
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            widen(_mm_loadu_si128(p + j), v + 4 * j);
+        }
+        for (std::size_t j = 0; j < 4; ++j)
+        {
+            color_matrix(m, v + 3 * j);
+        }
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            _mm_storeu_si128(p + j, narrow(v + 4 * j));
+        }
+    }
+    scalar::color_matrix_u8(pixels + 3 * i, n - i, matrix);
+}
+
+inline const kernels_t& kernels()
+{
+    static const kernels_t result = { simd_isa_t::sse2,
+                                      sum_f32,
+                                      sum_u8,
+                                      minmax_f32,
+                                      minmax_u8,
+                                      dot_f32,
+                                      scalar::histogram_u8,
+                                      scalar::swap_rb_u8,
+                                      blend_u8<multiply, scalar::multiply_u8>,
+                                      blend_u8<screen, scalar::screen_u8>,
+                                      blend_u8<overlay, scalar::overlay_u8>,
+                                      lerp_u8,
+                                      narrow_f32_u8,
+                                      widen_u8_f32,
+                                      accumulate_u8,
+                                      transpose_8x8_u8,
+                                      integral_u8,
+                                      color_matrix_f32,
+                                      color_matrix_u8 };
+    return result;
+}
+
+}  // namespace sse2
+
+namespace avx2
+{
+
+__attribute__((target("avx2"))) inline double hsum(__m256d v)
+{
+    const __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2"))) inline __m256d widen_add(__m256d acc, __m256 v)
+{
+    return _mm256_add_pd(
+        _mm256_add_pd(acc, _mm256_cvtps_pd(_mm256_castps256_ps128(v))), _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+}
+
+__attribute__((target("avx2"))) inline double sum_f32(const float* data, std::size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = widen_add(acc0, _mm256_loadu_ps(data + i));
+        acc1 = widen_add(acc1, _mm256_loadu_ps(data + i + 8));
+    }
+    return hsum(_mm256_add_pd(acc0, acc1)) + sse2::sum_f32(data + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline std::uint64_t sum_u8(const std::uint8_t* data, std::size_t n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+    }
+    std::array<std::uint64_t, 4> lanes;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes.data()), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sse2::sum_u8(data + i, n - i);
+}
+
+__attribute__((target("avx2"))) inline std::pair<float, float> minmax_f32(const float* data, std::size_t n)
+{
+    if (n < 8)
+    {
+        return sse2::minmax_f32(data, n);
+    }
+    __m256 lo = _mm256_set1_ps(data[0]);
+    __m256 up = lo;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256 v = _mm256_loadu_ps(data + i);
+        lo = _mm256_min_ps(v, lo);
+        up = _mm256_max_ps(v, up);
+    }
+    std::array<float, 8> l;
+    std::array<float, 8> u;
+    _mm256_storeu_ps(l.data(), lo);
+    _mm256_storeu_ps(u.data(), up);
+    std::pair<float, float> result = { scalar::minmax(l.data(), 8).first, scalar::minmax(u.data(), 8).second };
+    if (i < n)
+    {
+        const auto tail = scalar::minmax_f32(data + i, n - i);
+        result = { tail.first < result.first ? tail.first : result.first,
+                   result.second < tail.second ? tail.second : result.second };
+    }
+    return result;
+}
+
+__attribute__((target("avx2"))) inline std::pair<std::uint8_t, std::uint8_t> minmax_u8(
+    const std::uint8_t* data, std::size_t n)
+{
+    if (n < 32)
+    {
+        return sse2::minmax_u8(data, n);
+    }
+    __m256i lo = _mm256_set1_epi8(static_cast<char>(data[0]));
+    __m256i up = lo;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        lo = _mm256_min_epu8(lo, v);
+        up = _mm256_max_epu8(up, v);
+    }
+    std::array<std::uint8_t, 32> l;
+    std::array<std::uint8_t, 32> u;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(l.data()), lo);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(u.data()), up);
+    std::uint8_t rlo = *std::min_element(l.begin(), l.end());
+    std::uint8_t rup = *std::max_element(u.begin(), u.end());
+    for (; i < n; ++i)
+    {
+        rlo = std::min(rlo, data[i]);
+        rup = std::max(rup, data[i]);
+    }
+    return { rlo, rup };
+}
+
+__attribute__((target("avx2"))) inline double dot_f32(const float* lhs, const float* rhs, std::size_t n)
+{
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        acc0 = widen_add(acc0, _mm256_mul_ps(_mm256_loadu_ps(lhs + i), _mm256_loadu_ps(rhs + i)));
+        acc1 = widen_add(acc1, _mm256_mul_ps(_mm256_loadu_ps(lhs + i + 8), _mm256_loadu_ps(rhs + i + 8)));
+    }
+    return hsum(_mm256_add_pd(acc0, acc1)) + sse2::dot_f32(lhs + i, rhs + i, n - i);
+}
+
+// five pixels per 16-byte block; the last byte of a block is rewritten by the next one
+__attribute__((target("avx2"))) inline void swap_rb_u8(const std::uint8_t* src, std::uint8_t* dst, std::size_t n)
+{
+    const __m128i order = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+    std::size_t i = 0;
+    for (; i + 6 <= n; i += 5)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i), _mm_shuffle_epi8(v, order));
+    }
+    scalar::swap_rb_u8(src + 3 * i, dst + 3 * i, n - i);
+}
+
+// the sse2 color matrix on both 128-bit halves, each holding four pixels
+__attribute__((target("avx2"))) inline void color_matrix(const __m256* m, __m256* v)
+{
+    const __m256 r = _mm256_shuffle_ps(
+        v[0], _mm256_shuffle_ps(v[1], v[2], _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+    const __m256 g = _mm256_shuffle_ps(
+        _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(0, 0, 1, 1)),
+        _mm256_shuffle_ps(v[1], v[2], _MM_SHUFFLE(2, 2, 3, 3)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 b = _mm256_shuffle_ps(
+        _mm256_shuffle_ps(v[0], v[1], _MM_SHUFFLE(1, 1, 2, 2)),
+        _mm256_shuffle_ps(v[2], v[2], _MM_SHUFFLE(3, 3, 0, 0)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    __m256 out[3];
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        const __m256 sum = _mm256_add_ps(_mm256_mul_ps(m[4 * i], r), _mm256_mul_ps(m[4 * i + 1], g));
+        out[i] = _mm256_add_ps(_mm256_add_ps(sum, _mm256_mul_ps(m[4 * i + 2], b)), m[4 * i + 3]);
+    }
+    v[0] = _mm256_shuffle_ps(
+        _mm256_shuffle_ps(out[0], out[1], _MM_SHUFFLE(0, 0, 0, 0)),
+        _mm256_shuffle_ps(out[2], out[0], _MM_SHUFFLE(1, 1, 0, 0)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    v[1] = _mm256_shuffle_ps(
+        _mm256_shuffle_ps(out[1], out[2], _MM_SHUFFLE(1, 1, 1, 1)),
+        _mm256_shuffle_ps(out[0], out[1], _MM_SHUFFLE(2, 2, 2, 2)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+    v[2] = _mm256_shuffle_ps(
+        _mm256_shuffle_ps(out[2], out[0], _MM_SHUFFLE(3, 3, 2, 2)),
+        _mm256_shuffle_ps(out[1], out[2], _MM_SHUFFLE(3, 3, 3, 3)),
+        _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// eight pixels, 24 bytes, per step; vector j holds bytes 4j to 4j + 3 in its low half and 4j + 12 to 4j + 15 in
+// its high half, so both halves are laid out as in the sse2 kernel
+__attribute__((target("avx2"))) inline void color_matrix_u8(std::uint8_t* pixels, std::size_t n, const float* matrix)
+{
+    __m256 m[12];
+    for (std::size_t j = 0; j < 12; ++j)
+    {
+        m[j] = _mm256_set1_ps(matrix[j]);
+    }
+    const __m128i halves = _mm_setr_epi8(0, 1, 2, 3, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 max = _mm256_set1_ps(255.F);
+    const __m256i order = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        std::uint8_t* p = pixels + 3 * i;
+        __m256 v[3];
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            const __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4 * j)), halves);
+            v[j] = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bytes));
+        }
+        color_matrix(m, v);
+        // max returns its second operand when either is NaN, so NaN lanes become 0 before the min
+        __m256i w[3];
+        for (std::size_t j = 0; j < 3; ++j)
+        {
+            w[j] = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(v[j], zero), max));
+        }
+        // each half packs into bytes 4j.. of its 12 and a copy of the third vector; the copies are dropped
+        const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(w[0], w[1]), _mm256_packs_epi32(w[2], w[2]));
+        const __m256i result = _mm256_permutevar8x32_epi32(packed, order);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(result));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 16), _mm256_extracti128_si256(result, 1));
+    }
+    sse2::color_matrix_u8(pixels + 3 * i, n - i, matrix);
+}
+
+inline const kernels_t& kernels()
+{
+    static const kernels_t result = { simd_isa_t::avx2,
+                                      sum_f32,
+                                      sum_u8,
+                                      minmax_f32,
+                                      minmax_u8,
+                                      dot_f32,
+                                      scalar::histogram_u8,
+                                      swap_rb_u8,
+                                      sse2::blend_u8<sse2::multiply, scalar::multiply_u8>,
+                                      sse2::blend_u8<sse2::screen, scalar::screen_u8>,
+                                      sse2::blend_u8<sse2::overlay, scalar::overlay_u8>,
+                                      sse2::lerp_u8,
+                                      sse2::narrow_f32_u8,
+                                      sse2::widen_u8_f32,
+                                      sse2::accumulate_u8,
+                                      sse2::transpose_8x8_u8,
+                                      sse2::integral_u8,
+                                      sse2::color_matrix_f32,
+                                      color_matrix_u8 };
+    return result;
+}
+
+}  // namespace avx2
+
+#endif  // ZX_MAT_SIMD_X86
+
+inline bool is_supported(simd_isa_t isa)
+{
+#if ZX_MAT_SIMD_X86
+    __builtin_cpu_init();
+    switch (isa)
+    {
+        case simd_isa_t::scalar: return true;
+        case simd_isa_t::sse2: return __builtin_cpu_supports("sse2");
+        case simd_isa_t::avx2: return __builtin_cpu_supports("avx2");
+    }
+    return false;
+#else
+    return isa == simd_isa_t::scalar;
+#endif
+}
+
+inline const kernels_t& kernels(simd_isa_t isa)
+{
+#if ZX_MAT_SIMD_X86
+    switch (isa)
+    {
+        case simd_isa_t::avx2: return avx2::kernels();
+        case simd_isa_t::sse2: return sse2::kernels();
+        case simd_isa_t::scalar: break;
+    }
+#else
+    (void)isa;
+#endif
+    return scalar::kernels();
+}
+
+inline simd_isa_t detect_isa()
+{
+    for (const simd_isa_t isa : { simd_isa_t::avx2, simd_isa_t::sse2 })
+    {
+        if (is_supported(isa))
+        {
+            return isa;
+        }
+    }
+    return simd_isa_t::scalar;
+}
+
+inline const kernels_t& kernels()
+{
+    static const kernels_t& result = kernels(detect_isa());
+    return result;
+}
+
+template <class T>
+static constexpr bool is_accelerated_v = std::is_same_v<T, float> || std::is_same_v<T, std::uint8_t>;
+
+inline double sum(const float* data, std::size_t n)
+{
+    return kernels().sum_f32(data, n);
+}
+
+inline std::uint64_t sum(const std::uint8_t* data, std::size_t n)
+{
+    return kernels().sum_u8(data, n);
+}
+
+inline std::pair<float, float> minmax(const float* data, std::size_t n)
+{
+    return kernels().minmax_f32(data, n);
+}
+
+inline std::pair<std::uint8_t, std::uint8_t> minmax(const std::uint8_t* data, std::size_t n)
+{
+    return kernels().minmax_u8(data, n);
+}
+
+inline double dot(const float* lhs, const float* rhs, std::size_t n)
+{
+    return kernels().dot_f32(lhs, rhs, n);
+}
+
+inline void histogram(const std::uint8_t* data, std::size_t n, std::uint64_t* bins)
+{
+    kernels().histogram_u8(data, n, bins);
+}
+
+inline void swap_rb(const std::uint8_t* src, std::uint8_t* dst, std::size_t n)
+{
+    kernels().swap_rb_u8(src, dst, n);
+}
+
+inline void multiply(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    kernels().multiply_u8(dst, src, n);
+}
+
+inline void screen(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    kernels().screen_u8(dst, src, n);
+}
+
+inline void overlay(std::uint8_t* dst, const std::uint8_t* src, std::size_t n)
+{
+    kernels().overlay_u8(dst, src, n);
+}
+
+inline void lerp(std::uint8_t* dst, const std::uint8_t* src, std::size_t n, float alpha)
+{
+    kernels().lerp_u8(dst, src, n, alpha);
+}
+
+inline void narrow(const float* src, std::uint8_t* dst, std::size_t n)
+{
+    kernels().narrow_f32_u8(src, dst, n);
+}
+
+inline void widen(const std::uint8_t* src, float* dst, std::size_t n)
+{
+    kernels().widen_u8_f32(src, dst, n);
+}
+
+inline void accumulate(std::int32_t* acc, const std::uint8_t* src, std::size_t n, std::int16_t coefficient)
+{
+    kernels().accumulate_u8(acc, src, n, coefficient);
+}
+
+inline void transpose_8x8(const std::uint8_t* src, std::ptrdiff_t src_stride, std::uint8_t* dst, std::ptrdiff_t dst_stride)
+{
+    kernels().transpose_8x8_u8(src, src_stride, dst, dst_stride);
+}
+
+inline void integral(const std::uint8_t* src, const std::uint32_t* above, std::uint32_t* dst, std::size_t n)
+{
+    kernels().integral_u8(src, above, dst, n);
+}
+
+inline void color_matrix(float* values, std::size_t n, const float* matrix)
+{
+    kernels().color_matrix_f32(values, n, matrix);
+}
+
+inline void color_matrix(std::uint8_t* pixels, std::size_t n, const float* matrix)
+{
+    kernels().color_matrix_u8(pixels, n, matrix);
+}
+
+}  // namespace simd
+
+}  // namespace detail
+
+inline simd_isa_t simd_isa()
+{
+    return detail::simd::kernels().isa;
+}
+
+}  // namespace mat
+}  // namespace zx
@@ -357,3 +357,11 @@ TEST(array, array_2d_adjust_copy_bounds)
     EXPECT_THAT(dst_bounds[0], testing::Eq((zx::mat::interval_t<zx::mat::extent_base_t>{ 0, 2 })));
     EXPECT_THAT(dst_bounds[1], testing::Eq((zx::mat::interval_t<zx::mat::extent_base_t>{ 2, 5 })));
 }
+
+TEST(array, array_3d_dimension_order)
+{
+    const zx::mat::array_t<int, 3> a{ { 2, 3, 4 }, { 2, 0, 1 } };
+    EXPECT_THAT(a.extent(), (zx::mat::array_t<int, 3>::extent_type{ 2, 3, 4 }));
+    EXPECT_THAT(a.stride(), (zx::mat::stride_t<3>{ stride_of<int>(3), stride_of<int>(1), stride_of<int>(6) }));
+    EXPECT_THAT(a.m_data.size(), 24);
+}
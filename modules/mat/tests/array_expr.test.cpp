@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+
+#include <zx/array_expr.hpp>
+
+namespace
+{
+
+template <class T, std::size_t D>
+zx::mat::array_t<T, D> iota(const typename zx::mat::array_t<T, D>::extent_type& extent, T start = {})
+{
+    zx::mat::array_t<T, D> result{ extent };
+    std::iota(result.begin(), result.end(), start);
+    return result;
+}
+
+}  // namespace
+
+TEST(array_expr, arithmetic_is_evaluated_elementwise)
+{
+    const auto a = iota<float, 2>({ 2, 3 });
+    const auto b = iota<float, 2>({ 2, 3 }, 10.F);
+
+    const auto result = zx::mat::evaluate(a * 2.F + b);
+    EXPECT_THAT(result.extent(), (zx::mat::array_t<float, 2>::extent_type{ 2, 3 }));
+    EXPECT_THAT(result, testing::ElementsAre(10.F, 13.F, 16.F, 19.F, 22.F, 25.F));
+
+    EXPECT_THAT(zx::mat::evaluate(-(b - a) / 2.F), testing::Each(-5.F));
+}
+
+TEST(array_expr, assign_writes_into_strided_views)
+{
+    auto a = iota<int, 2>({ 3, 4 });
+    zx::mat::assign(a.slice({ {}, { {}, {}, 2 } }), a.slice({ {}, { {}, {}, -2 } }).as_const() * 100);
+    EXPECT_THAT(a, testing::ElementsAre(300, 1, 100, 3, 700, 5, 500, 7, 1100, 9, 900, 11));
+
+    zx::mat::assign(a, 7);
+    EXPECT_THAT(a, testing::Each(7));
+}
+
+TEST(array_expr, broadcasts_dimensions_of_extent_one)
+{
+    const auto column = iota<int, 2>({ 3, 1 }, 1);
+    const auto row = iota<int, 2>({ 1, 4 });
+
+    const auto result = zx::mat::evaluate(column * 10 + row);
+    EXPECT_THAT(result.extent(), (zx::mat::array_t<int, 2>::extent_type{ 3, 4 }));
+    EXPECT_THAT(result, testing::ElementsAre(10, 11, 12, 13, 20, 21, 22, 23, 30, 31, 32, 33));
+
+    EXPECT_THROW(zx::mat::evaluate(iota<int, 2>({ 3, 2 }) + row), std::invalid_argument);
+}
+
+TEST(array_expr, clamp_where_minimum_maximum)
+{
+    const auto a = iota<float, 1>(6, -2.F);
+
+    EXPECT_THAT(zx::mat::evaluate(zx::mat::clamp(a, 0.F, 2.F)), testing::ElementsAre(0.F, 0.F, 0.F, 1.F, 2.F, 2.F));
+    EXPECT_THAT(zx::mat::evaluate(zx::mat::where(a > 0.F, a, -a)), testing::ElementsAre(2.F, 1.F, 0.F, 1.F, 2.F, 3.F));
+    EXPECT_THAT(zx::mat::evaluate(a >= 1.F), testing::ElementsAre(0, 0, 0, 1, 1, 1));
+    EXPECT_THAT(zx::mat::evaluate(zx::mat::minimum(a, 1.F)), testing::ElementsAre(-2.F, -1.F, 0.F, 1.F, 1.F, 1.F));
+    EXPECT_THAT(zx::mat::evaluate(zx::mat::maximum(a, 1.F)), testing::ElementsAre(1.F, 1.F, 1.F, 1.F, 2.F, 3.F));
+    EXPECT_THAT(
+        zx::mat::evaluate(zx::mat::cast<std::uint8_t>(zx::mat::apply([](float v) { return v * v; }, a))),
+        testing::ElementsAre(4, 1, 0, 1, 4, 9));
+}
+
+TEST(array_expr, temporaries_are_kept_alive)
+{
+    const auto expr = iota<int, 1>(4) + iota<int, 1>(4, 1);
+    EXPECT_THAT(zx::mat::evaluate(expr), testing::ElementsAre(1, 3, 5, 7));
+}
+
+TEST(array_expr, reductions)
+{
+    const auto a = iota<float, 2>({ 4, 5 }, -3.F);
+
+    EXPECT_THAT(zx::mat::reduce::sum(a), 130.0);
+    EXPECT_THAT(zx::mat::reduce::min(a), -3.F);
+    EXPECT_THAT(zx::mat::reduce::max(a * 2.F), 32.F);
+    EXPECT_THAT(zx::mat::reduce::minmax(a.view().slice({ { 1, 3 }, { 1, 3 } })), testing::Pair(3.F, 9.F));
+    EXPECT_THAT(zx::mat::reduce::fold(a > 0.F, 0, [](int acc, bool v) { return acc + (v ? 1 : 0); }), 16);
+    EXPECT_THAT(zx::mat::reduce::sum(zx::mat::array_t<std::uint8_t, 1>(300, 255)), 76500U);
+
+    EXPECT_THROW(
+        zx::mat::reduce::minmax(zx::mat::array_t<float, 2>(zx::mat::array_t<float, 2>::extent_type{ 0, 3 })),
+        std::invalid_argument);
+}
+
+TEST(array_expr, normalization_in_a_single_pass)
+{
+    auto a = iota<float, 2>({ 8, 8 }, -10.F);
+    const auto [lo, up] = zx::mat::reduce::minmax(a);
+    zx::mat::assign(zx::mat::execution::parallel(), a, (a - lo) * (255.F / (up - lo)));
+
+    EXPECT_THAT(zx::mat::reduce::minmax(a), testing::Pair(0.F, testing::FloatNear(255.F, 1e-3F)));
+}
+
+TEST(array_expr, statistics)
+{
+    auto a = iota<float, 2>({ 5, 40 }, -100.F);
+    a[{ 3, 17 }] = -500.F;
+    a[{ 1, 30 }] = 900.F;
+    a[{ 4, 2 }] = 900.F;
+
+    EXPECT_THAT(zx::mat::reduce::argmin(a), (zx::mat::location_t<2>{ 3, 17 }));
+    EXPECT_THAT(zx::mat::reduce::argmax(a), (zx::mat::location_t<2>{ 1, 30 }));
+    EXPECT_THAT(zx::mat::reduce::argmax(a.view().slice({ {}, { {}, {}, 3 } })), (zx::mat::location_t<2>{ 1, 10 }));
+    EXPECT_THAT(zx::mat::reduce::argmin(iota<int, 1>(6, 3)), 0);
+    EXPECT_THAT(zx::mat::reduce::minmax(a), testing::Pair(-500.F, 900.F));
+
+    const auto b = iota<float, 1>(101);
+    EXPECT_THAT(zx::mat::reduce::mean(b), 50.0);
+    EXPECT_THAT(zx::mat::reduce::dot(b, b), 338350.0);
+    EXPECT_THAT(zx::mat::reduce::dot(b.view().slice({ {}, {}, 2 }), b.view().slice({ {}, {}, 2 })), 171700.0);
+
+    EXPECT_THROW(zx::mat::reduce::mean(zx::mat::array_t<float, 1>(0)), std::invalid_argument);
+}
+
+TEST(array_expr, histogram)
+{
+    zx::mat::array_t<std::uint8_t, 2> a{ { 40, 50 } };
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        *(a.begin() + static_cast<std::ptrdiff_t>(i)) = static_cast<std::uint8_t>(i % 200);
+    }
+
+    const auto contiguous = zx::mat::reduce::histogram(a);
+    EXPECT_THAT(contiguous[0], 10U);
+    EXPECT_THAT(contiguous[199], 10U);
+    EXPECT_THAT(contiguous[200], 0U);
+
+    const auto strided = zx::mat::reduce::histogram(a.view().slice({ {}, { {}, {}, 2 } }));
+    EXPECT_THAT(std::accumulate(strided.begin(), strided.end(), std::uint64_t{ 0 }), 1000U);
+    EXPECT_THAT(strided[1], 0U);
+}
@@ -0,0 +1,79 @@
+#include <gmock/gmock.h>
+
+#include <zx/fft.hpp>
+
+namespace
+{
+
+std::vector<zx::mat::complex_t> naive_dft(const std::vector<zx::mat::complex_t>& input)
+{
+    const double pi = std::acos(-1.0);
+    const auto n = static_cast<double>(input.size());
+    std::vector<zx::mat::complex_t> result(input.size());
+    for (std::size_t k = 0; k < input.size(); ++k)
+    {
+        std::complex<double> sum = 0.0;
+        for (std::size_t i = 0; i < input.size(); ++i)
+        {
+            const double angle = -2.0 * pi * static_cast<double>(k * i) / n;
+            sum += std::complex<double>{ input[i] } * std::polar(1.0, angle);
+        }
+        result[k] = zx::mat::complex_t{ static_cast<float>(sum.real()), static_cast<float>(sum.imag()) };
+    }
+    return result;
+}
+
+std::vector<zx::mat::complex_t> make_signal(std::size_t size)
+{
+    std::vector<zx::mat::complex_t> result(size);
+    std::uint32_t state = 7;
+    for (auto& value : result)
+    {
+        state = state * 1664525U + 1013904223U;
+        const auto re = static_cast<float>(state >> 24);
+        state = state * 1664525U + 1013904223U;
+        value = zx::mat::complex_t{ re, static_cast<float>(state >> 24) };
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(fft, matches_naive_dft)
+{
+    for (const std::size_t size : { 1U, 2U, 8U, 64U })
+    {
+        const auto signal = make_signal(size);
+        auto actual = signal;
+        zx::mat::fft_plan_t{ size }(actual.data());
+        const auto expected = naive_dft(signal);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            EXPECT_NEAR(actual[i].real(), expected[i].real(), 0.05) << size << " " << i;
+            EXPECT_NEAR(actual[i].imag(), expected[i].imag(), 0.05) << size << " " << i;
+        }
+    }
+}
+
+TEST(fft, inverse_restores_2d_block)
+{
+    const std::size_t size = 16;
+    const zx::mat::fft_plan_t plan{ size };
+    const auto signal = make_signal(size * size);
+    auto data = signal;
+    std::vector<zx::mat::complex_t> column;
+    plan.transform_2d(data.data(), column);
+    plan.transform_2d(data.data(), column, true);
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        EXPECT_NEAR(data[i].real() / static_cast<float>(size * size), signal[i].real(), 1e-3) << i;
+        EXPECT_NEAR(data[i].imag() / static_cast<float>(size * size), signal[i].imag(), 1e-3) << i;
+    }
+}
+
+TEST(fft, rejects_sizes_other_than_powers_of_two)
+{
+    EXPECT_THROW(zx::mat::fft_plan_t{ 0 }, std::invalid_argument);
+    EXPECT_THROW(zx::mat::fft_plan_t{ 12 }, std::invalid_argument);
+    EXPECT_NO_THROW(zx::mat::fft_plan_t{ 32 });
+}
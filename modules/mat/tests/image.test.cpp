@@ -1,7 +1,12 @@
 #include <gmock/gmock.h>
 
+#include <sstream>
+
 #include <zx/image.hpp>
 
+#include "matchers.hpp"
+#include "random_image.hpp"
+
 TEST(image, load_image)
 {
     const auto img = zx::mat::load_bitmap(zx::mat::filepath_t{ std::string(TEST_DATA_DIR) + "/test-24.bmp" });
@@ -58,4 +63,1230 @@ TEST(image, load_image)
     EXPECT_THAT((blue_channel[{ 2, 0 }]), 127);
     EXPECT_THAT((blue_channel[{ 2, 1 }]), 127);
     EXPECT_THAT((blue_channel[{ 2, 2 }]), 127);
-}
\ No newline at end of file
+}
+
+TEST(image, auto_levels_from_channel_histogram)
+{
+    zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 10, 20 } };
+    for (std::size_t i = 0; i < 200; ++i)
+    {
+        const auto loc = zx::mat::location_t<2>{ static_cast<zx::mat::location_base_t>(i / 20),
+                                                 static_cast<zx::mat::location_base_t>(i % 20) };
+        img[loc] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(50 + i % 101), 0, 0 };
+    }
+
+    const auto histogram = zx::mat::reduce::histogram(img.channel(0));
+    EXPECT_THAT(histogram[50], 2U);
+    EXPECT_THAT(histogram[49], 0U);
+
+    const auto table = zx::mat::lookup_table::auto_levels(histogram, 0.F);
+    EXPECT_THAT(table(50), 0.F);
+    EXPECT_THAT(table(150), 255.F);
+    EXPECT_THAT(table(100), testing::FloatNear(127.5F, 1e-3F));
+
+    EXPECT_THAT(zx::mat::lookup_table::auto_levels(histogram, 0.1F)(55), 0.F);
+    EXPECT_THAT(
+        zx::mat::lookup_table::auto_levels(zx::mat::histogram_t{}).m_table,
+        testing::ElementsAreArray(zx::mat::lookup_table::identity().m_table));
+}
+
+TEST(image, planar_layout)
+{
+    zx::mat::rgb_image_t interleaved{ zx::mat::rgb_image_t::extent_type{ 7, 9 } };
+    for (zx::mat::location_base_t y = 0; y < 7; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 9; ++x)
+        {
+            interleaved[{ y, x }] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(y * 30 + x),
+                                                           static_cast<zx::mat::byte_t>(x * 25),
+                                                           static_cast<zx::mat::byte_t>(200 - y * x) };
+        }
+    }
+    EXPECT_THAT(interleaved.layout(), zx::mat::image_layout_t::interleaved);
+
+    const zx::mat::rgb_image_t planar{ interleaved, zx::mat::image_layout_t::planar };
+    EXPECT_THAT(planar.layout(), zx::mat::image_layout_t::planar);
+    EXPECT_THAT(planar.data().shape().stride(), (zx::mat::stride_t<3>{ 9, 1, 63 }));
+    EXPECT_THAT(planar.channel(1).shape().stride(), (zx::mat::stride_t<2>{ 9, 1 }));
+    EXPECT_THAT(planar.channel(2), testing::ElementsAreArray(interleaved.channel(2)));
+    EXPECT_THAT((planar[{ 4, 5 }]), (interleaved[{ 4, 5 }]));
+
+    const zx::mat::rgb_image_t copy = planar.view();
+    EXPECT_THAT(copy.layout(), zx::mat::image_layout_t::planar);
+
+    const zx::mat::rgb_image_t back{ planar, zx::mat::image_layout_t::interleaved };
+    EXPECT_THAT(back.data(), testing::ElementsAreArray(interleaved.data()));
+
+    const auto table = zx::mat::lookup_table::contrast(1.5F) * zx::mat::lookup_table::brightness(-20.F);
+    const auto filter = [&](const zx::mat::rgb_color_t& color) { return table(zx::mat::true_color_t{ color }); };
+    const auto expected = zx::mat::with(interleaved, [&](auto v) { zx::mat::modify(v, filter); });
+    const auto actual_interleaved = zx::mat::with(interleaved, [&](auto v) { zx::mat::modify(v, table); });
+    const auto actual_planar = zx::mat::with(planar, [&](auto v) { zx::mat::modify(v, table); });
+    EXPECT_THAT(actual_interleaved.data(), testing::ElementsAreArray(expected.data()));
+    EXPECT_THAT(actual_planar.layout(), zx::mat::image_layout_t::planar);
+    EXPECT_THAT(
+        zx::mat::rgb_image_t(actual_planar, zx::mat::image_layout_t::interleaved).data(),
+        testing::ElementsAreArray(expected.data()));
+}
+
+TEST(image, planar_layout_of_degenerate_extents)
+{
+    for (const auto& extent : { zx::mat::rgb_image_t::extent_type{ 1, 1 },
+                                zx::mat::rgb_image_t::extent_type{ 1, 5 },
+                                zx::mat::rgb_image_t::extent_type{ 5, 1 } })
+    {
+        const zx::mat::rgb_image_t planar{ extent, zx::mat::image_layout_t::planar };
+        EXPECT_THAT(planar.layout(), zx::mat::image_layout_t::planar) << extent;
+        EXPECT_THAT(zx::mat::rgb_image_t{ planar.view() }.layout(), zx::mat::image_layout_t::planar) << extent;
+        const zx::mat::rgb_image_t interleaved{ extent, zx::mat::image_layout_t::interleaved };
+        EXPECT_THAT(interleaved.layout(), zx::mat::image_layout_t::interleaved) << extent;
+    }
+}
+
+TEST(image, bitmap_round_trip)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 5, 7 }, 9);
+
+    std::stringstream ss;
+    zx::mat::save_bitmap(img, ss);
+    EXPECT_THAT(ss.str().size(), 14U + 40U + 5U * (7U * 3U + 3U));
+
+    const auto loaded = zx::mat::load_bitmap(ss);
+    EXPECT_THAT(loaded, SamePixels(img));
+
+    zx::mat::rgb_image_t planar{ img.extent(), zx::mat::image_layout_t::planar };
+    planar.mut_view().data().assign(img.data());
+    std::stringstream planar_ss;
+    zx::mat::save_bitmap(planar.view(), planar_ss);
+    EXPECT_THAT(planar_ss.str(), ss.str());
+
+    std::stringstream rows_ss;
+    zx::mat::save_bitmap_rows(
+        rows_ss, img.extent(), [&](zx::mat::location_base_t y, const zx::mat::rgb_image_t::mut_view_type& row)
+        { row.data().assign(img.view().slice({ { y, y + 1 }, {} }).data()); });
+    EXPECT_THAT(rows_ss.str(), ss.str());
+
+    zx::mat::rgb_image_t streamed{ img.extent() };
+    std::vector<zx::mat::location_base_t> order;
+    std::stringstream rows_in{ ss.str() };
+    const auto extent = zx::mat::load_bitmap_rows(
+        rows_in,
+        [&](zx::mat::location_base_t y, const zx::mat::rgb_image_t::view_type& row)
+        {
+            order.push_back(y);
+            streamed.mut_view().slice({ { y, y + 1 }, {} }).data().assign(row.data());
+        });
+    EXPECT_THAT(extent, img.extent());
+    EXPECT_THAT(order, testing::ElementsAre(4, 3, 2, 1, 0));
+    EXPECT_THAT(streamed, SamePixels(img));
+
+    std::stringstream truncated{ ss.str().substr(0, 80) };
+    EXPECT_THROW(zx::mat::load_bitmap(truncated), std::runtime_error);
+}
+
+TEST(image, batched_filters_match_per_pixel_filters)
+{
+    // channel 0 of dst and src covers every pair of bytes
+    zx::mat::rgb_image_t dst{ zx::mat::rgb_image_t::extent_type{ 256, 256 } };
+    zx::mat::rgb_image_t src{ zx::mat::rgb_image_t::extent_type{ 256, 256 } };
+    for (zx::mat::location_base_t y = 0; y < 256; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 256; ++x)
+        {
+            const auto a = static_cast<zx::mat::byte_t>(y);
+            const auto b = static_cast<zx::mat::byte_t>(x);
+            const auto c = static_cast<zx::mat::byte_t>((x * 7 + y * 3) % 256);
+            dst.mut_view()[{ y, x }] = zx::mat::true_color_t{ a, c, b };
+            src.mut_view()[{ y, x }] = zx::mat::true_color_t{ b, a, c };
+        }
+    }
+    zx::mat::rgb_image_t planar{ dst.extent(), zx::mat::image_layout_t::planar };
+    planar.mut_view().data().assign(dst.data());
+    zx::mat::rgb_image_t planar_src{ src.extent(), zx::mat::image_layout_t::planar };
+    planar_src.mut_view().data().assign(src.data());
+
+    const auto expect_same_as_per_pixel = [&](const auto& filter)
+    {
+        auto expected = dst;
+        zx::mat::paste(expected.mut_view(), src, { 0, 0 }, zx::mat::detail::binary_color_filter_t{ filter });
+
+        auto actual = dst;
+        zx::mat::paste(zx::mat::execution::parallel(3), actual.mut_view(), src, { 0, 0 }, filter);
+        EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data()));
+
+        auto actual_planar = planar;
+        zx::mat::paste(actual_planar.mut_view(), src, { 0, 0 }, filter);
+        EXPECT_THAT(actual_planar.data(), testing::ElementsAreArray(expected.data()));
+
+        auto actual_mixed = dst;
+        zx::mat::paste(actual_mixed.mut_view(), planar_src, { 0, 0 }, filter);
+        EXPECT_THAT(actual_mixed.data(), testing::ElementsAreArray(expected.data()));
+    };
+    expect_same_as_per_pixel(zx::mat::filters::normal);
+    expect_same_as_per_pixel(zx::mat::filters::lighter);
+    expect_same_as_per_pixel(zx::mat::filters::darker);
+    expect_same_as_per_pixel(zx::mat::filters::multiply);
+    expect_same_as_per_pixel(zx::mat::filters::screen);
+    expect_same_as_per_pixel(zx::mat::filters::difference);
+    expect_same_as_per_pixel(zx::mat::filters::overlay);
+    expect_same_as_per_pixel(zx::mat::filters::add);
+    expect_same_as_per_pixel(zx::mat::filters::subtract);
+    expect_same_as_per_pixel(zx::mat::filters::blend(0.35F));
+
+    const auto expect_same_as_per_color = [&](const auto& filter)
+    {
+        auto expected = dst;
+        zx::mat::modify(expected.mut_view(), zx::mat::detail::color_filter_t{ filter });
+
+        auto actual = dst;
+        zx::mat::modify(zx::mat::execution::parallel(3), actual.mut_view(), filter);
+        EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data()));
+
+        auto actual_planar = planar;
+        zx::mat::modify(actual_planar.mut_view(), filter);
+        EXPECT_THAT(actual_planar.data(), testing::ElementsAreArray(expected.data()));
+    };
+    expect_same_as_per_color(zx::mat::filters::sepia);
+    expect_same_as_per_color(zx::mat::filters::gray);
+
+    EXPECT_TRUE(zx::mat::detail::is_span_filter_v<decltype(zx::mat::filters::sepia)>);
+    EXPECT_FALSE(zx::mat::detail::is_span_filter_v<zx::mat::detail::color_filter_t>);
+    EXPECT_FALSE(zx::mat::detail::is_span_blend_v<zx::mat::detail::binary_color_filter_t>);
+
+    // pasting at an offset clips both images
+    auto expected = dst;
+    zx::mat::paste(
+        expected.mut_view(), src, { 100, -30 }, zx::mat::detail::binary_color_filter_t{ zx::mat::filters::multiply });
+    auto actual = dst;
+    zx::mat::paste(actual.mut_view(), src, { 100, -30 }, zx::mat::filters::multiply);
+    EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data()));
+}
+
+TEST(image, color_pipeline_runs_stages_in_one_pass)
+{
+    // rows of more than two chunks of the pipeline, the last one partial
+    auto img = random_image(zx::mat::rgb_image_t::extent_type{ 24, 600 }, 17);
+    for (auto& value : img.mut_view().data())
+    {
+        value = static_cast<zx::mat::byte_t>(value / 2);
+    }
+
+    const auto run = [&](const auto& filter)
+    {
+        auto result = img;
+        zx::mat::modify(result.mut_view(), filter);
+        return result;
+    };
+
+    EXPECT_THAT(run(zx::mat::color_pipeline(zx::mat::filters::sepia)), SamePixels(run(zx::mat::filters::sepia)));
+
+    const auto contrast = zx::mat::lookup_table::contrast(1.5F);
+    const auto brightness = zx::mat::lookup_table::brightness(-20.F);
+    const auto tables = zx::mat::color_pipeline(contrast, brightness);
+    EXPECT_THAT(tables.size(), 1U);
+    EXPECT_THAT(run(tables), SamePixels(run(contrast * brightness)));
+
+    // values below 128 keep sepia from saturating, so only the intermediate rounding differs
+    const auto toned = zx::mat::color_pipeline(zx::mat::filters::sepia, zx::mat::filters::gray);
+    EXPECT_THAT(toned.size(), 1U);
+    auto sequential = run(zx::mat::filters::sepia);
+    zx::mat::modify(sequential.mut_view(), zx::mat::filters::gray);
+    EXPECT_THAT(run(toned), SamePixels(sequential, 1));
+
+    auto mixed = zx::mat::color_pipeline(
+        zx::mat::color_matrix::saturation(0.5F),
+        contrast,
+        [](const zx::mat::rgb_color_t& color) { return zx::mat::rgb_color_t{ color[1], color[2], color[0] }; },
+        zx::mat::color_matrix::sepia());
+    mixed.then(brightness).then(zx::mat::lookup_table::negative());
+    EXPECT_THAT(mixed.size(), 5U);
+    EXPECT_THAT(run(mixed), SamePixels(run(zx::mat::detail::color_filter_t{ mixed })));
+}
+
+TEST(image, byte_lookup_table_and_color_cube)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 64, 80 }, 5);
+    const auto planar = zx::mat::rgb_image_t{ img, zx::mat::image_layout_t::planar };
+
+    const auto contrast = zx::mat::lookup_table::contrast(1.5F);
+    const auto brightness = zx::mat::lookup_table::brightness(-20.F);
+    const auto negative = zx::mat::lookup_table::negative();
+    const zx::mat::byte_lookup_table_t curves{ contrast, brightness, negative };
+    auto expected = img;
+    for (zx::mat::location_base_t y = 0; y < 64; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 80; ++x)
+        {
+            const zx::mat::true_color_t color = img[{ y, x }];
+            expected[{ y, x }] = zx::mat::true_color_t{ zx::mat::true_color_t::from_float(contrast(color[0])),
+                                                        zx::mat::true_color_t::from_float(brightness(color[1])),
+                                                        zx::mat::true_color_t::from_float(negative(color[2])) };
+        }
+    }
+    auto actual = img;
+    zx::mat::modify(zx::mat::execution::parallel(3), actual.mut_view(), curves);
+    EXPECT_THAT(actual, SamePixels(expected));
+    auto actual_planar = planar;
+    zx::mat::modify(actual_planar.mut_view(), curves);
+    EXPECT_THAT(actual_planar, SamePixels(expected));
+
+    // affine transforms are reproduced by the interpolation, so only the final truncation differs from the pipeline;
+    // the span call truncates like the per-color call
+    const auto expect_cube_matches = [&](const zx::mat::color_cube_t& cube, const auto& transform)
+    {
+        auto cubed = planar;
+        zx::mat::modify(zx::mat::execution::parallel(3), cubed.mut_view(), cube);
+        auto per_color = img;
+        zx::mat::modify(per_color.mut_view(), zx::mat::detail::color_filter_t{ cube });
+        EXPECT_THAT(cubed, SamePixels(per_color));
+
+        auto direct = img;
+        zx::mat::modify(direct.mut_view(), zx::mat::color_pipeline(transform));
+        EXPECT_THAT(cubed, SamePixels(direct, 1));
+    };
+    const auto identity = [](const zx::mat::rgb_color_t& color) { return color; };
+    expect_cube_matches(zx::mat::color_cube_t::create(identity, 17), identity);
+    // an identity cube is not exact, but truncation never raises a byte
+    auto lowered = img;
+    zx::mat::modify(lowered.mut_view(), zx::mat::color_cube_t::create(identity));
+    EXPECT_TRUE(std::equal(
+        lowered.data().begin(),
+        lowered.data().end(),
+        img.data().begin(),
+        img.data().end(),
+        [](zx::mat::byte_t lhs, zx::mat::byte_t rhs) { return lhs <= rhs; }));
+    const auto matrix = zx::mat::color_matrix::saturation(0.3F);
+    const auto cube = zx::mat::color_cube_t::create(matrix);
+    EXPECT_THAT(cube.size(), 33U);
+    expect_cube_matches(cube, matrix);
+
+    // grid points return the samples of any transform
+    const auto swap = zx::mat::color_cube_t::create(
+        [](const zx::mat::rgb_color_t& color) { return zx::mat::rgb_color_t{ color[2] * 0.5F, color[0], 255.F }; }, 3);
+    EXPECT_THAT(swap(zx::mat::rgb_color_t{ 127.5F, 255.F, 0.F }), (zx::mat::rgb_color_t{ 0.F, 127.5F, 255.F }));
+    EXPECT_THAT(swap(zx::mat::rgb_color_t{ 0.F, 127.5F, 255.F }), (zx::mat::rgb_color_t{ 127.5F, 0.F, 255.F }));
+    EXPECT_THROW(zx::mat::color_cube_t(2, std::vector<float>(10)), std::invalid_argument);
+}
+
+TEST(image, warp_affine_and_arbitrary_rotation)
+{
+    zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 30, 41 } };
+    for (zx::mat::location_base_t y = 0; y < 30; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 41; ++x)
+        {
+            img[{ y, x }] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(x * 6),
+                                                   static_cast<zx::mat::byte_t>(y * 8),
+                                                   static_cast<zx::mat::byte_t>((x * y * 7) % 256) };
+        }
+    }
+
+    for (const int degrees : { 90, 180, -90, 360 })
+    {
+        const zx::mat::rgb_image_t expected = zx::mat::rotate(img.view(), degrees);
+        for (const auto interpolation :
+             { zx::mat::interpolation_t::nearest, zx::mat::interpolation_t::bilinear, zx::mat::interpolation_t::bicubic })
+        {
+            const auto actual = zx::mat::rotate(img.view(), static_cast<float>(degrees), interpolation);
+            EXPECT_THAT(actual.extent(), expected.extent()) << degrees << " " << interpolation;
+            EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data())) << degrees << " " << interpolation;
+        }
+    }
+
+    // pixels mapped from outside the source keep their value
+    zx::mat::rgb_image_t shifted{ img.extent() };
+    shifted.mut_view().data().fill(7);
+    zx::mat::warp_affine(
+        shifted.mut_view(),
+        img,
+        zx::mat::translation(zx::mat::vector_t<2, float>{ 3.F, -2.F }),
+        zx::mat::interpolation_t::nearest);
+    for (zx::mat::location_base_t y = 0; y < 30; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 41; ++x)
+        {
+            const zx::mat::true_color_t expected
+                = x >= 3 && y < 28 ? img[{ y + 2, x - 3 }] : zx::mat::true_color_t{ 7, 7, 7 };
+            EXPECT_THAT((shifted[{ y, x }]), expected);
+        }
+    }
+
+    // half a pixel to the right averages horizontal neighbours of the linear red channel
+    zx::mat::rgb_image_t half{ img.extent() };
+    zx::mat::warp_affine(half.mut_view(), img, zx::mat::translation(zx::mat::vector_t<2, float>{ 0.5F, 0.F }));
+    EXPECT_THAT((half.channel(0)[{ 4, 10 }]), 57);
+    EXPECT_THAT((half.channel(0)[{ 4, 0 }]), 0);
+
+    const auto rotated = zx::mat::rotate(img.view(), 30.F, zx::mat::interpolation_t::bicubic);
+    EXPECT_THAT(rotated.extent(), (zx::mat::rgb_image_t::extent_type{ 47, 51 }));
+    EXPECT_THAT(
+        zx::mat::rotate(zx::mat::execution::parallel(3), img.view(), 30.F, zx::mat::interpolation_t::bicubic).data(),
+        testing::ElementsAreArray(rotated.data()));
+
+    // an angle alone selects the quarter turns, and an interpolation the resampling, whatever the angle's type
+    EXPECT_THROW(zx::mat::rotate(img.view(), 45), std::invalid_argument);
+    static_assert(!std::is_invocable_v<decltype(zx::mat::rotate), const zx::mat::rgb_image_t::view_type&, double>);
+    static_assert(!std::is_invocable_v<decltype(zx::mat::rotate), const zx::mat::rgb_image_t::view_type&, float>);
+    EXPECT_THAT(
+        zx::mat::rotate(img.view(), 30.0, zx::mat::interpolation_t::bicubic).data(),
+        testing::ElementsAreArray(rotated.data()));
+    EXPECT_THAT(
+        zx::mat::rotate(img.view(), 45, zx::mat::interpolation_t::bilinear).extent(),
+        (zx::mat::rgb_image_t::extent_type{ 51, 51 }));
+    EXPECT_THAT(
+        zx::mat::rotate(img.view(), 90.5F, zx::mat::interpolation_t::bilinear).extent(),
+        (zx::mat::rgb_image_t::extent_type{ 42, 31 }));
+
+    EXPECT_THROW(
+        zx::mat::warp_affine(shifted.mut_view(), img, zx::mat::scale(zx::mat::vector_t<2, float>{ 0.F, 1.F })),
+        std::invalid_argument);
+}
+
+TEST(image, materialize_rotated_and_flipped_views)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 37, 53 }, 3);
+    const auto planar = zx::mat::rgb_image_t{ img, zx::mat::image_layout_t::planar };
+
+    for (const zx::mat::rgb_image_t* source : { &img, &planar })
+    {
+        for (const int degrees : { 90, 180, 270 })
+        {
+            for (const auto& view : { zx::mat::rotate(source->view(), degrees),
+                                      zx::mat::flip_horizontal(zx::mat::rotate(source->view(), degrees)),
+                                      zx::mat::flip_vertical(zx::mat::rotate(source->view(), degrees)) })
+            {
+                const zx::mat::rgb_image_t result = zx::mat::materialize(view);
+                EXPECT_THAT(result.layout(), source->layout());
+                EXPECT_FALSE(zx::mat::detail::is_transposed(result.data().shape()));
+                EXPECT_THAT(result.data(), testing::ElementsAreArray(view.data())) << degrees;
+            }
+        }
+    }
+
+    const auto channel = zx::mat::rotate(img.channel(1), 90);
+    const auto plane = zx::mat::materialize(channel);
+    EXPECT_THAT(plane.shape().dim(1).stride, 1);
+    EXPECT_THAT(plane.view(), testing::ElementsAreArray(channel));
+    const auto planar_channel = zx::mat::flip_vertical(zx::mat::rotate(planar.channel(2), 270));
+    EXPECT_THAT(zx::mat::materialize(planar_channel).view(), testing::ElementsAreArray(planar_channel));
+
+    std::stringstream ss;
+    zx::mat::save_bitmap(zx::mat::rotate(img.view(), 90), ss);
+    EXPECT_THAT(zx::mat::load_bitmap(ss).data(), testing::ElementsAreArray(zx::mat::rotate(img.view(), 90).data()));
+}
+
+TEST(image, resize_and_pyramid)
+{
+    zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 30, 40 } };
+    for (zx::mat::location_base_t y = 0; y < 30; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 40; ++x)
+        {
+            img[{ y, x }] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(x * 4),
+                                                   static_cast<zx::mat::byte_t>(y * 8),
+                                                   static_cast<zx::mat::byte_t>((x * y * 7) % 256) };
+        }
+    }
+    zx::mat::rgb_image_t planar{ img.extent(), zx::mat::image_layout_t::planar };
+    planar.mut_view().data().assign(img.data());
+    const auto near = [](zx::mat::byte_t lhs, zx::mat::byte_t rhs) { return std::abs(int{ lhs } - int{ rhs }) <= 1; };
+
+    zx::mat::rgb_image_t flat{ img.extent() };
+    flat.mut_view().data().fill(93);
+    for (const auto filter :
+         { zx::mat::resize_filter_t::box, zx::mat::resize_filter_t::bilinear, zx::mat::resize_filter_t::lanczos })
+    {
+        for (const auto extent :
+             { zx::mat::rgb_image_t::extent_type{ 13, 17 }, zx::mat::rgb_image_t::extent_type{ 71, 90 } })
+        {
+            const auto resized = zx::mat::resize(flat, extent, filter);
+            EXPECT_THAT(resized.extent(), extent);
+            EXPECT_THAT(resized.data(), testing::Each(93)) << filter;
+
+            const auto expected = zx::mat::resize(img, extent, filter);
+            EXPECT_THAT(
+                zx::mat::resize(zx::mat::execution::parallel(3), planar, extent, filter).data(),
+                testing::ElementsAreArray(expected.data()));
+        }
+        EXPECT_THAT(zx::mat::resize(planar, img.extent(), filter).data(), testing::ElementsAreArray(img.data()));
+    }
+
+    // box halving averages 2x2 blocks
+    const auto halved = zx::mat::resize(img, { 15, 20 }, zx::mat::resize_filter_t::box);
+    for (zx::mat::location_base_t y = 0; y < 15; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 20; ++x)
+        {
+            for (std::size_t z = 0; z < 3; ++z)
+            {
+                const int sum = int{ img.view()[{ 2 * y, 2 * x }][z] } + int{ img.view()[{ 2 * y, 2 * x + 1 }][z] }
+                                + int{ img.view()[{ 2 * y + 1, 2 * x }][z] }
+                                + int{ img.view()[{ 2 * y + 1, 2 * x + 1 }][z] };
+                EXPECT_TRUE(near(halved.view()[{ y, x }][z], static_cast<zx::mat::byte_t>((sum + 2) / 4)));
+            }
+        }
+    }
+
+    // doubling the red ramp with the bilinear filter interpolates between pixel centers
+    const auto doubled = zx::mat::resize(img, { 30, 80 }, zx::mat::resize_filter_t::bilinear);
+    for (zx::mat::location_base_t x = 1; x < 79; ++x)
+    {
+        EXPECT_TRUE(near(doubled.channel(0)[{ 5, x }], static_cast<zx::mat::byte_t>(2 * x - 1))) << x;
+    }
+
+    const auto levels = zx::mat::pyramid(img, 3);
+    ASSERT_THAT(levels.size(), 3U);
+    EXPECT_THAT(levels[0].extent(), (zx::mat::rgb_image_t::extent_type{ 15, 20 }));
+    EXPECT_THAT(levels[1].extent(), (zx::mat::rgb_image_t::extent_type{ 8, 10 }));
+    EXPECT_THAT(levels[2].extent(), (zx::mat::rgb_image_t::extent_type{ 4, 5 }));
+    EXPECT_THAT(
+        levels[2].data(),
+        testing::ElementsAreArray(zx::mat::resize(levels[1], { 4, 5 }, zx::mat::resize_filter_t::bilinear).data()));
+
+    EXPECT_THROW(zx::mat::resize(img, { 0, 10 }), std::invalid_argument);
+}
+
+TEST(image, separable_convolution)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 70, 45 }, 31);
+
+    EXPECT_TRUE(zx::mat::kernel::gaussian(1.5F, 7).m_separable);
+    EXPECT_TRUE(zx::mat::kernel::sobel().m_separable[0]);
+    EXPECT_TRUE(zx::mat::kernel::prewitt().m_separable[1]);
+    EXPECT_FALSE(zx::mat::kernel::sharpen().m_separable);
+
+    const auto expect_dense_equivalent = [&](const auto& kernel)
+    {
+        auto dense = kernel;
+        dense.m_separable = {};
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::rgb_image_t actual{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, dense);
+        zx::mat::convolve(zx::mat::execution::parallel(2), actual.mut_view(), img, kernel);
+        EXPECT_THAT(actual, SamePixels(expected, 1));
+    };
+    expect_dense_equivalent(zx::mat::kernel::gaussian(2.F, 9));
+    expect_dense_equivalent(zx::mat::kernel::separable({ 1.F, 2.F, 1.F }, { 0.25F, 0.F, 0.25F, 0.5F }));
+    expect_dense_equivalent(zx::mat::kernel::sobel());
+
+    const auto mask = zx::mat::kernel::separable({ 1.F, -1.F }, { 2.F, 3.F }).m_mask;
+    EXPECT_THAT(mask, testing::ElementsAre(2.F, 3.F, -2.F, -3.F));
+}
+
+TEST(image, fixed_point_convolution)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 90, 33 }, 32);
+
+    const auto sharpen = zx::mat::kernel::sharpen();
+    ASSERT_TRUE(sharpen.m_fixed_point);
+    EXPECT_THAT(sharpen.m_fixed_point->shift, 12);
+    EXPECT_FALSE(zx::mat::detail::quantize(zx::mat::kernel::gaussian(5.F, 31).m_mask));
+
+    const auto expect_float_equivalent = [&](zx::mat::detail::apply_kernel_t<1> kernel)
+    {
+        kernel.m_separable = {};
+        auto exact = kernel;
+        exact.m_precision = zx::mat::kernel_precision_t::exact;
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::rgb_image_t actual{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, exact);
+        zx::mat::convolve(zx::mat::execution::parallel(2), actual.mut_view(), img, kernel);
+        EXPECT_THAT(actual, SamePixels(expected, 1));
+    };
+    expect_float_equivalent(sharpen);
+    expect_float_equivalent(zx::mat::kernel::emboss());
+    expect_float_equivalent(zx::mat::kernel::gaussian(1.F, 5));
+}
+
+TEST(image, kernel_taps_follow_region_strides)
+{
+    zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 4, 5 } };
+    for (zx::mat::location_base_t y = 0; y < 4; ++y)
+    {
+        for (zx::mat::location_base_t x = 0; x < 5; ++x)
+        {
+            img[{ y, x }] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(y * 10 + x), 0, 0 };
+        }
+    }
+
+    const auto kernel = zx::mat::kernel::dilate(zx::mat::mask::square(3));
+    const auto red = img.channel(0);
+    EXPECT_THAT(kernel(red.slice({ { 0, 3 }, { 0, 3 } })), 22.F);
+    EXPECT_THAT(kernel(red.slice({ { 1, 4 }, { 2, 5 } })), 34.F);
+    EXPECT_THAT(kernel(red.slice({ { 2, 4 }, { 3, 5 } })), 34.F);
+
+    const auto planar = zx::mat::rgb_image_t{ img, zx::mat::image_layout_t::planar };
+    EXPECT_THAT(kernel(planar.channel(0).slice({ { 1, 4 }, { 1, 4 } })), 33.F);
+    EXPECT_THAT(zx::mat::kernel::median(zx::mat::mask::square(3))(red.slice({ { 0, 3 }, { 0, 3 } })), 11.F);
+}
+
+TEST(image, sliding_histogram_percentile)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 75, 41 }, 7);
+
+    EXPECT_THAT(zx::mat::kernel::median(zx::mat::mask::square(3)).m_uniform_weight, testing::Optional(1.F));
+    EXPECT_FALSE(zx::mat::kernel::median(zx::mat::mask::circle(5)).m_uniform_weight);
+
+    const auto expect_generic_equivalent = [&](const zx::mat::detail::percentile_kernel_t& kernel)
+    {
+        auto generic = kernel;
+        generic.m_uniform_weight = {};
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::rgb_image_t actual{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, generic);
+        zx::mat::convolve(zx::mat::execution::parallel(3), actual.mut_view(), img, kernel);
+        EXPECT_THAT(actual, SamePixels(expected));
+    };
+    expect_generic_equivalent(zx::mat::kernel::median(zx::mat::mask::square(5)));
+    expect_generic_equivalent(zx::mat::kernel::median(zx::mat::mask::rect({ 3, 8 })));
+    expect_generic_equivalent(zx::mat::kernel::percentile(0, zx::mat::mask::square(3)));
+    expect_generic_equivalent(zx::mat::kernel::percentile(90, zx::mat::mask::rect({ 7, 2 })));
+
+    auto halved = zx::mat::mask::square(3);
+    std::fill(halved.begin(), halved.end(), 0.5F);
+    expect_generic_equivalent(zx::mat::kernel::percentile(25, halved));
+}
+
+TEST(image, van_herk_morphology)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 83, 47 }, 11);
+
+    EXPECT_THAT(zx::mat::kernel::dilate(zx::mat::mask::rect({ 3, 4 })).m_uniform_weight, testing::Optional(1.F));
+    EXPECT_FALSE(zx::mat::kernel::erode(zx::mat::mask::circle(5)).m_uniform_weight);
+
+    const auto expect_generic_equivalent = [&](auto kernel)
+    {
+        auto generic = kernel;
+        generic.m_uniform_weight = {};
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::rgb_image_t actual{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, generic);
+        zx::mat::convolve(zx::mat::execution::parallel(3), actual.mut_view(), img, kernel);
+        EXPECT_THAT(actual, SamePixels(expected));
+    };
+    expect_generic_equivalent(zx::mat::kernel::dilate(zx::mat::mask::square(5)));
+    expect_generic_equivalent(zx::mat::kernel::erode(zx::mat::mask::rect({ 9, 2 })));
+    expect_generic_equivalent(zx::mat::kernel::dilate(zx::mat::mask::rect({ 1, 6 })));
+
+    zx::mat::rgb_image_t ramp{ img.extent() };
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+        for (zx::mat::location_base_t y = 0; y < 83; ++y)
+        {
+            for (zx::mat::location_base_t x = 0; x < 47; ++x)
+            {
+                ramp.channel(c)[{ y, x }] = static_cast<zx::mat::byte_t>(2 * y + x + (img.channel(c)[{ y, x }] >> 4));
+            }
+        }
+    }
+    const auto large = zx::mat::kernel::erode(zx::mat::mask::rect({ 40, 29 }));
+    zx::mat::rgb_image_t eroded{ ramp.extent() };
+    zx::mat::convolve(zx::mat::execution::parallel(3), eroded.mut_view(), ramp, large);
+    for (std::size_t c = 0; c < 3; ++c)
+    {
+        for (zx::mat::location_base_t y = 0; y + 40 <= 83; ++y)
+        {
+            for (zx::mat::location_base_t x = 0; x + 29 <= 47; ++x)
+            {
+                EXPECT_THAT((eroded.channel(c)[{ y, x }]), large(ramp.channel(c).slice({ { y, y + 40 }, { x, x + 29 } })));
+            }
+        }
+    }
+
+    const auto mask = zx::mat::mask::square(3);
+    const auto red = img.channel(0);
+    const auto window = [&](zx::mat::location_base_t y, zx::mat::location_base_t x, zx::mat::location_base_t size)
+    { return red.slice({ { y, y + size }, { x, x + size } }); };
+    const auto dilate = zx::mat::kernel::dilate(mask);
+    const auto erode = zx::mat::kernel::erode(mask);
+
+    const auto opened = zx::mat::with(img, [&](auto v) { zx::mat::convolve(v, zx::mat::kernel::opening(mask)); });
+    const auto closed = zx::mat::with(img, [&](auto v) { zx::mat::convolve(v, zx::mat::kernel::closing(mask)); });
+    const auto gradient = zx::mat::with(img, [&](auto v) { zx::mat::convolve(v, zx::mat::kernel::gradient(mask)); });
+    for (const auto& [y, x] : { std::pair{ 0, 0 }, std::pair{ 10, 20 }, std::pair{ 78, 42 } })
+    {
+        float opening = 0.F;
+        float closing = 255.F;
+        for (zx::mat::location_base_t dy = 0; dy < 3; ++dy)
+        {
+            for (zx::mat::location_base_t dx = 0; dx < 3; ++dx)
+            {
+                opening = std::max(opening, erode(window(y + dy, x + dx, 3)));
+                closing = std::min(closing, dilate(window(y + dy, x + dx, 3)));
+            }
+        }
+        EXPECT_THAT((opened.channel(0)[{ y, x }]), opening);
+        EXPECT_THAT((closed.channel(0)[{ y, x }]), closing);
+        EXPECT_THAT((gradient.channel(0)[{ y, x }]), dilate(window(y, x, 3)) - erode(window(y, x, 3)));
+    }
+}
+
+TEST(image, border_index)
+{
+    const auto indices = [](zx::mat::border_mode_t mode)
+    {
+        std::vector<zx::mat::location_base_t> result;
+        for (zx::mat::location_base_t i = -3; i < 7; ++i)
+        {
+            result.push_back(zx::mat::detail::border_index(i, 4, mode));
+        }
+        return result;
+    };
+    EXPECT_THAT(indices(zx::mat::border_mode_t::constant), testing::ElementsAre(-1, -1, -1, 0, 1, 2, 3, -1, -1, -1));
+    EXPECT_THAT(indices(zx::mat::border_mode_t::replicate), testing::ElementsAre(0, 0, 0, 0, 1, 2, 3, 3, 3, 3));
+    EXPECT_THAT(indices(zx::mat::border_mode_t::reflect), testing::ElementsAre(2, 1, 0, 0, 1, 2, 3, 3, 2, 1));
+    EXPECT_THAT(indices(zx::mat::border_mode_t::wrap), testing::ElementsAre(1, 2, 3, 0, 1, 2, 3, 0, 1, 2));
+}
+
+TEST(image, convolve_with_border)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 150, 37 }, 5);
+
+    const auto padded = [&](const zx::mat::border_t& border, const zx::mat::rgb_image_t::extent_type& window)
+    {
+        const auto before = zx::mat::rgb_image_t::extent_type{ (window[0] - 1) / 2, (window[1] - 1) / 2 };
+        zx::mat::rgb_image_t result{ zx::mat::rgb_image_t::extent_type{ img.extent()[0] + window[0] - 1,
+                                                                        img.extent()[1] + window[1] - 1 } };
+        for (zx::mat::location_base_t y = 0; y < result.extent()[0]; ++y)
+        {
+            for (zx::mat::location_base_t x = 0; x < result.extent()[1]; ++x)
+            {
+                const auto sy = zx::mat::detail::border_index(y - before[0], img.extent()[0], border.mode);
+                const auto sx = zx::mat::detail::border_index(x - before[1], img.extent()[1], border.mode);
+                result[{ y, x }] = sy < 0 || sx < 0 ? zx::mat::true_color_t{ border.value, border.value, border.value }
+                                                    : zx::mat::true_color_t{ img[{ sy, sx }] };
+            }
+        }
+        return result;
+    };
+
+    const auto expect_padded_equivalent = [&](const auto& kernel)
+    {
+        for (const auto& border : { zx::mat::border::constant(200),
+                                    zx::mat::border::replicate(),
+                                    zx::mat::border::reflect(),
+                                    zx::mat::border::wrap() })
+        {
+            zx::mat::rgb_image_t expected{ img.extent() };
+            zx::mat::rgb_image_t actual{ img.extent() };
+            zx::mat::convolve(expected.mut_view(), padded(border, kernel.extent()), kernel);
+            zx::mat::convolve(zx::mat::execution::parallel(3), actual.mut_view(), img, kernel, border);
+            EXPECT_THAT(actual, SamePixels(expected)) << border;
+
+            auto in_place = img;
+            zx::mat::convolve(in_place.mut_view(), kernel, border);
+            EXPECT_THAT(in_place, SamePixels(expected)) << border;
+        }
+
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, kernel);
+        auto in_place = img;
+        zx::mat::convolve(in_place.mut_view(), kernel);
+        EXPECT_THAT(in_place, SamePixels(expected));
+    };
+    expect_padded_equivalent(zx::mat::kernel::gaussian(2.F, 7));
+    expect_padded_equivalent(zx::mat::kernel::sharpen());
+    expect_padded_equivalent(zx::mat::kernel::sobel());
+    expect_padded_equivalent(zx::mat::kernel::median(zx::mat::mask::rect({ 5, 4 })));
+    expect_padded_equivalent(zx::mat::kernel::erode(zx::mat::mask::square(3)));
+    expect_padded_equivalent(zx::mat::kernel::dilate(zx::mat::mask::circle(5)));
+    expect_padded_equivalent(zx::mat::kernel::dilate(zx::mat::mask::square(81)));
+}
+
+TEST(image, fft_convolution_matches_direct)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 180, 300 }, 11);
+
+    zx::mat::mask_t mask = zx::mat::mask::circle(21);
+    const float sum = std::accumulate(mask.m_data.begin(), mask.m_data.end(), 0.F);
+    for (float& value : mask.m_data)
+    {
+        value /= sum;
+    }
+    mask[{ 0, 20 }] = 0.05F;
+
+    auto direct = zx::mat::detail::apply_kernel_t<1>{ mask, zx::mat::kernel_precision_t::exact };
+    direct.m_method = zx::mat::convolution_method_t::direct;
+    auto fft = direct;
+    fft.m_method = zx::mat::convolution_method_t::fft;
+
+    EXPECT_THAT(zx::mat::detail::select_method(direct, img.extent()), zx::mat::convolution_method_t::direct);
+    EXPECT_THAT(
+        zx::mat::detail::select_method(zx::mat::detail::apply_kernel_t<1>{ mask }, img.extent()),
+        zx::mat::convolution_method_t::fft);
+    EXPECT_THAT(
+        zx::mat::detail::select_method(zx::mat::kernel::sharpen(), img.extent()), zx::mat::convolution_method_t::direct);
+    EXPECT_THAT(
+        zx::mat::detail::select_method(zx::mat::kernel::gaussian(2.F, 7), img.extent()),
+        zx::mat::convolution_method_t::separable);
+
+    for (const auto& border : { zx::mat::border::valid(),
+                                zx::mat::border::constant(200),
+                                zx::mat::border::reflect(),
+                                zx::mat::border::wrap() })
+    {
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::rgb_image_t actual{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, direct, border);
+        zx::mat::convolve(zx::mat::execution::parallel(3), actual.mut_view(), img, fft, border);
+        EXPECT_THAT(actual, SamePixels(expected, 1)) << border;
+
+        auto in_place = img;
+        zx::mat::convolve(in_place.mut_view(), fft, border);
+        EXPECT_THAT(in_place, SamePixels(expected, 1)) << border;
+    }
+}
+
+TEST(image, integral_image_queries)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 37, 52 }, 5);
+
+    const auto expect_matches = [&](const zx::mat::integral_image_t& table, const zx::mat::rgb_image_t& image)
+    {
+        ASSERT_THAT(table.channels(), 3U);
+        EXPECT_THAT(table.extent(), image.extent());
+        for (const auto& region : { zx::mat::rectangle_t<zx::mat::location_base_t>{ { 0, 37 }, { 0, 52 } },
+                                    zx::mat::rectangle_t<zx::mat::location_base_t>{ { 3, 20 }, { 7, 8 } },
+                                    zx::mat::rectangle_t<zx::mat::location_base_t>{ { 30, 50 }, { -4, 11 } } })
+        {
+            for (std::size_t z = 0; z < 3; ++z)
+            {
+                double sum = 0.0;
+                double square_sum = 0.0;
+                double n = 0.0;
+                for (zx::mat::location_base_t y = std::max(region[0][0], 0); y < std::min(region[0][1], 37); ++y)
+                {
+                    for (zx::mat::location_base_t x = std::max(region[1][0], 0); x < std::min(region[1][1], 52); ++x)
+                    {
+                        const auto value = static_cast<double>(image.channel(z)[{ y, x }]);
+                        sum += value;
+                        square_sum += value * value;
+                        n += 1.0;
+                    }
+                }
+                EXPECT_THAT(table.sum(z, region), static_cast<std::uint32_t>(sum)) << region;
+                EXPECT_THAT(table.square_sum(z, region), static_cast<std::uint64_t>(square_sum)) << region;
+                EXPECT_THAT(table.mean(z, region), testing::FloatNear(static_cast<float>(sum / n), 1e-3F));
+                const double variance = square_sum / n - (sum / n) * (sum / n);
+                EXPECT_THAT(table.variance(z, region), testing::FloatNear(static_cast<float>(variance), 1e-1F));
+            }
+        }
+        EXPECT_THAT(table.mean(0, zx::mat::rectangle_t<zx::mat::location_base_t>{ { 5, 5 }, { 0, 52 } }), 0.F);
+    };
+
+    expect_matches(zx::mat::integral(img), img);
+    const auto planar = zx::mat::rgb_image_t{ img, zx::mat::image_layout_t::planar };
+    expect_matches(zx::mat::integral(zx::mat::execution::parallel(2), planar), img);
+
+    const auto green = zx::mat::integral(img.channel(1));
+    ASSERT_THAT(green.channels(), 1U);
+    const zx::mat::rectangle_t<zx::mat::location_base_t> region{ { 2, 9 }, { 4, 30 } };
+    EXPECT_THAT(green.sum(0, region), zx::mat::integral(img).sum(1, region));
+}
+
+TEST(image, box_convolution_uses_integral_images)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 150, 211 }, 13);
+
+    EXPECT_THAT(
+        zx::mat::detail::select_method(zx::mat::kernel::box({ 9, 15 }), img.extent()),
+        zx::mat::convolution_method_t::integral);
+    EXPECT_THAT(
+        zx::mat::detail::select_method(zx::mat::mask::square(21), img.extent()), zx::mat::convolution_method_t::integral);
+    auto forced = zx::mat::kernel::sharpen();
+    forced.m_method = zx::mat::convolution_method_t::integral;
+    EXPECT_THAT(zx::mat::detail::select_method(forced, img.extent()), zx::mat::convolution_method_t::direct);
+
+    for (const auto& size : { zx::mat::extent_t<2, zx::mat::extent_base_t>{ 9, 15 },
+                              zx::mat::extent_t<2, zx::mat::extent_base_t>{ 1, 4 } })
+    {
+        auto direct = zx::mat::kernel::box(size);
+        direct.m_precision = zx::mat::kernel_precision_t::exact;
+        direct.m_method = zx::mat::convolution_method_t::direct;
+        for (const auto& border : { zx::mat::border::valid(),
+                                    zx::mat::border::constant(17),
+                                    zx::mat::border::reflect(),
+                                    zx::mat::border::wrap() })
+        {
+            zx::mat::rgb_image_t expected{ img.extent() };
+            zx::mat::rgb_image_t actual{ img.extent() };
+            zx::mat::convolve(expected.mut_view(), img, direct, border);
+            const auto box = zx::mat::kernel::box(size);
+            zx::mat::convolve(zx::mat::execution::parallel(3), actual.mut_view(), img, box, border);
+            EXPECT_THAT(actual, SamePixels(expected, 1)) << border;
+        }
+    }
+
+    // plain sums saturate
+    zx::mat::rgb_image_t summed{ img.extent() };
+    zx::mat::convolve(summed.mut_view(), img, zx::mat::detail::apply_kernel_t<1>{ zx::mat::mask::square(3) });
+    int sum = 0;
+    for (zx::mat::location_base_t y = 10; y < 13; ++y)
+    {
+        for (zx::mat::location_base_t x = 20; x < 23; ++x)
+        {
+            sum += img.channel(0)[{ y, x }];
+        }
+    }
+    const int value = summed.channel(0)[{ 10, 20 }];
+    EXPECT_THAT(value, std::min(sum, 255));
+}
+
+TEST(image, tiled_convolution_matches_channel_by_channel)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 301, 700 }, 3);
+
+    const auto expect_identical = [&](const auto& kernel, const zx::mat::border_t& border)
+    {
+        zx::mat::rgb_image_t expected{ img.extent() };
+        for (std::size_t z = 0; z < 3; ++z)
+        {
+            zx::mat::convolve(expected.mut_view().channel(z), img.channel(z), kernel, border);
+        }
+        for (const auto& policy : { zx::mat::execution::sequential(),
+                                    zx::mat::execution::parallel(3),
+                                    zx::mat::execution::deterministic(2, 7) })
+        {
+            zx::mat::rgb_image_t actual{ img.extent() };
+            zx::mat::convolve(policy, actual.mut_view(), img, kernel, border);
+            EXPECT_THAT(actual, SamePixels(expected)) << policy;
+        }
+    };
+    expect_identical(zx::mat::kernel::gaussian(3.F, 15), zx::mat::border::reflect());
+    expect_identical(zx::mat::kernel::emboss(), zx::mat::border::valid());
+    expect_identical(zx::mat::kernel::prewitt(), zx::mat::border::replicate());
+    expect_identical(zx::mat::kernel::median(zx::mat::mask::square(7)), zx::mat::border::constant(9));
+    expect_identical(zx::mat::kernel::erode(zx::mat::mask::rect({ 9, 3 })), zx::mat::border::wrap());
+}
+
+TEST(image, dirty_region_blocks)
+{
+    zx::mat::dirty_region_t dirty{ { 100, 150 }, 32 };
+    EXPECT_TRUE(dirty.empty());
+    EXPECT_THROW((zx::mat::dirty_region_t{ { 10, 10 }, 0 }), std::invalid_argument);
+
+    dirty.add(zx::mat::bounds_t<2>{ { 10, 20 }, { 40, 50 } });
+    dirty.add(zx::mat::bounds_t<2>{ { -20, -5 }, { 0, 150 } });
+    dirty.add(zx::mat::bounds_t<2>{ { 5, 5 }, { 0, 150 } });
+    EXPECT_FALSE(dirty.empty());
+    EXPECT_THAT(dirty.rectangles(), testing::ElementsAre(zx::mat::bounds_t<2>{ { 0, 32 }, { 32, 64 } }));
+
+    dirty.add(zx::mat::bounds_t<2>{ { 90, 200 }, { 140, 300 } });
+    dirty.add(zx::mat::bounds_t<2>{ { 64, 65 }, { 0, 1 } });
+    EXPECT_THAT(
+        dirty.rows(),
+        testing::ElementsAre(zx::mat::interval_type{ 0, 32 }, zx::mat::interval_type{ 64, 100 }));
+    EXPECT_THAT(
+        dirty.rectangles(),
+        testing::ElementsAre(
+            zx::mat::bounds_t<2>{ { 0, 32 }, { 32, 64 } },
+            zx::mat::bounds_t<2>{ { 64, 96 }, { 0, 32 } },
+            zx::mat::bounds_t<2>{ { 64, 96 }, { 128, 150 } },
+            zx::mat::bounds_t<2>{ { 96, 100 }, { 128, 150 } }));
+
+    dirty.clear();
+    EXPECT_TRUE(dirty.empty());
+    dirty.add_all();
+    EXPECT_THAT(dirty.rows(), testing::ElementsAre(zx::mat::interval_type{ 0, 100 }));
+}
+
+TEST(image, dirty_region_tracks_drawing)
+{
+    auto img = random_image(zx::mat::rgb_image_t::extent_type{ 120, 200 }, 17);
+    const auto red = [](const zx::mat::rgb_color_t&) { return zx::mat::rgb_color_t{ 255.F, 0.F, 0.F }; };
+
+    std::stringstream saved;
+    zx::mat::save_bitmap(img, saved);
+    const auto kernel = zx::mat::kernel::gaussian(1.5F, 7);
+    std::vector<zx::mat::rgb_image_t> blurred;
+    const auto borders = { zx::mat::border::valid(),
+                           zx::mat::border::constant(40),
+                           zx::mat::border::replicate(),
+                           zx::mat::border::reflect(),
+                           zx::mat::border::wrap() };
+    for (const auto& border : borders)
+    {
+        blurred.emplace_back(img.extent());
+        zx::mat::convolve(blurred.back().mut_view(), img, kernel, border);
+    }
+
+    zx::mat::dirty_region_t dirty{ img.extent(), 16 };
+    zx::mat::draw_line(img.mut_view(), zx::mat::segment_type{ { 2, 30 }, { 9, 5 } }, red, dirty);
+    zx::mat::draw_circle(img.mut_view(), zx::mat::circle_type{ { 60, 100 }, 6 }, red, dirty);
+    const zx::mat::rectangle_t<zx::mat::location_base_t> rect{ { 110, 119 }, { 180, 199 } };
+    zx::mat::draw_rectangle(img.mut_view(), rect, red, dirty);
+    zx::mat::rgb_image_t patch{ zx::mat::rgb_image_t::extent_type{ 4, 4 } };
+    zx::mat::paste(img.mut_view(), patch, { 40, -2 }, dirty);
+    EXPECT_THAT(
+        dirty.rectangles(),
+        testing::ElementsAre(
+            zx::mat::bounds_t<2>{ { 0, 16 }, { 0, 32 } },
+            zx::mat::bounds_t<2>{ { 32, 48 }, { 0, 16 } },
+            zx::mat::bounds_t<2>{ { 48, 64 }, { 80, 112 } },
+            zx::mat::bounds_t<2>{ { 64, 80 }, { 80, 112 } },
+            zx::mat::bounds_t<2>{ { 96, 112 }, { 176, 200 } },
+            zx::mat::bounds_t<2>{ { 112, 120 }, { 176, 200 } }));
+
+    std::size_t index = 0;
+    for (const auto& border : borders)
+    {
+        zx::mat::rgb_image_t expected{ img.extent() };
+        zx::mat::convolve(expected.mut_view(), img, kernel, border);
+        zx::mat::convolve(zx::mat::execution::parallel(2), blurred[index].mut_view(), img, kernel, border, dirty);
+        EXPECT_THAT(blurred[index], SamePixels(expected)) << border;
+        ++index;
+    }
+
+    std::stringstream expected_bitmap;
+    zx::mat::save_bitmap(img, expected_bitmap);
+    zx::mat::save_bitmap(img, saved, dirty);
+    EXPECT_THAT(saved.str(), expected_bitmap.str());
+
+    // bitmaps of another extent, or missing rows, are not patched; a file is saved whole instead
+    std::stringstream other;
+    zx::mat::save_bitmap(patch, other);
+    const std::string other_bitmap = other.str();
+    EXPECT_THROW(zx::mat::save_bitmap(img, other, dirty), std::runtime_error);
+    EXPECT_THAT(other.str(), other_bitmap);
+    std::stringstream truncated{ expected_bitmap.str().substr(0, 1000) };
+    EXPECT_THROW(zx::mat::save_bitmap(img, truncated, dirty), std::runtime_error);
+    const zx::mat::filepath_t path{ testing::TempDir() + "dirty_region.bmp" };
+    zx::mat::save_bitmap(patch, path);
+    zx::mat::save_bitmap(img, path, dirty);
+    EXPECT_THAT(zx::mat::load_bitmap(path), SamePixels(img));
+
+    auto inverted = img;
+    zx::mat::modify(inverted.mut_view(), zx::mat::lookup_table::negative(), dirty);
+    EXPECT_THAT((inverted[{ 9, 5 }]), (zx::mat::true_color_t{ 0, 255, 255 }));
+    EXPECT_THAT((inverted[{ 20, 20 }]), (zx::mat::true_color_t{ img[{ 20, 20 }] }));
+    const int green = inverted.channel(1)[{ 65, 90 }];
+    EXPECT_THAT(green, 255 - (img.channel(1)[{ 65, 90 }]));
+}
+
+TEST(image, span_drawing_matches_pixel_drawing)
+{
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 60, 80 }, 23);
+    const auto planar = zx::mat::rgb_image_t{ img, zx::mat::image_layout_t::planar };
+
+    const auto raster = zx::mat::rasterize(zx::mat::circle_type{ { 5, 70 }, 20 })
+                        + zx::mat::rasterize(zx::mat::rectangle_t<zx::mat::location_base_t>{ { 30, 90 }, { -10, 20 } });
+    const auto expect_pixelwise = [&](const auto& filter)
+    {
+        auto expected = img;
+        const auto do_draw = zx::mat::detail::draw_pixel_t{ expected.mut_view(), filter };
+        for (const auto& shape : raster)
+        {
+            zx::mat::draw_raster(shape, do_draw);
+        }
+        for (const auto& source : { img, planar })
+        {
+            auto actual = source;
+            zx::mat::draw_raster(actual.mut_view(), raster, filter);
+            EXPECT_THAT(actual, SamePixels(expected));
+        }
+    };
+    expect_pixelwise(zx::mat::filters::solid(zx::mat::rgb_color_t{ 250.F, 20.5F, 3.F }));
+    expect_pixelwise(zx::mat::filters::solid(zx::mat::rgb_color_t{ 250.F, 20.5F, 3.F }, 0.3F));
+    expect_pixelwise(zx::mat::filters::sepia);
+    expect_pixelwise([](const zx::mat::rgb_color_t& color) { return color * 0.5F; });
+}
+
+TEST(image, fill_shapes_by_scanlines)
+{
+    const zx::mat::rgb_image_t blank{ zx::mat::rgb_image_t::extent_type{ 50, 70 } };
+    const auto red = zx::mat::filters::solid(zx::mat::rgb_color_t{ 255.F, 0.F, 0.F });
+    const auto expect_same_as_raster = [&](const auto& shape)
+    {
+        auto expected = blank;
+        zx::mat::draw_raster(expected.mut_view(), zx::mat::rasterize(shape), red);
+        auto actual = blank;
+        zx::mat::dirty_region_t dirty{ blank.extent(), 8 };
+        zx::mat::fill(actual.mut_view(), shape, red, dirty);
+        EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data())) << shape;
+        EXPECT_FALSE(dirty.empty());
+    };
+    expect_same_as_raster(zx::mat::rectangle_t<zx::mat::location_base_t>{ { -5, 12 }, { 60, 90 } });
+    expect_same_as_raster(zx::mat::circle_type{ { 25, 35 }, 30 });
+    expect_same_as_raster(zx::mat::circle_type{ { 0, 0 }, 0 });
+
+    // an axis-aligned polygon covers its rectangle, edges included only on the upper and left sides
+    const zx::mat::polygon_type square{ { 10, 20 }, { 10, 30 }, { 25, 30 }, { 25, 20 } };
+    auto expected = blank;
+    zx::mat::fill(expected.mut_view(), zx::mat::rectangle_t<zx::mat::location_base_t>{ { 10, 25 }, { 20, 30 } }, red);
+    auto actual = blank;
+    zx::mat::fill(actual.mut_view(), square, red);
+    EXPECT_THAT(actual.data(), testing::ElementsAreArray(expected.data()));
+
+    // even-odd rule: a bow tie leaves its crossing rows split in two spans
+    const zx::mat::polygon_type bow_tie{ { 0, 0 }, { 20, 20 }, { 20, 0 }, { 0, 20 } };
+    const auto shapes = zx::mat::rasterize(bow_tie);
+    ASSERT_THAT(shapes.size(), 2U);
+    std::size_t area = 0;
+    for (const auto& shape : shapes)
+    {
+        for (const auto& [y, spans] : shape)
+        {
+            for (const auto& span : spans)
+            {
+                area += static_cast<std::size_t>(span[1] - span[0]);
+            }
+        }
+    }
+    EXPECT_THAT(area, 200U);
+
+    expect_same_as_raster(bow_tie);
+    expect_same_as_raster(zx::mat::polygon_type{ { -3, 5 }, { 48, 66 }, { 12, 69 }, { 30, 10 }, { 55, -8 } });
+}
+
+TEST(image, outlines_match_pixel_drawing)
+{
+    const auto red = [](const zx::mat::rgb_color_t&) { return zx::mat::rgb_color_t{ 255.F, 0.F, 0.F }; };
+    std::uint32_t state = 5;
+    const auto random = [&](int lower, int upper)
+    {
+        state = state * 1664525U + 1013904223U;
+        return lower + static_cast<int>((state >> 8) % static_cast<std::uint32_t>(upper - lower + 1));
+    };
+
+    for (int i = 0; i < 300; ++i)
+    {
+        zx::mat::rgb_image_t actual{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+        zx::mat::rgb_image_t expected = actual;
+        const auto do_draw = zx::mat::detail::draw_pixel_t{ expected.mut_view(), red };
+
+        const zx::mat::segment_type seg{ { random(-60, 100), random(-60, 110) }, { random(-60, 100), random(-60, 110) } };
+        zx::mat::draw_line(actual.mut_view(), seg, red);
+        zx::mat::draw_line(seg[0], seg[1], do_draw);
+
+        const zx::mat::circle_type circle{ { random(-30, 70), random(-30, 80) }, random(-1, 60) };
+        zx::mat::draw_circle(actual.mut_view(), circle, red);
+        zx::mat::draw_circle(circle.center, circle.radius, do_draw);
+
+        zx::mat::rectangle_t<zx::mat::location_base_t> rect{ { random(-10, 45), 0 }, { random(-10, 55), 0 } };
+        rect[0][1] = rect[0][0] + random(1, 30);
+        rect[1][1] = rect[1][0] + random(1, 30);
+        zx::mat::draw_rectangle(actual.mut_view(), rect, red);
+        for (const auto side : zx::mat::segments(rect))
+        {
+            zx::mat::draw_line(side[0], side[1], do_draw);
+        }
+
+        ASSERT_THAT(actual.data(), testing::ElementsAreArray(expected.data())) << seg << circle << rect;
+    }
+}
+
+TEST(image, thick_and_smooth_strokes)
+{
+    const auto white = zx::mat::filters::solid(zx::mat::rgb_color_t{ 255.F, 255.F, 255.F });
+    const zx::mat::segment_type seg{ { -7, 3 }, { 33, 41 } };
+    const zx::mat::circle_type circle{ { 18, 25 }, 14 };
+
+    // pixels are covered by the part of them within width / 2 of the path, measured from their centers
+    const auto expect_coverage = [&](const zx::mat::stroke_t& pen, const auto& draw, const auto& distance)
+    {
+        zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+        draw(img.mut_view(), pen);
+        const double half = pen.width / 2.0;
+        for (zx::mat::location_base_t y = 0; y < 40; ++y)
+        {
+            for (zx::mat::location_base_t x = 0; x < 50; ++x)
+            {
+                const double d = distance(y, x);
+                const double expected
+                    = 255.0 * (pen.antialiased ? std::clamp(half + 0.5 - d, 0.0, 1.0) : (d <= half ? 1.0 : 0.0));
+                ASSERT_NEAR((img.data()[{ y, x, 0 }]), expected, 1.01) << pen << " " << y << " " << x;
+            }
+        }
+    };
+    const auto line_distance = [&](double y, double x)
+    {
+        const double uy = seg[1][0] - seg[0][0];
+        const double ux = seg[1][1] - seg[0][1];
+        const double t = std::clamp(((y - seg[0][0]) * uy + (x - seg[0][1]) * ux) / (uy * uy + ux * ux), 0.0, 1.0);
+        return std::hypot(y - seg[0][0] - t * uy, x - seg[0][1] - t * ux);
+    };
+    const auto circle_distance = [&](double y, double x)
+    { return std::abs(std::hypot(y - circle.center[0], x - circle.center[1]) - circle.radius); };
+    for (const auto& pen : { zx::mat::stroke::solid(2.F),
+                             zx::mat::stroke::solid(5.5F),
+                             zx::mat::stroke::smooth(1.5F),
+                             zx::mat::stroke::smooth(6.F) })
+    {
+        expect_coverage(
+            pen,
+            [&](const auto& image, const zx::mat::stroke_t& p) { zx::mat::draw_line(image, seg, white, p); },
+            line_distance);
+        expect_coverage(
+            pen,
+            [&](const auto& image, const zx::mat::stroke_t& p) { zx::mat::draw_circle(image, circle, white, p); },
+            circle_distance);
+    }
+    expect_coverage(
+        zx::mat::stroke::smooth(),
+        [&](const auto& image, const zx::mat::stroke_t& p) { zx::mat::draw_circle(image, circle, white, p); },
+        circle_distance);
+
+    // Wu lines split every step between two pixels
+    zx::mat::rgb_image_t img{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+    const auto add = [](const zx::mat::rgb_color_t& color) { return color + zx::mat::rgb_color_t{ 100.F, 100.F, 100.F }; };
+    zx::mat::dirty_region_t dirty{ img.extent(), 8 };
+    zx::mat::draw_line(img.mut_view(), zx::mat::segment_type{ { 3, 2 }, { 20, 47 } }, add, zx::mat::stroke::smooth(), dirty);
+    for (zx::mat::location_base_t x = 0; x < 50; ++x)
+    {
+        int sum = 0;
+        for (zx::mat::location_base_t y = 0; y < 40; ++y)
+        {
+            sum += img.data()[{ y, x, 1 }];
+        }
+        EXPECT_NEAR(sum, x >= 2 && x <= 47 ? 100 : 0, 2) << x;
+    }
+    EXPECT_THAT(dirty.rows(), testing::ElementsAre(zx::mat::interval_type{ 0, 24 }));
+
+    // strokes are clipped before they are walked, without moving the pixels left inside
+    const zx::mat::location_t<2> offset{ 300, 300 };
+    for (const auto& pen : { zx::mat::stroke::solid(), zx::mat::stroke::smooth(), zx::mat::stroke::smooth(3.5F) })
+    {
+        zx::mat::rgb_image_t clipped{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+        zx::mat::rgb_image_t whole{ zx::mat::rgb_image_t::extent_type{ 700, 700 } };
+        const zx::mat::segment_type far{ { -250, -90 }, { 230, 170 } };
+        zx::mat::draw_line(clipped.mut_view(), far, white, pen);
+        zx::mat::draw_line(whole.mut_view(), zx::mat::segment_type{ far[0] + offset, far[1] + offset }, white, pen);
+        const zx::mat::circle_type big{ { 150, -60 }, 170 };
+        zx::mat::draw_circle(clipped.mut_view(), big, white, pen);
+        zx::mat::draw_circle(whole.mut_view(), zx::mat::circle_type{ big.center + offset, big.radius }, white, pen);
+
+        const zx::mat::rgb_image_t window{ whole.view().slice({ { 300, 340 }, { 300, 350 } }) };
+        EXPECT_THAT(clipped.data(), testing::ElementsAreArray(window.data())) << pen;
+    }
+
+    // endpoints far outside of the image overflow neither the slope nor the clip bounds
+    for (const auto& pen : { zx::mat::stroke::solid(), zx::mat::stroke::smooth() })
+    {
+        zx::mat::rgb_image_t flat{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+        zx::mat::draw_line(flat.mut_view(), zx::mat::segment_type{ { -5, -2000000000 }, { 70, 2000000000 } }, white, pen);
+        zx::mat::rgb_image_t diagonal{ zx::mat::rgb_image_t::extent_type{ 40, 50 } };
+        zx::mat::draw_line(
+            diagonal.mut_view(),
+            zx::mat::segment_type{ { -2147483647, -2147483647 }, { 2147483647, 2147483647 } },
+            white,
+            pen);
+        for (zx::mat::location_base_t x = 0; x < 50; ++x)
+        {
+            int flat_sum = 0;
+            int diagonal_sum = 0;
+            for (zx::mat::location_base_t y = 0; y < 40; ++y)
+            {
+                flat_sum += flat.data()[{ y, x, 1 }];
+                diagonal_sum += diagonal.data()[{ y, x, 1 }];
+            }
+            const int middle = flat.data()[{ 32, x, 1 }] + flat.data()[{ 33, x, 1 }];
+            EXPECT_NEAR(flat_sum, 255, 2) << x << " " << pen;
+            EXPECT_NEAR(middle, 255, 2) << x << " " << pen;
+            EXPECT_THAT(diagonal_sum, x < 40 ? 255 : 0) << x << " " << pen;
+            if (x < 40)
+            {
+                EXPECT_THAT((diagonal.data()[{ x, x, 1 }]), 255) << x << " " << pen;
+            }
+        }
+    }
+}
@@ -0,0 +1,119 @@
+#include <gmock/gmock.h>
+
+#include <zx/interop.hpp>
+
+#include "random_image.hpp"
+
+TEST(interop, wrap_padded_bgr_buffer)
+{
+    // 2 x 3 pixels, 3 bytes per pixel, rows padded to 12 bytes
+    std::vector<zx::mat::byte_t> buffer = {
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0,  //
+        10, 20, 30, 40, 50, 60, 70, 80, 90, 0, 0, 0,
+    };
+    const auto layout = zx::mat::buffer_layout::interleaved(2, 3, 3, 12, zx::mat::channel_order_t::bgr);
+
+    const auto view = zx::mat::wrap_image(static_cast<const zx::mat::byte_t*>(buffer.data()), layout);
+    EXPECT_THAT(view.extent(), (zx::mat::rgb_image_t::extent_type{ 2, 3 }));
+    EXPECT_THAT((view[{ 0, 0 }]), (zx::mat::true_color_t{ 3, 2, 1 }));
+    EXPECT_THAT((view[{ 1, 2 }]), (zx::mat::true_color_t{ 90, 80, 70 }));
+    EXPECT_THAT(view.channel(0), testing::ElementsAre(3, 6, 9, 30, 60, 90));
+
+    const auto mut_view = zx::mat::wrap_image(buffer.data(), layout);
+    mut_view[{ 1, 1 }] = zx::mat::true_color_t{ 100, 101, 102 };
+    EXPECT_THAT(
+        buffer,
+        testing::ElementsAre(1, 2, 3, 4, 5, 6, 7, 8, 9, 0, 0, 0, 10, 20, 30, 102, 101, 100, 70, 80, 90, 0, 0, 0));
+
+    EXPECT_THAT(
+        zx::mat::rgb_image_t{ view }.data(),
+        testing::ElementsAre(3, 2, 1, 6, 5, 4, 9, 8, 7, 30, 20, 10, 100, 101, 102, 90, 80, 70));
+}
+
+TEST(interop, wrap_planar_buffer)
+{
+    std::vector<zx::mat::byte_t> buffer(3 * 2 * 2);
+    std::iota(buffer.begin(), buffer.end(), zx::mat::byte_t{ 0 });
+
+    const auto view = zx::mat::wrap_image(buffer.data(), zx::mat::buffer_layout::planar(2, 2, 3));
+    EXPECT_THAT((view[{ 0, 1 }]), (zx::mat::true_color_t{ 1, 5, 9 }));
+    EXPECT_THAT((view[{ 1, 0 }]), (zx::mat::true_color_t{ 2, 6, 10 }));
+    EXPECT_THAT(view.channel(2).shape().stride(), (zx::mat::stride_t<2>{ 2, 1 }));
+}
+
+TEST(interop, wrap_single_channel_buffer)
+{
+    std::vector<float> buffer = { 1.F, 2.F, 3.F, -1.F, 4.F, 5.F, 6.F, -1.F };
+    const auto view = zx::mat::wrap(static_cast<const float*>(buffer.data()), { 2, 3 }, 4 * sizeof(float));
+    EXPECT_THAT(view, testing::ElementsAre(1.F, 2.F, 3.F, 4.F, 5.F, 6.F));
+    EXPECT_THAT(zx::mat::reduce::sum(view), 21.0);
+
+    EXPECT_THAT(zx::mat::buffer_layout::of(view), (zx::mat::buffer_layout_t{ 2, 3, 1, 16, 4, 4 }));
+}
+
+TEST(interop, wrap_rejects_invalid_layouts)
+{
+    std::vector<float> buffer(16);
+    EXPECT_THROW(zx::mat::wrap(buffer.data(), zx::mat::buffer_layout::interleaved(2, 2, 3)), std::invalid_argument);
+    EXPECT_THROW(zx::mat::wrap(buffer.data(), zx::mat::buffer_layout::interleaved<float>(-1, 2, 3)), std::invalid_argument);
+    EXPECT_THROW(
+        zx::mat::wrap(static_cast<float*>(nullptr), zx::mat::buffer_layout::interleaved<float>(2, 2, 3)),
+        std::invalid_argument);
+    EXPECT_THROW(
+        zx::mat::wrap_image(static_cast<zx::mat::byte_t*>(nullptr), zx::mat::buffer_layout::interleaved(2, 2, 4)),
+        std::invalid_argument);
+
+    // 4 channels keep their order in memory; reversing them would put alpha first
+    std::vector<zx::mat::byte_t> rgba = { 1, 2, 3, 255, 4, 5, 6, 128 };
+    EXPECT_THAT(
+        zx::mat::wrap(rgba.data(), zx::mat::buffer_layout::interleaved(1, 2, 4)),
+        testing::ElementsAre(1, 2, 3, 255, 4, 5, 6, 128));
+    EXPECT_THROW(
+        zx::mat::wrap(rgba.data(), zx::mat::buffer_layout::interleaved(1, 2, 4, 0, zx::mat::channel_order_t::bgr)),
+        std::invalid_argument);
+}
+
+TEST(interop, share_hands_out_storage_without_copying)
+{
+    zx::mat::rgb_image_t image{ zx::mat::rgb_image_t::extent_type{ 4, 5 } };
+    image[{ 2, 3 }] = zx::mat::true_color_t{ 7, 8, 9 };
+    const zx::mat::byte_t* storage = image.data().data();
+
+    std::shared_ptr<zx::mat::byte_t> owner;
+    zx::mat::buffer_layout_t layout;
+    {
+        const auto shared = zx::mat::share(std::move(image));
+        EXPECT_THAT(shared.data(), storage);
+        owner = shared.owner();
+        layout = zx::mat::buffer_layout::of(shared.view());
+    }
+
+    EXPECT_THAT(owner.get(), storage);
+    EXPECT_THAT(layout, zx::mat::buffer_layout::interleaved(4, 5, 3));
+    EXPECT_THAT((zx::mat::wrap_image(owner.get(), layout)[{ 2, 3 }]), (zx::mat::true_color_t{ 7, 8, 9 }));
+}
+
+TEST(interop, map_bitmap_without_decoding)
+{
+    const zx::mat::filepath_t sample{ std::string(TEST_DATA_DIR) + "/test-24.bmp" };
+    const auto mapped = zx::mat::map_bitmap(sample);
+    const auto loaded = zx::mat::load_bitmap(sample);
+    EXPECT_THAT(mapped.extent(), loaded.extent());
+    EXPECT_THAT(mapped.view().data(), testing::ElementsAreArray(loaded.data()));
+    EXPECT_THAT(mapped.view().data().shape().dim(0).stride, -24);
+    EXPECT_THAT(mapped.view().data().shape().dim(2).stride, -1);
+
+    const auto img = random_image(zx::mat::rgb_image_t::extent_type{ 3, 5 }, 1);
+    const zx::mat::filepath_t path{ testing::TempDir() + "map_bitmap.bmp" };
+    zx::mat::save_bitmap(img, path);
+
+    std::optional<zx::mat::mapped_bitmap_t> copy;
+    {
+        const auto saved = zx::mat::map_bitmap(path);
+        copy = saved;
+    }
+    EXPECT_THAT(copy->view().data(), testing::ElementsAreArray(img.data()));
+
+    EXPECT_THROW(zx::mat::map_bitmap(zx::mat::filepath_t{ testing::TempDir() + "missing.bmp" }), std::runtime_error);
+    std::remove(path.c_str());
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <zx/format.hpp>
+#include <zx/image.hpp>
 #include <zx/mat.hpp>
 #include <zx/test/functional_matcher.hpp>
 
@@ -113,6 +114,61 @@ struct ApproxEqualFn
     };
 };
 
+struct SamePixelsFn
+{
+    // tolerance - the largest difference allowed between two channel values
+    auto operator()(const zx::mat::rgb_image_t& expected, int tolerance = 0) const
+    {
+        return zx::test::FunctionalMatcher{ Comparer{ tolerance }, Formatter{ tolerance }, expected };
+    }
+
+    struct Formatter
+    {
+        int m_tolerance = 0;
+
+        void operator()(std::ostream& os, bool positive, const zx::mat::rgb_image_t& e) const
+        {
+            os << (positive ? "has" : "does not have") << " the pixels of an image of extent " << e.extent();
+            if (m_tolerance > 0)
+            {
+                os << " within " << m_tolerance;
+            }
+        }
+    };
+
+    struct Comparer
+    {
+        int m_tolerance = 0;
+
+        auto operator()(const zx::mat::rgb_image_t& actual, const zx::mat::rgb_image_t& expected) const
+            -> std::optional<std::string>
+        {
+            if (actual.extent() != expected.extent())
+            {
+                return zx::format("extent ", actual.extent());
+            }
+            for (std::size_t z = 0; z < 3; ++z)
+            {
+                for (zx::mat::location_base_t y = 0; y < actual.extent()[0]; ++y)
+                {
+                    for (zx::mat::location_base_t x = 0; x < actual.extent()[1]; ++x)
+                    {
+                        const int a = actual.channel(z)[{ y, x }];
+                        const int e = expected.channel(z)[{ y, x }];
+                        if (std::abs(a - e) > m_tolerance)
+                        {
+                            return zx::format("at (", y, ", ", x, ", ", z, "): expected ", e, ", actual ", a);
+                        }
+                    }
+                }
+            }
+
+            return std::nullopt;
+        }
+    };
+};
+
 }  // namespace detail
 
 constexpr inline auto ApproxEqual = detail::ApproxEqualFn{};
+constexpr inline auto SamePixels = detail::SamePixelsFn{};
@@ -0,0 +1,165 @@
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <mutex>
+#include <zx/image.hpp>
+
+namespace
+{
+
+zx::mat::rgb_image_t make_gradient(const zx::mat::rgb_image_t::extent_type& extent)
+{
+    zx::mat::rgb_image_t result{ extent };
+    zx::mat::detail::for_each(
+        result.data().shape(),
+        [&](const zx::mat::location_t<2>& loc)
+        {
+            result[loc] = zx::mat::true_color_t{ static_cast<zx::mat::byte_t>(loc[0] * 7 + loc[1]),
+                                                 static_cast<zx::mat::byte_t>(loc[1] * 3),
+                                                 static_cast<zx::mat::byte_t>(loc[0] ^ loc[1]) };
+        });
+    return result;
+}
+
+std::vector<zx::mat::byte_t> to_bytes(const zx::mat::rgb_image_t& image)
+{
+    return std::vector<zx::mat::byte_t>(image.data().begin(), image.data().end());
+}
+
+}  // namespace
+
+TEST(parallel, thread_pool_runs_every_task_once)
+{
+    zx::mat::thread_pool_t pool{ 3 };
+    EXPECT_THAT(pool.concurrency(), 4);
+
+    for (int repeat = 0; repeat < 20; ++repeat)
+    {
+        std::vector<std::atomic<int>> counts(257);
+        pool.run(counts.size(), 4, [&](std::size_t index) { counts[index] += 1; });
+        EXPECT_TRUE(std::all_of(counts.begin(), counts.end(), [](const std::atomic<int>& v) { return v == 1; }));
+    }
+}
+
+TEST(parallel, thread_pool_respects_max_concurrency)
+{
+    zx::mat::thread_pool_t pool{ 3 };
+    std::mutex mutex;
+    std::vector<std::thread::id> ids;
+    pool.run(
+        64,
+        2,
+        [&](std::size_t)
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            if (std::find(ids.begin(), ids.end(), std::this_thread::get_id()) == ids.end())
+            {
+                ids.push_back(std::this_thread::get_id());
+            }
+        });
+    EXPECT_THAT(ids.size(), testing::Le(2U));
+}
+
+TEST(parallel, thread_pool_propagates_exceptions)
+{
+    zx::mat::thread_pool_t pool{ 3 };
+    EXPECT_THROW(
+        pool.run(
+            100,
+            4,
+            [&](std::size_t index)
+            {
+                if (index == 42)
+                {
+                    throw std::runtime_error{ "failure" };
+                }
+            }),
+        std::runtime_error);
+
+    std::atomic<int> count = 0;
+    pool.run(10, 4, [&](std::size_t) { ++count; });
+    EXPECT_THAT(count.load(), 10);
+}
+
+TEST(parallel, for_each_visits_every_location_once)
+{
+    zx::mat::array_t<int, 2> counts{ { 37, 53 } };
+    std::mutex mutex;
+    zx::mat::detail::for_each(
+        zx::mat::execution::parallel(),
+        counts.shape(),
+        [&](const zx::mat::location_t<2>& loc)
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            counts[loc] += 1;
+        });
+    EXPECT_THAT(counts, testing::Each(1));
+}
+
+TEST(parallel, deterministic_bands_do_not_depend_on_thread_count)
+{
+    const auto collect_bands = [](const zx::mat::execution_t& policy)
+    {
+        std::mutex mutex;
+        std::vector<std::pair<zx::mat::location_base_t, zx::mat::location_base_t>> result;
+        zx::mat::detail::for_each_band(
+            policy,
+            100,
+            [&](zx::mat::location_base_t first, zx::mat::location_base_t last)
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                result.emplace_back(first, last);
+            });
+        std::sort(result.begin(), result.end());
+        return result;
+    };
+
+    const auto single = collect_bands(zx::mat::execution::deterministic(1, 16));
+    const auto multi = collect_bands(zx::mat::execution::deterministic(0, 16));
+    EXPECT_THAT(single, testing::SizeIs(7));
+    EXPECT_THAT(single.back(), testing::Pair(96, 100));
+    EXPECT_THAT(multi, testing::ElementsAreArray(single));
+}
+
+TEST(parallel, exceptions_are_propagated_to_the_caller)
+{
+    zx::mat::array_t<int, 2> values{ { 64, 4 } };
+    EXPECT_THROW(
+        zx::mat::detail::for_each(
+            zx::mat::execution::parallel(),
+            values.shape(),
+            [&](const zx::mat::location_t<2>& loc)
+            {
+                if (loc[0] == 40)
+                {
+                    throw std::runtime_error{ "failure" };
+                }
+            }),
+        std::runtime_error);
+}
+
+TEST(parallel, image_operations_match_sequential_results)
+{
+    const auto src = make_gradient({ 61, 47 });
+
+    for (const auto& policy : { zx::mat::execution::parallel(), zx::mat::execution::deterministic(3, 5) })
+    {
+        EXPECT_THAT(
+            to_bytes(zx::mat::with(src, [&](auto v) { zx::mat::modify(policy, v, zx::mat::filters::sepia); })),
+            testing::ElementsAreArray(
+                to_bytes(zx::mat::with(src, [&](auto v) { zx::mat::modify(v, zx::mat::filters::sepia); }))));
+
+        EXPECT_THAT(
+            to_bytes(zx::mat::with(
+                src,
+                [&](auto v) { zx::mat::paste(policy, v, make_gradient({ 20, 30 }), { 5, 25 }, zx::mat::filters::screen); })),
+            testing::ElementsAreArray(to_bytes(zx::mat::with(
+                src, [&](auto v) { zx::mat::paste(v, make_gradient({ 20, 30 }), { 5, 25 }, zx::mat::filters::screen); }))));
+
+        EXPECT_THAT(
+            to_bytes(zx::mat::with(
+                src, [&](auto v) { zx::mat::convolve(policy, v, zx::mat::kernel::median(zx::mat::mask::square(3))); })),
+            testing::ElementsAreArray(to_bytes(zx::mat::with(
+                src, [&](auto v) { zx::mat::convolve(v, zx::mat::kernel::median(zx::mat::mask::square(3))); }))));
+    }
+}
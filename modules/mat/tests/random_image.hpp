@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <zx/image.hpp>
+
+// Bytes of a linear congruential generator; the same seed gives the same image.
+inline zx::mat::rgb_image_t random_image(const zx::mat::rgb_image_t::extent_type& extent, std::uint32_t seed)
+{
+    zx::mat::rgb_image_t result{ extent };
+    for (auto& value : result.mut_view().data())
+    {
+        seed = seed * 1664525U + 1013904223U;
+        value = static_cast<zx::mat::byte_t>(seed >> 24);
+    }
+    return result;
+}
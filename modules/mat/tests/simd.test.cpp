@@ -0,0 +1,222 @@
+#include <gmock/gmock.h>
+
+#include <limits>
+
+#include <zx/simd.hpp>
+
+namespace
+{
+
+std::vector<zx::mat::simd_isa_t> supported_isas()
+{
+    std::vector<zx::mat::simd_isa_t> result;
+    for (const auto isa : { zx::mat::simd_isa_t::scalar, zx::mat::simd_isa_t::sse2, zx::mat::simd_isa_t::avx2 })
+    {
+        if (zx::mat::detail::simd::is_supported(isa))
+        {
+            result.push_back(isa);
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(simd, dispatch_selects_a_supported_isa)
+{
+    EXPECT_TRUE(zx::mat::detail::simd::is_supported(zx::mat::simd_isa()));
+    EXPECT_THAT(zx::mat::detail::simd::kernels(zx::mat::simd_isa()).isa, zx::mat::simd_isa());
+}
+
+TEST(simd, kernels_match_scalar_results)
+{
+    const auto& reference = zx::mat::detail::simd::kernels(zx::mat::simd_isa_t::scalar);
+
+    std::vector<float> floats(203);
+    std::vector<std::uint8_t> bytes(2053);
+    for (std::size_t i = 0; i < floats.size(); ++i)
+    {
+        floats[i] = static_cast<float>((i * 37) % 101) - 50.F;
+    }
+    for (std::size_t i = 0; i < bytes.size(); ++i)
+    {
+        bytes[i] = static_cast<std::uint8_t>((i * 97 + 13) % 251);
+    }
+
+    for (const auto isa : supported_isas())
+    {
+        SCOPED_TRACE(testing::PrintToString(isa));
+        const auto& kernels = zx::mat::detail::simd::kernels(isa);
+
+        for (const std::size_t n : { std::size_t{ 1 }, std::size_t{ 7 }, std::size_t{ 33 }, floats.size() - 2 })
+        {
+            EXPECT_THAT(kernels.sum_f32(floats.data(), n), reference.sum_f32(floats.data(), n));
+            EXPECT_THAT(kernels.minmax_f32(floats.data() + 1, n), reference.minmax_f32(floats.data() + 1, n));
+            EXPECT_THAT(
+                kernels.dot_f32(floats.data(), floats.data() + 2, n),
+                reference.dot_f32(floats.data(), floats.data() + 2, n));
+        }
+
+        for (const std::size_t n : { std::size_t{ 1 }, std::size_t{ 15 }, std::size_t{ 100 }, bytes.size() - 1 })
+        {
+            EXPECT_THAT(kernels.sum_u8(bytes.data(), n), reference.sum_u8(bytes.data(), n));
+            EXPECT_THAT(kernels.minmax_u8(bytes.data() + 1, n), reference.minmax_u8(bytes.data() + 1, n));
+
+            std::array<std::uint64_t, 256> actual = {};
+            std::array<std::uint64_t, 256> expected = {};
+            kernels.histogram_u8(bytes.data(), n, actual.data());
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                ++expected[bytes[i]];
+            }
+            EXPECT_THAT(actual, testing::ElementsAreArray(expected));
+        }
+
+        for (const std::size_t n : { std::size_t{ 1 }, std::size_t{ 5 }, std::size_t{ 6 }, std::size_t{ 101 } })
+        {
+            std::vector<std::uint8_t> actual(3 * n);
+            std::vector<std::uint8_t> expected(3 * n);
+            kernels.swap_rb_u8(bytes.data(), actual.data(), n);
+            reference.swap_rb_u8(bytes.data(), expected.data(), n);
+            EXPECT_THAT(actual, testing::ElementsAreArray(expected));
+            EXPECT_THAT(expected[0], bytes[2]);
+
+            std::vector<std::uint8_t> in_place(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(3 * n));
+            kernels.swap_rb_u8(in_place.data(), in_place.data(), n);
+            EXPECT_THAT(in_place, testing::ElementsAreArray(expected));
+        }
+    }
+}
+
+TEST(simd, blend_kernels_match_scalar_results)
+{
+    const auto& reference = zx::mat::detail::simd::kernels(zx::mat::simd_isa_t::scalar);
+
+    // every pair of bytes, with a length that leaves a tail
+    std::vector<std::uint8_t> dst(256 * 256 + 7);
+    std::vector<std::uint8_t> src(dst.size());
+    for (std::size_t i = 0; i < dst.size(); ++i)
+    {
+        dst[i] = static_cast<std::uint8_t>(i / 256);
+        src[i] = static_cast<std::uint8_t>(i % 256);
+    }
+
+    std::vector<std::uint8_t> expected = dst;
+    reference.multiply_u8(expected.data(), src.data(), expected.size());
+    EXPECT_THAT(expected[200 * 256 + 100], 200 * 100 / 255);
+
+    for (const auto isa : supported_isas())
+    {
+        SCOPED_TRACE(testing::PrintToString(isa));
+        const auto& kernels = zx::mat::detail::simd::kernels(isa);
+        for (const auto kernel : { &zx::mat::detail::simd::kernels_t::multiply_u8,
+                                   &zx::mat::detail::simd::kernels_t::screen_u8,
+                                   &zx::mat::detail::simd::kernels_t::overlay_u8 })
+        {
+            std::vector<std::uint8_t> actual = dst;
+            expected = dst;
+            (kernels.*kernel)(actual.data(), src.data(), actual.size());
+            (reference.*kernel)(expected.data(), src.data(), expected.size());
+            EXPECT_THAT(actual, testing::ElementsAreArray(expected));
+        }
+
+        std::vector<float> floats(1000);
+        for (std::size_t i = 0; i < floats.size(); ++i)
+        {
+            floats[i] = static_cast<float>(i) * 0.37F - 60.F;
+        }
+        // in the vector body and in the scalar tail
+        floats[3] = std::numeric_limits<float>::quiet_NaN();
+        floats[997] = -std::numeric_limits<float>::quiet_NaN();
+        std::vector<std::uint8_t> narrowed(floats.size());
+        std::vector<std::uint8_t> expected_narrowed(floats.size());
+        kernels.narrow_f32_u8(floats.data(), narrowed.data(), floats.size());
+        reference.narrow_f32_u8(floats.data(), expected_narrowed.data(), floats.size());
+        EXPECT_THAT(narrowed, testing::ElementsAreArray(expected_narrowed));
+        EXPECT_THAT(narrowed[3], 0);
+        EXPECT_THAT(narrowed[997], 0);
+
+        std::vector<float> widened(src.size());
+        kernels.widen_u8_f32(src.data(), widened.data(), widened.size());
+        EXPECT_THAT(widened, testing::ElementsAreArray(src));
+
+        for (const std::ptrdiff_t src_stride : { std::ptrdiff_t{ 11 }, std::ptrdiff_t{ -9 } })
+        {
+            std::array<std::uint8_t, 8 * 12> block = {};
+            std::array<std::uint8_t, 8 * 12> expected_block = {};
+            const std::uint8_t* origin = src.data() + 100;
+            kernels.transpose_8x8_u8(origin, src_stride, block.data() + 2, 12);
+            reference.transpose_8x8_u8(origin, src_stride, expected_block.data() + 2, 12);
+            EXPECT_THAT(block, testing::ElementsAreArray(expected_block));
+            EXPECT_THAT(block[2 + 3 * 12 + 5], origin[5 * src_stride + 3]);
+        }
+
+        for (const std::int16_t coefficient : { std::int16_t{ -12345 }, std::int16_t{ 16384 } })
+        {
+            std::vector<std::int32_t> acc(1003, 7);
+            std::vector<std::int32_t> expected_acc = acc;
+            kernels.accumulate_u8(acc.data(), src.data(), acc.size(), coefficient);
+            reference.accumulate_u8(expected_acc.data(), src.data(), expected_acc.size(), coefficient);
+            EXPECT_THAT(acc, testing::ElementsAreArray(expected_acc));
+        }
+
+        std::vector<std::uint32_t> above(1003);
+        for (std::size_t i = 0; i < above.size(); ++i)
+        {
+            above[i] = 0xFFFFF000U + static_cast<std::uint32_t>(i * 3);
+        }
+        std::vector<std::uint32_t> sums(above.size());
+        std::vector<std::uint32_t> expected_sums(above.size());
+        kernels.integral_u8(src.data(), above.data(), sums.data(), sums.size());
+        reference.integral_u8(src.data(), above.data(), expected_sums.data(), expected_sums.size());
+        EXPECT_THAT(sums, testing::ElementsAreArray(expected_sums));
+        EXPECT_THAT(expected_sums[1], above[1] + src[0] + src[1]);
+        kernels.integral_u8(src.data(), above.data(), above.data(), above.size());
+        EXPECT_THAT(above, testing::ElementsAreArray(expected_sums));
+
+        for (const float alpha : { 0.F, 0.3F, 1.F, 1.5F })
+        {
+            std::vector<std::uint8_t> actual = dst;
+            expected = dst;
+            kernels.lerp_u8(actual.data(), src.data(), actual.size(), alpha);
+            reference.lerp_u8(expected.data(), src.data(), expected.size(), alpha);
+            EXPECT_THAT(actual, testing::ElementsAreArray(expected)) << alpha;
+        }
+    }
+}
+
+TEST(simd, color_matrix_kernels_match_scalar_results)
+{
+    const auto& reference = zx::mat::detail::simd::kernels(zx::mat::simd_isa_t::scalar);
+    const std::array<float, 12> matrix = { 0.393F, 0.769F, 0.189F, 0.F,    0.349F, -0.686F,
+                                           0.168F, 12.5F,  0.272F, 0.534F, 1.131F, -3.F };
+
+    // a pixel count that leaves a tail after the vector body and after the byte chunks
+    std::vector<float> floats(3 * 203);
+    std::vector<std::uint8_t> bytes(floats.size());
+    for (std::size_t i = 0; i < floats.size(); ++i)
+    {
+        floats[i] = static_cast<float>(i % 97) * 2.7F - 20.F;
+        bytes[i] = static_cast<std::uint8_t>((i * 37) % 256);
+    }
+
+    std::vector<float> expected_floats = floats;
+    reference.color_matrix_f32(expected_floats.data(), 203, matrix.data());
+    EXPECT_THAT(expected_floats[4], matrix[4] * floats[3] + matrix[5] * floats[4] + matrix[6] * floats[5] + matrix[7]);
+    std::vector<std::uint8_t> expected_bytes = bytes;
+    reference.color_matrix_u8(expected_bytes.data(), 203, matrix.data());
+
+    for (const auto isa : supported_isas())
+    {
+        SCOPED_TRACE(testing::PrintToString(isa));
+        const auto& kernels = zx::mat::detail::simd::kernels(isa);
+
+        std::vector<float> actual_floats = floats;
+        kernels.color_matrix_f32(actual_floats.data(), 203, matrix.data());
+        EXPECT_THAT(actual_floats, testing::ElementsAreArray(expected_floats));
+
+        std::vector<std::uint8_t> actual_bytes = bytes;
+        kernels.color_matrix_u8(actual_bytes.data(), 203, matrix.data());
+        EXPECT_THAT(actual_bytes, testing::ElementsAreArray(expected_bytes));
+    }
+}